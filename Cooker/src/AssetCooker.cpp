@@ -0,0 +1,389 @@
+#include "AssetCooker.h"
+
+#include "GL/glew.h"
+
+#include "CookedAsset.h"
+#include "DecodedImage.h"
+#include "PackFile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	std::mutex s_OutputMutex;
+
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	template<typename T>
+	void Append(std::vector<unsigned char>& output, const T& value)
+	{
+		const unsigned char* bytes = (const unsigned char*)&value;
+		output.insert(output.end(), bytes, bytes + sizeof(T));
+	}
+
+	// Keeps text up to the next comment, inComment carries a /* */ block over to the next lines
+	std::string StripComments(const std::string& line, bool& inComment)
+	{
+		std::string result;
+		size_t i = 0;
+		while (i < line.size())
+		{
+			if (inComment)
+			{
+				const size_t end = line.find("*/", i);
+				if (end == std::string::npos)
+				{
+					return result;
+				}
+				inComment = false;
+				i = end + 2;
+				// a block comment still separates tokens
+				result += ' ';
+				continue;
+			}
+			const size_t lineComment = line.find("//", i);
+			const size_t blockComment = line.find("/*", i);
+			if (lineComment == std::string::npos && blockComment == std::string::npos)
+			{
+				result += line.substr(i);
+				return result;
+			}
+			if (blockComment == std::string::npos || (lineComment != std::string::npos && lineComment < blockComment))
+			{
+				result += line.substr(i, lineComment - i);
+				return result;
+			}
+			result += line.substr(i, blockComment - i);
+			inComment = true;
+			i = blockComment + 2;
+		}
+		return result;
+	}
+}
+
+AssetCooker::AssetKind AssetCooker::GetKind(const std::string& filepath)
+{
+	std::string extension = fs::path(filepath).extension().string();
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+	{
+		return (char)std::tolower(c);
+	});
+
+	static const char* textures[] = { ".png", ".jpg", ".jpeg", ".bmp", ".tga", ".psd", ".gif", ".hdr", ".pic", ".pnm",
+		".ppm", ".pgm", ".qoi" };
+	for (const char* texture : textures)
+	{
+		if (extension == texture)
+		{
+			return AssetKind::Texture;
+		}
+	}
+	return extension == ".shader" ? AssetKind::Shader : AssetKind::Other;
+}
+
+bool AssetCooker::CookTexture(const std::vector<unsigned char>& source, uint64_t sourceHash,
+	TextureCompression compression, std::vector<unsigned char>& cooked)
+{
+	DecodedImage image(source.data(), source.size());
+	if (!image.Pixels)
+	{
+		return false;
+	}
+	// the block encoder only takes 8 bit pixels
+	if (image.Type != GL_UNSIGNED_BYTE)
+	{
+		compression = TextureCompression::None;
+	}
+
+	CookedTextureHeader header = {};
+	std::memcpy(header.Magic, "CTEX", 4);
+	header.Version = CookedAsset::Version;
+	header.Width = (uint32_t)image.Width;
+	header.Height = (uint32_t)image.Height;
+	header.Channels = (uint32_t)image.Channels;
+	header.Type = image.Type;
+	header.Compression = (uint32_t)compression;
+	header.SourceHash = sourceHash;
+	const std::vector<unsigned char> average = DecodedImage::ComputeAverage(image.Pixels, image.Width, image.Height,
+		image.Channels, image.Type);
+	std::memcpy(header.AverageTexel, average.data(), std::min(average.size(), sizeof(header.AverageTexel)));
+
+	// every level is filtered from the previous one, like the runtime downgrades do
+	std::vector<CookedTextureLevel> levels;
+	std::vector<std::vector<unsigned char>> data;
+	std::vector<unsigned char> pixels;
+	const unsigned char* current = image.Pixels;
+	int width = image.Width, height = image.Height;
+	while (true)
+	{
+		CookedTextureLevel level = {};
+		level.Width = (uint32_t)width;
+		level.Height = (uint32_t)height;
+		levels.push_back(level);
+		if (compression != TextureCompression::None)
+		{
+			// the jobs already keep every core busy
+			data.push_back(TextureCompressor::CompressPixels(current, width, height, image.Channels, compression, 1));
+		}
+		else
+		{
+			data.emplace_back(current, current + (size_t)width * height * image.Channels
+				* DecodedImage::GetComponentSize(image.Type));
+		}
+
+		if (width == 1 && height == 1)
+		{
+			break;
+		}
+		pixels = DecodedImage::Halve(current, width, height, image.Channels, image.Type);
+		current = pixels.data();
+		width = DecodedImage::GetLevelDimension(width, 1);
+		height = DecodedImage::GetLevelDimension(height, 1);
+	}
+	header.LevelCount = (uint32_t)levels.size();
+
+	size_t offset = sizeof(header) + levels.size() * sizeof(CookedTextureLevel);
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		offset = AlignUp(offset, 16);
+		levels[i].Offset = offset;
+		levels[i].Size = data[i].size();
+		offset += data[i].size();
+	}
+
+	cooked.clear();
+	cooked.reserve(offset);
+	Append(cooked, header);
+	for (const CookedTextureLevel& level : levels)
+	{
+		Append(cooked, level);
+	}
+	for (size_t i = 0; i < levels.size(); ++i)
+	{
+		cooked.resize((size_t)levels[i].Offset, 0);
+		cooked.insert(cooked.end(), data[i].begin(), data[i].end());
+	}
+	return true;
+}
+
+bool AssetCooker::CookShader(const std::vector<unsigned char>& source, uint64_t sourceHash,
+	std::vector<unsigned char>& cooked)
+{
+	std::string vertex, fragment;
+	PreprocessShader(std::string(source.begin(), source.end()), vertex, fragment);
+	if (vertex.empty() || fragment.empty())
+	{
+		return false;
+	}
+
+	CookedShaderHeader header = {};
+	std::memcpy(header.Magic, "CSHD", 4);
+	header.Version = CookedAsset::Version;
+	header.VertexSize = (uint32_t)vertex.size();
+	header.FragmentSize = (uint32_t)fragment.size();
+	header.SourceHash = sourceHash;
+
+	cooked.clear();
+	Append(cooked, header);
+	cooked.insert(cooked.end(), vertex.begin(), vertex.end());
+	cooked.insert(cooked.end(), fragment.begin(), fragment.end());
+	return true;
+}
+
+void AssetCooker::PreprocessShader(const std::string& source, std::string& vertex, std::string& fragment)
+{
+	std::string* stage = nullptr;
+	bool inComment = false;
+	size_t start = 0;
+	while (start < source.size())
+	{
+		size_t end = source.find('\n', start);
+		if (end == std::string::npos)
+		{
+			end = source.size();
+		}
+		const std::string line = source.substr(start, end - start);
+		start = end + 1;
+
+		if (!inComment && line.find("#shader") != std::string::npos)
+		{
+			if (line.find("vertex") != std::string::npos)
+			{
+				stage = &vertex;
+			}
+			else if (line.find("fragment") != std::string::npos)
+			{
+				stage = &fragment;
+			}
+			continue;
+		}
+
+		std::string text = StripComments(line, inComment);
+		while (!text.empty() && std::isspace((unsigned char)text.back()))
+		{
+			text.pop_back();
+		}
+		if (stage && !text.empty())
+		{
+			*stage += text;
+			*stage += '\n';
+		}
+	}
+}
+
+bool AssetCooker::IsUpToDate(const std::string& destination, AssetKind kind, uint64_t sourceHash,
+	TextureCompression compression)
+{
+	std::ifstream file(destination, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	if (kind == AssetKind::Texture)
+	{
+		CookedTextureHeader header;
+		return file.read((char*)&header, sizeof(header)) && std::memcmp(header.Magic, "CTEX", 4) == 0
+			&& header.Version == CookedAsset::Version && header.SourceHash == sourceHash
+			&& (header.Compression == (uint32_t)compression || header.Type != GL_UNSIGNED_BYTE);
+	}
+	if (kind == AssetKind::Shader)
+	{
+		CookedShaderHeader header;
+		return file.read((char*)&header, sizeof(header)) && std::memcmp(header.Magic, "CSHD", 4) == 0
+			&& header.Version == CookedAsset::Version && header.SourceHash == sourceHash;
+	}
+
+	// plain copies have no header, compare the bytes' hash
+	const std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	return PackFile::Hash(bytes.data(), bytes.size()) == sourceHash;
+}
+
+AssetCooker::JobResult AssetCooker::CookJob(const AssetCookJob& job, AssetKind kind, const AssetCookerSettings& settings)
+{
+	std::ifstream file(job.Source, std::ios::binary);
+	if (!file)
+	{
+		return JobResult::Failed;
+	}
+	std::vector<unsigned char> source((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	const uint64_t hash = PackFile::Hash(source.data(), source.size());
+	const TextureCompression compression = kind == AssetKind::Texture ? settings.Compression : TextureCompression::None;
+	if (!settings.Force && IsUpToDate(job.Destination, kind, hash, compression))
+	{
+		return JobResult::UpToDate;
+	}
+
+	std::vector<unsigned char> cooked;
+	bool converted = true;
+	switch (kind)
+	{
+	case AssetKind::Texture: converted = CookTexture(source, hash, compression, cooked); break;
+	case AssetKind::Shader:  converted = CookShader(source, hash, cooked); break;
+	default:                 cooked = std::move(source); break;
+	}
+	if (!converted)
+	{
+		return JobResult::Failed;
+	}
+
+	// written aside then renamed, an interrupted cook never leaves a truncated file that looks up to date
+	std::error_code error;
+	const fs::path destination(job.Destination);
+	if (destination.has_parent_path())
+	{
+		fs::create_directories(destination.parent_path(), error);
+	}
+	const fs::path temporary = destination.string() + ".tmp";
+	{
+		std::ofstream output(temporary, std::ios::binary);
+		output.write((const char*)cooked.data(), cooked.size());
+		if (!output)
+		{
+			return JobResult::Failed;
+		}
+	}
+	fs::rename(temporary, destination, error);
+	return error ? JobResult::Failed : JobResult::Cooked;
+}
+
+AssetCookerStats AssetCooker::Cook(const std::vector<AssetCookJob>& jobs, const AssetCookerSettings& settings)
+{
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<size_t> next(0);
+	std::atomic<unsigned int> textures(0), shaders(0), copies(0), upToDate(0), failures(0);
+
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < jobs.size(); i = next++)
+		{
+			const AssetCookJob& job = jobs[i];
+			const AssetKind kind = GetKind(job.Source);
+			const JobResult result = CookJob(job, kind, settings);
+			if (result == JobResult::UpToDate)
+			{
+				++upToDate;
+				continue;
+			}
+
+			std::lock_guard<std::mutex> lock(s_OutputMutex);
+			if (result == JobResult::Failed)
+			{
+				++failures;
+				std::cout << "Failed to cook " << job.Source << std::endl;
+				continue;
+			}
+			if (kind == AssetKind::Texture)
+			{
+				++textures;
+			}
+			else if (kind == AssetKind::Shader)
+			{
+				++shaders;
+			}
+			else
+			{
+				++copies;
+			}
+			std::cout << job.Source << " -> " << job.Destination << std::endl;
+		}
+	};
+
+	unsigned int workers = settings.ThreadCount ? settings.ThreadCount
+		: std::max(1u, std::thread::hardware_concurrency());
+	workers = (unsigned int)std::min<size_t>(workers, std::max<size_t>(jobs.size(), 1));
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < workers; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+
+	AssetCookerStats stats;
+	stats.Textures = textures;
+	stats.Shaders = shaders;
+	stats.Copies = copies;
+	stats.UpToDate = upToDate;
+	stats.Failures = failures;
+	stats.Seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return stats;
+}
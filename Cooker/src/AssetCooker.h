@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "TextureCompressor.h"
+
+struct AssetCookerSettings
+{
+	// applied to every 8 bit texture, 16 bit and HDR ones are always cooked uncompressed
+	TextureCompression Compression = TextureCompression::None;
+	// 0 uses every hardware thread
+	unsigned int ThreadCount = 0;
+	// cook even the outputs that are up to date
+	bool Force = false;
+};
+
+struct AssetCookerStats
+{
+	unsigned int Textures;
+	unsigned int Shaders;
+	unsigned int Copies;
+	unsigned int UpToDate;
+	unsigned int Failures;
+	double Seconds;
+};
+
+struct AssetCookJob
+{
+	std::string Source;
+	std::string Destination;
+};
+
+/**
+ * \brief Converts source assets into the runtime formats of CookedAsset so loading is a mapping and a copy:
+ * images are decoded, flipped and mipped down to 1x1 (and block compressed when asked), shaders are split into
+ * their stages and stripped of comments, anything else is copied as is.
+ *
+ * Builds are incremental: every cooked file records the FNV-1a hash of the source it came from, a job whose
+ * destination already holds the same hash (and the same compression) is skipped without decoding anything.
+ * Jobs are spread over worker threads, one file per worker at a time.
+ */
+class AssetCooker
+{
+public:
+	enum class AssetKind
+	{
+		Texture,
+		Shader,
+		Other
+	};
+
+	// By extension
+	static AssetKind GetKind(const std::string& filepath);
+
+	static AssetCookerStats Cook(const std::vector<AssetCookJob>& jobs, const AssetCookerSettings& settings);
+
+	static bool CookTexture(const std::vector<unsigned char>& source, uint64_t sourceHash, TextureCompression compression,
+		std::vector<unsigned char>& cooked);
+	static bool CookShader(const std::vector<unsigned char>& source, uint64_t sourceHash,
+		std::vector<unsigned char>& cooked);
+	// Splits at the #shader lines like Shader::ParseShader, drops comments, trailing spaces and blank lines
+	static void PreprocessShader(const std::string& source, std::string& vertex, std::string& fragment);
+private:
+	enum class JobResult
+	{
+		Cooked,
+		UpToDate,
+		Failed
+	};
+
+	static JobResult CookJob(const AssetCookJob& job, AssetKind kind, const AssetCookerSettings& settings);
+	static bool IsUpToDate(const std::string& destination, AssetKind kind, uint64_t sourceHash,
+		TextureCompression compression);
+};
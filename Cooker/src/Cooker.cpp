@@ -0,0 +1,154 @@
+/**
+ * Cooker: converts source assets into the formats the runtime loads without decoding (see CookedAsset).
+ *
+ *     Cooker <output dir> <file or directory>... [--compression bc1|bc3|bc4|bc5] [--threads N] [--force]
+ *         [--pack <file.pack>]
+ *
+ * Every input is cooked to the same relative path under the output directory, so cooked files keep the names
+ * the application asks for. Inputs that haven't changed since the last run are skipped. With --pack the cooked
+ * files are also packed, named after their source paths, ready for AssetManager::MountPack.
+ */
+#include "AssetCooker.h"
+#include "PackFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "Usage: Cooker <output dir> <file or directory>... [--compression bc1|bc3|bc4|bc5]"
+			" [--threads N] [--force] [--pack <file.pack>]" << std::endl;
+	}
+
+	bool ParseCompression(const std::string& name, TextureCompression& compression)
+	{
+		static const std::pair<const char*, TextureCompression> formats[] = {
+			{ "none", TextureCompression::None }, { "bc1", TextureCompression::BC1 }, { "bc3", TextureCompression::BC3 },
+			{ "bc4", TextureCompression::BC4 }, { "bc5", TextureCompression::BC5 }
+		};
+		for (const auto& format : formats)
+		{
+			if (name == format.first)
+			{
+				compression = format.second;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void AddJobs(const fs::path& input, const fs::path& output, std::vector<AssetCookJob>& jobs)
+	{
+		std::error_code error;
+		std::vector<fs::path> files;
+		if (fs::is_directory(input, error))
+		{
+			for (const fs::directory_entry& entry : fs::recursive_directory_iterator(input, error))
+			{
+				if (entry.is_regular_file())
+				{
+					files.push_back(entry.path());
+				}
+			}
+		}
+		else
+		{
+			files.push_back(input);
+		}
+		std::sort(files.begin(), files.end());
+
+		for (const fs::path& file : files)
+		{
+			AssetCookJob job;
+			job.Source = file.generic_string();
+			job.Destination = (output / file.relative_path()).lexically_normal().string();
+			jobs.push_back(job);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string output, pack;
+	std::vector<std::string> inputs;
+	AssetCookerSettings settings;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--compression" && i + 1 < argc)
+		{
+			if (!ParseCompression(argv[++i], settings.Compression))
+			{
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (argument == "--threads" && i + 1 < argc)
+		{
+			settings.ThreadCount = (unsigned int)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (argument == "--force")
+		{
+			settings.Force = true;
+		}
+		else if (argument == "--pack" && i + 1 < argc)
+		{
+			pack = argv[++i];
+		}
+		else if (output.empty())
+		{
+			output = argument;
+		}
+		else
+		{
+			inputs.push_back(argument);
+		}
+	}
+	if (output.empty() || inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<AssetCookJob> jobs;
+	for (const std::string& input : inputs)
+	{
+		AddJobs(input, output, jobs);
+	}
+
+	const AssetCookerStats stats = AssetCooker::Cook(jobs, settings);
+	std::cout << stats.Textures << " textures, " << stats.Shaders << " shaders, " << stats.Copies << " copies, "
+		<< stats.UpToDate << " up to date, " << stats.Failures << " failed in " << stats.Seconds << " s" << std::endl;
+	if (stats.Failures > 0)
+	{
+		return 1;
+	}
+
+	if (!pack.empty())
+	{
+		// cooked textures are already compressed or large raw pixels, LZ4 still pays off on the latter
+		PackWriter writer;
+		for (const AssetCookJob& job : jobs)
+		{
+			if (!writer.AddFile(job.Source, job.Destination, true))
+			{
+				return 1;
+			}
+		}
+		if (!writer.Write(pack))
+		{
+			return 1;
+		}
+		const PackWriterStats& packStats = writer.GetStats();
+		std::cout << pack << ": " << packStats.Entries << " files, " << packStats.PackBytes << " bytes" << std::endl;
+	}
+	return 0;
+}
@@ -0,0 +1,107 @@
+/**
+ * Packer: builds the pack file AssetManager mounts at startup.
+ *
+ *     Packer <output.pack> <file or directory>... [--compress] [--alignment N]
+ *
+ * Directories are walked recursively. Entries are named after the paths as given, so run it from the
+ * directory the application runs from, e.g. "Packer res.pack res --compress" inside TheChernoTuto.
+ */
+#include "PackFile.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "Usage: Packer <output.pack> <file or directory>... [--compress] [--alignment N]" << std::endl;
+	}
+
+	bool AddPath(PackWriter& writer, const fs::path& path, bool compress)
+	{
+		std::error_code error;
+		if (!fs::is_directory(path, error))
+		{
+			return writer.AddFile(path.generic_string(), path.string(), compress);
+		}
+
+		// sorted so that the same tree always gives the same pack
+		std::vector<fs::path> files;
+		for (const fs::directory_entry& entry : fs::recursive_directory_iterator(path, error))
+		{
+			if (entry.is_regular_file())
+			{
+				files.push_back(entry.path());
+			}
+		}
+		if (error)
+		{
+			std::cout << "Failed to list " << path.string() << ": " << error.message() << std::endl;
+			return false;
+		}
+		std::sort(files.begin(), files.end());
+
+		bool added = true;
+		for (const fs::path& file : files)
+		{
+			added &= writer.AddFile(file.generic_string(), file.string(), compress);
+		}
+		return added;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<std::string> inputs;
+	bool compress = false;
+	uint32_t alignment = PackWriter::DefaultAlignment;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--compress")
+		{
+			compress = true;
+		}
+		else if (argument == "--alignment" && i + 1 < argc)
+		{
+			alignment = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+		}
+		else if (output.empty())
+		{
+			output = argument;
+		}
+		else
+		{
+			inputs.push_back(argument);
+		}
+	}
+	if (output.empty() || inputs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	PackWriter writer;
+	bool added = true;
+	for (const std::string& input : inputs)
+	{
+		added &= AddPath(writer, input, compress);
+	}
+	if (!added || !writer.Write(output, alignment))
+	{
+		return 1;
+	}
+
+	const PackWriterStats& stats = writer.GetStats();
+	std::cout << output << ": " << stats.Entries << " files (" << stats.CompressedEntries << " compressed), "
+		<< stats.SourceBytes << " bytes packed into " << stats.PackBytes << std::endl;
+	return 0;
+}
@@ -0,0 +1,62 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 textCoord;
+layout(location = 2) in vec4 color;
+layout(location = 3) in float texIndex;
+
+out vec2 v_TextCoord;
+out vec4 v_Color;
+flat out int v_TexIndex;
+
+uniform mat4 u_ViewProjection;
+
+void main()
+{
+    gl_Position = u_ViewProjection * position;
+    v_TextCoord = textCoord;
+    v_Color = color;
+    v_TexIndex = int(texIndex + 0.5);
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TextCoord;
+in vec4 v_Color;
+flat in int v_TexIndex;
+
+// GLSL 3.30 only allows constant indices into sampler arrays, hence the switch
+uniform sampler2D u_Textures[16];
+
+vec4 SampleTexture()
+{
+    switch (v_TexIndex)
+    {
+        case 0: return texture(u_Textures[0], v_TextCoord);
+        case 1: return texture(u_Textures[1], v_TextCoord);
+        case 2: return texture(u_Textures[2], v_TextCoord);
+        case 3: return texture(u_Textures[3], v_TextCoord);
+        case 4: return texture(u_Textures[4], v_TextCoord);
+        case 5: return texture(u_Textures[5], v_TextCoord);
+        case 6: return texture(u_Textures[6], v_TextCoord);
+        case 7: return texture(u_Textures[7], v_TextCoord);
+        case 8: return texture(u_Textures[8], v_TextCoord);
+        case 9: return texture(u_Textures[9], v_TextCoord);
+        case 10: return texture(u_Textures[10], v_TextCoord);
+        case 11: return texture(u_Textures[11], v_TextCoord);
+        case 12: return texture(u_Textures[12], v_TextCoord);
+        case 13: return texture(u_Textures[13], v_TextCoord);
+        case 14: return texture(u_Textures[14], v_TextCoord);
+        case 15: return texture(u_Textures[15], v_TextCoord);
+    }
+    return vec4(1.0, 0.0, 1.0, 1.0);
+}
+
+void main()
+{
+    color = SampleTexture() * v_Color;
+}
\ No newline at end of file
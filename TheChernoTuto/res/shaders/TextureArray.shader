@@ -0,0 +1,30 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+// xy are the usual coordinates, z is the layer of the texture array
+layout(location = 1) in vec3 textCoord;
+
+out vec3 v_TextCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+    gl_Position = u_MVP * position;
+    v_TextCoord = textCoord;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec3 v_TextCoord;
+
+uniform sampler2DArray u_Textures;
+
+void main()
+{
+    color = texture(u_Textures, v_TextCoord);
+}
\ No newline at end of file
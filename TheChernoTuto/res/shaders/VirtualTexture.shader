@@ -0,0 +1,50 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 textCoord;
+
+out vec2 v_TextCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+    gl_Position = u_MVP * position;
+    v_TextCoord = textCoord;
+}
+
+#shader fragment
+#version 330 core
+
+layout(location = 0) out vec4 color;
+
+in vec2 v_TextCoord;
+
+// one texel per page and one mip per level: slot x, slot y, level the slot actually holds, valid
+uniform usampler2D u_PageTable;
+uniform sampler2D u_PhysicalCache;
+uniform vec2 u_ImageSize;
+uniform float u_PageSize;
+uniform float u_Border;
+uniform float u_CacheSize;
+uniform int u_MaxLevel;
+
+void main()
+{
+    vec2 texel = v_TextCoord * u_ImageSize;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8));
+    int level = clamp(int(floor(lod)), 0, u_MaxLevel);
+
+    texel = clamp(texel, vec2(0.0), u_ImageSize - 1.0);
+    ivec2 page = ivec2(texel / (u_PageSize * exp2(float(level))));
+    uvec4 entry = texelFetch(u_PageTable, page, level);
+
+    // the entry may point to a coarser ancestor, find the position inside the page of the level it holds
+    vec2 pagePosition = texel / (u_PageSize * exp2(float(entry.b)));
+    vec2 inPage = pagePosition - floor(pagePosition);
+    vec2 physical = vec2(entry.rg) * (u_PageSize + 2.0 * u_Border) + u_Border + inPage * u_PageSize;
+    color = textureLod(u_PhysicalCache, physical / u_CacheSize, 0.0);
+}
\ No newline at end of file
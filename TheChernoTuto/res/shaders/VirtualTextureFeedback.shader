@@ -0,0 +1,41 @@
+#shader vertex
+#version 330 core
+
+layout(location = 0) in vec4 position;
+layout(location = 1) in vec2 textCoord;
+
+out vec2 v_TextCoord;
+
+uniform mat4 u_MVP;
+
+void main()
+{
+    gl_Position = u_MVP * position;
+    v_TextCoord = textCoord;
+}
+
+#shader fragment
+#version 330 core
+
+// page x, page y, mip level and 1 to tell written texels from the cleared ones
+layout(location = 0) out uvec4 feedback;
+
+in vec2 v_TextCoord;
+
+uniform vec2 u_ImageSize;
+uniform float u_PageSize;
+uniform int u_MaxLevel;
+uniform float u_LodBias;
+
+void main()
+{
+    // same level selection as VirtualTexture.shader, biased for the lower resolution of this pass
+    vec2 texel = v_TextCoord * u_ImageSize;
+    vec2 dx = dFdx(texel);
+    vec2 dy = dFdy(texel);
+    float lod = 0.5 * log2(max(max(dot(dx, dx), dot(dy, dy)), 1e-8)) + u_LodBias;
+    int level = clamp(int(floor(lod)), 0, u_MaxLevel);
+
+    vec2 page = floor(clamp(texel, vec2(0.0), u_ImageSize - 1.0) / (u_PageSize * exp2(float(level))));
+    feedback = uvec4(uvec2(page), uint(level), 1u);
+}
\ No newline at end of file
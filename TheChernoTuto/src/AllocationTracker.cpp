@@ -0,0 +1,249 @@
+#include "AllocationTracker.h"
+
+#include "imgui/imgui.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+namespace
+{
+	// keeps the block behind it aligned like malloc's
+	struct alignas(16) BlockHeader
+	{
+		uint64_t Size;
+		uint64_t Tag;
+	};
+
+	thread_local AllocationTag t_Tag = AllocationTag::Untagged;
+}
+
+AllocationTracker::Counters AllocationTracker::s_Counters[(size_t)AllocationTag::Count];
+uint64_t AllocationTracker::s_FrameStartAllocations[(size_t)AllocationTag::Count];
+uint64_t AllocationTracker::s_FrameStartBytes[(size_t)AllocationTag::Count];
+uint64_t AllocationTracker::s_FrameAllocations[(size_t)AllocationTag::Count];
+uint64_t AllocationTracker::s_FrameBytes[(size_t)AllocationTag::Count];
+unsigned long long AllocationTracker::s_Frame = 0;
+bool AllocationTracker::s_AssertNoAllocations = false;
+unsigned long long AllocationTracker::s_AssertFromFrame = 0;
+
+void* AllocationTracker::Allocate(size_t size, AllocationTag tag)
+{
+	BlockHeader* header = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + size));
+	if (!header)
+	{
+		return nullptr;
+	}
+	header->Size = size;
+	header->Tag = (uint64_t)tag;
+	Counters& counters = s_Counters[(size_t)tag];
+	counters.Allocations.fetch_add(1, std::memory_order_relaxed);
+	counters.AllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+	return header + 1;
+}
+
+void AllocationTracker::Free(void* pointer)
+{
+	if (!pointer)
+	{
+		return;
+	}
+	BlockHeader* header = static_cast<BlockHeader*>(pointer) - 1;
+	Counters& counters = s_Counters[(size_t)header->Tag];
+	counters.Frees.fetch_add(1, std::memory_order_relaxed);
+	counters.FreedBytes.fetch_add(header->Size, std::memory_order_relaxed);
+	std::free(header);
+}
+
+AllocationTag AllocationTracker::GetTag()
+{
+	return t_Tag;
+}
+
+AllocationTag AllocationTracker::SetTag(AllocationTag tag)
+{
+	const AllocationTag previous = t_Tag;
+	t_Tag = tag;
+	return previous;
+}
+
+void AllocationTracker::BeginFrame()
+{
+	uint64_t allocations = 0;
+	for (size_t tag = 0; tag < (size_t)AllocationTag::Count; ++tag)
+	{
+		const uint64_t total = s_Counters[tag].Allocations.load(std::memory_order_relaxed);
+		const uint64_t bytes = s_Counters[tag].AllocatedBytes.load(std::memory_order_relaxed);
+		s_FrameAllocations[tag] = total - s_FrameStartAllocations[tag];
+		s_FrameBytes[tag] = bytes - s_FrameStartBytes[tag];
+		s_FrameStartAllocations[tag] = total;
+		s_FrameStartBytes[tag] = bytes;
+		allocations += s_FrameAllocations[tag];
+	}
+	++s_Frame;
+
+	if (s_AssertNoAllocations && s_Frame > s_AssertFromFrame && allocations > 0)
+	{
+		std::cout << "Frame " << s_Frame - 1 << " allocated " << allocations << " times:";
+		for (size_t tag = 0; tag < (size_t)AllocationTag::Count; ++tag)
+		{
+			if (s_FrameAllocations[tag] > 0)
+			{
+				std::cout << " " << GetTagName((AllocationTag)tag) << " " << s_FrameAllocations[tag] << " ("
+					<< s_FrameBytes[tag] << " bytes)";
+			}
+		}
+		std::cout << std::endl;
+		std::abort();
+	}
+}
+
+void AllocationTracker::SetAssertNoAllocations(bool enabled)
+{
+	s_AssertNoAllocations = enabled;
+	// the frames right after startup or a change still fill caches and grow buffers
+	s_AssertFromFrame = s_Frame + WarmupFrames;
+}
+
+AllocationStats AllocationTracker::GetStats()
+{
+	AllocationStats stats = {};
+	for (size_t tag = 0; tag < (size_t)AllocationTag::Count; ++tag)
+	{
+		AllocationTagStats& tagStats = stats.Tags[tag];
+		const Counters& counters = s_Counters[tag];
+		tagStats.Allocations = counters.Allocations.load(std::memory_order_relaxed);
+		tagStats.Frees = counters.Frees.load(std::memory_order_relaxed);
+		tagStats.LiveBytes = counters.AllocatedBytes.load(std::memory_order_relaxed)
+			- counters.FreedBytes.load(std::memory_order_relaxed);
+		tagStats.FrameAllocations = s_FrameAllocations[tag];
+		tagStats.FrameBytes = s_FrameBytes[tag];
+		stats.FrameAllocations += s_FrameAllocations[tag];
+		stats.FrameBytes += s_FrameBytes[tag];
+	}
+	stats.Frame = s_Frame;
+	return stats;
+}
+
+const char* AllocationTracker::GetTagName(AllocationTag tag)
+{
+	switch (tag)
+	{
+	case AllocationTag::Untagged:	return "Untagged";
+	case AllocationTag::Renderer:	return "Renderer";
+	case AllocationTag::Shader:		return "Shader";
+	case AllocationTag::Texture:	return "Texture";
+	case AllocationTag::ImGui:		return "ImGui";
+	case AllocationTag::Assets:		return "Assets";
+	default:						return "?";
+	}
+}
+
+void AllocationTracker::OnImGuiRender()
+{
+	if (!IsEnabled())
+	{
+		ImGui::TextUnformatted("Build with ALLOCATION_TRACKING to count allocations");
+		bool enabled = false;
+		ImGui::BeginDisabled();
+		ImGui::Checkbox("Abort when a frame allocates", &enabled);
+		ImGui::EndDisabled();
+		return;
+	}
+
+	const AllocationStats stats = GetStats();
+	ImGui::Text("Last frame: %llu allocations, %.1f KB", (unsigned long long)stats.FrameAllocations,
+		stats.FrameBytes / 1024.0f);
+	if (ImGui::BeginTable("Allocations", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("Subsystem");
+		ImGui::TableSetupColumn("Frame");
+		ImGui::TableSetupColumn("Frame KB");
+		ImGui::TableSetupColumn("Total");
+		ImGui::TableSetupColumn("Live KB");
+		ImGui::TableHeadersRow();
+		for (size_t tag = 0; tag < (size_t)AllocationTag::Count; ++tag)
+		{
+			const AllocationTagStats& tagStats = stats.Tags[tag];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(GetTagName((AllocationTag)tag));
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)tagStats.FrameAllocations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", tagStats.FrameBytes / 1024.0f);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", (unsigned long long)tagStats.Allocations);
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", tagStats.LiveBytes / 1024.0f);
+		}
+		ImGui::EndTable();
+	}
+
+	bool enabled = s_AssertNoAllocations;
+	if (ImGui::Checkbox("Abort when a frame allocates", &enabled))
+	{
+		SetAssertNoAllocations(enabled);
+	}
+	if (s_AssertNoAllocations && s_Frame <= s_AssertFromFrame)
+	{
+		ImGui::Text("Armed in %llu frames", s_AssertFromFrame - s_Frame + 1);
+	}
+}
+
+#ifdef ALLOCATION_TRACKING
+void* operator new(size_t size)
+{
+	void* pointer = AllocationTracker::Allocate(size, AllocationTracker::GetTag());
+	if (!pointer)
+	{
+		throw std::bad_alloc();
+	}
+	return pointer;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size, AllocationTracker::GetTag());
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+	return AllocationTracker::Allocate(size, AllocationTracker::GetTag());
+}
+
+void operator delete(void* pointer) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, size_t) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, size_t) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+
+void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	AllocationTracker::Free(pointer);
+}
+#endif
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+enum class AllocationTag : unsigned char
+{
+	Untagged,
+	Renderer,
+	Shader,
+	Texture,
+	ImGui,
+	Assets,
+	Count
+};
+
+struct AllocationTagStats
+{
+	uint64_t Allocations;
+	uint64_t Frees;
+	uint64_t LiveBytes;
+	// during the last finished frame
+	uint64_t FrameAllocations;
+	uint64_t FrameBytes;
+};
+
+// Fixed size so asking for the stats doesn't allocate
+struct AllocationStats
+{
+	AllocationTagStats Tags[(size_t)AllocationTag::Count];
+	uint64_t FrameAllocations;
+	uint64_t FrameBytes;
+	unsigned long long Frame;
+};
+
+/**
+ * \brief Counts heap allocations per subsystem. With ALLOCATION_TRACKING defined (the Debug x64 build) the
+ * global operator new and delete go through Allocate and Free, and ImGui's allocator is routed there too. Every
+ * block carries a small header with its size and the tag that was current on the allocating thread, so frees
+ * are charged to the subsystem that allocated. Without it nothing is hooked and the stats stay at zero.
+ *
+ * BeginFrame closes the per frame counts. With SetAssertNoAllocations, any frame after the warm up that
+ * allocated prints its breakdown and aborts, so a CI run fails as soon as a steady state frame allocates.
+ */
+class AllocationTracker
+{
+public:
+	static const unsigned int WarmupFrames = 120;
+
+	static inline bool IsEnabled()
+	{
+#ifdef ALLOCATION_TRACKING
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	static void* Allocate(size_t size, AllocationTag tag);
+	static void Free(void* pointer);
+
+	static AllocationTag GetTag();
+	// Returns the previous tag of the calling thread
+	static AllocationTag SetTag(AllocationTag tag);
+
+	// Once per frame on the main thread
+	static void BeginFrame();
+
+	static void SetAssertNoAllocations(bool enabled);
+
+	inline static bool GetAssertNoAllocations()
+	{
+		return s_AssertNoAllocations;
+	}
+
+	static AllocationStats GetStats();
+	static const char* GetTagName(AllocationTag tag);
+	static void OnImGuiRender();
+private:
+	struct Counters
+	{
+		std::atomic<uint64_t> Allocations;
+		std::atomic<uint64_t> Frees;
+		std::atomic<uint64_t> AllocatedBytes;
+		std::atomic<uint64_t> FreedBytes;
+	};
+
+	static Counters s_Counters[(size_t)AllocationTag::Count];
+	// totals at the start of the current frame and the frame before
+	static uint64_t s_FrameStartAllocations[(size_t)AllocationTag::Count];
+	static uint64_t s_FrameStartBytes[(size_t)AllocationTag::Count];
+	static uint64_t s_FrameAllocations[(size_t)AllocationTag::Count];
+	static uint64_t s_FrameBytes[(size_t)AllocationTag::Count];
+	static unsigned long long s_Frame;
+	static bool s_AssertNoAllocations;
+	static unsigned long long s_AssertFromFrame;
+};
+
+// Tags the allocations of the calling thread until the end of the scope
+class AllocationScope
+{
+public:
+	explicit AllocationScope(AllocationTag tag)
+		:m_Previous(AllocationTracker::SetTag(tag))
+	{
+	}
+
+	~AllocationScope()
+	{
+		AllocationTracker::SetTag(m_Previous);
+	}
+
+	AllocationScope(const AllocationScope&) = delete;
+	AllocationScope& operator=(const AllocationScope&) = delete;
+private:
+	AllocationTag m_Previous;
+};
+
+#ifdef ALLOCATION_TRACKING
+#define ALLOCATION_SCOPE_NAME2(line) allocationScope##line
+#define ALLOCATION_SCOPE_NAME(line) ALLOCATION_SCOPE_NAME2(line)
+#define ALLOCATION_SCOPE(tag) AllocationScope ALLOCATION_SCOPE_NAME(__LINE__)(tag)
+#else
+#define ALLOCATION_SCOPE(tag)
+#endif
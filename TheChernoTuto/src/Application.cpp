@@ -1,13 +1,27 @@
 #include "GL/glew.h"
 #include "GLFW/glfw3.h"
 
+#include <cstring>
+#include <fstream>
 #include <iostream>
 
+#include "AllocationTracker.h"
+#include "AssetManager.h"
+#include "DeletionQueue.h"
+#include "FontAtlasCache.h"
+#include "FrameAllocator.h"
+#include "Profiler.h"
 #include "Renderer.h"
+#include "RenderThread.h"
+#include "ResourcePool.h"
+#include "SamplerCache.h"
+#include "StartupScheduler.h"
 #include "VertexBuffer.h"
 #include "IndexBuffer.h"
+#include "JobSystem.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "TextureResidency.h"
 #include "VertexArray.h"
 #include "VertexBufferLayout.h"
 #include "glm/glm.hpp"
@@ -15,13 +29,94 @@
 #include "imgui/imgui.h"
 #include "imgui/imgui_impl_glfw.h"
 #include "imgui/imgui_impl_opengl3.h"
+#include "tests/TestAssets.h"
+#include "tests/TestBatchRenderer.h"
+#include "tests/TestCanvas.h"
+#include "tests/TestClearColor.h"
+#include "tests/TestImageDecode.h"
+#include "tests/TestJobSystem.h"
+#include "tests/TestResidency.h"
+#include "tests/TestSamplers.h"
+#include "tests/TestTextureArray.h"
+#include "tests/TestTextureAtlas.h"
+#include "tests/TestTextureCompression.h"
+#include "tests/TestVirtualTexture.h"
+
+
+int main(int argc, char* argv[])
+{
+    Profiler::SetThreadName("Main");
+    // for CI: any frame past the warm up that allocates aborts the run
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--assert-no-allocations") == 0)
+        {
+            // without the hooks nothing is counted and the run would always pass
+            if (!AllocationTracker::IsEnabled())
+            {
+                std::cout << "--assert-no-allocations needs a build with ALLOCATION_TRACKING (Debug x64)" << std::endl;
+                return -1;
+            }
+            AllocationTracker::SetAssertNoAllocations(true);
+        }
+    }
 
+    StartupScheduler startup;
+    // the main thread is worker 0, it runs jobs while it waits for them
+    JobSystem::Initialize();
+
+    // the CPU side of the first assets only needs the files, it runs while the window comes up
+    startup.Begin("Mount packs");
+    // assets packed by the Packer tool are read from the mapped pack, the loose files are the fallback
+    if (std::ifstream("res.pack"))
+    {
+        AssetManager::MountPack("res.pack");
+    }
+    startup.End();
+    std::future<ShaderProgramSources> shaderSources = startup.Run("Read Basic.shader", []()
+    {
+        return AssetManager::ReadShaderFile("res/shaders/Basic.shader");
+    });
+    std::future<TextureFileData> textureData = startup.Run("Decode proteccTerra.png", []()
+    {
+        return AssetManager::ReadTextureFile("res/textures/proteccTerra.png");
+    });
+
+    // building the font atlas doesn't need GL either, the backends only upload it on the first frame
+    startup.Begin("ImGui context");
+    if (AllocationTracker::IsEnabled())
+    {
+        // ImGui allocates with malloc, routed through the tracker it shows up under its own tag
+        ImGui::SetAllocatorFunctions([](size_t size, void*)
+        {
+            return AllocationTracker::Allocate(size, AllocationTag::ImGui);
+        }, [](void* pointer, void*)
+        {
+            AllocationTracker::Free(pointer);
+        });
+    }
+    ImGui::CreateContext();
+    startup.End();
+    std::future<bool> fonts = startup.Run("Load font atlas", []()
+    {
+        ImGuiIO& io = ImGui::GetIO();
+        io.Fonts->AddFontDefault();
+        // rasterized once, the next runs read the pixels and glyph tables back from the cache
+        const bool cached = FontAtlasCache::Build(*io.Fonts, "imgui_fonts.cache");
+        // the OpenGL3 backend uploads RGBA, converting here keeps that off the first frame
+        unsigned char* pixels;
+        int width, height;
+        io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
+        return cached;
+    });
 
-int main(void)
-{
     /* Initialize the library */
+    startup.Begin("glfwInit");
     if (!glfwInit())
+    {
+        JobSystem::Shutdown();
         return -1;
+    }
 
     /* Create a windowed mode window and its OpenGL context */
 
@@ -29,10 +124,12 @@ int main(void)
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    startup.Begin("Create window");
     GLFWwindow* window = glfwCreateWindow(1920, 1080, "Hello World", NULL, NULL);
     if (!window)
     {
         glfwTerminate();
+        JobSystem::Shutdown();
         return -1;
     }
 
@@ -41,12 +138,14 @@ int main(void)
     //VSYNC
     glfwSwapInterval(1);
     
+    startup.Begin("glewInit");
     if (glewInit() != GLEW_OK)
     {
         std::cout << "Error while initializing GLEW\n";
     }
 
     std::cout << glGetString(GL_VERSION) << std::endl;
+    startup.End();
 
     {
         // contain the list of vertices position as 2D coordinate
@@ -66,6 +165,7 @@ int main(void)
             2, 3, 0
         };
 
+        startup.Begin("Quad buffers");
         GlCall(glEnable(GL_BLEND));
         GlCall(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
 
@@ -82,32 +182,43 @@ int main(void)
 
         glm::mat4 proj = glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f);
         glm::mat4 view = glm::translate(glm::mat4(1.0f), glm::vec3(0, 0, 0));
-
-        Shader shader("res/shaders/Basic.shader");
-        shader.Bind();
-        //shader.SetUniform4f("u_Color", 0.3f, 0.4f, 0.3f, 1.0f);
-
-        Texture texture("res/textures/proteccTerra.png");
-        texture.Bind(0);
-        shader.SetUniform1i("u_Texture", 0);
+        startup.End();
+
+        const ShaderProgramSources sources = startup.Wait("Read Basic.shader", shaderSources);
+        startup.Begin("Compile shader");
+        // read ahead, but registered with the manager like a load so the tests asking for Basic.shader share it
+        std::shared_ptr<Shader> shader = AssetManager::LoadShader("res/shaders/Basic.shader", sources);
+        shader->Bind();
+        //shader->SetUniform4f("u_Color", 0.3f, 0.4f, 0.3f, 1.0f);
+        startup.End();
+
+        const TextureFileData data = startup.Wait("Decode proteccTerra.png", textureData);
+        startup.Begin("Upload texture");
+        std::shared_ptr<Texture> texture = AssetManager::LoadTexture("res/textures/proteccTerra.png", data);
+        texture->Bind(0);
+        shader->SetUniform1i("u_Texture", 0);
 
         // reset the state
         va.Unbind();
-        shader.Unbind();
+        shader->Unbind();
         vb.Unbind();
         ib.Unbind();
-        //texture.Unbind();
+        //texture->Unbind();
 
         //GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0));
+        startup.End();
 
         Renderer renderer;
+        RenderThread renderThread(window);
+        bool useRenderThread = true;
 
         // SETUP IMGUI
-        ImGui::CreateContext();
-
+        if (!startup.Wait("Load font atlas", fonts))
+        {
+            std::cout << "Font atlas rasterized and saved to imgui_fonts.cache" << std::endl;
+        }
+        startup.Begin("ImGui backends");
         ImGuiIO& io = ImGui::GetIO(); (void)io;
-        io.Fonts->AddFontDefault();
-        io.Fonts->Build();
 
         ImGui_ImplGlfw_InitForOpenGL(window, true);
 
@@ -116,6 +227,24 @@ int main(void)
         // Setup Dear ImGui style
         ImGui::StyleColorsDark();
 
+        test::Test* currentTest = nullptr;
+        test::TestMenu* testMenu = new test::TestMenu(currentTest);
+        currentTest = testMenu;
+
+        testMenu->RegisterTest<test::TestClearColor>("Clear Color");
+        testMenu->RegisterTest<test::TestTextureCompression>("Texture Compression");
+        testMenu->RegisterTest<test::TestImageDecode>("Image Decode (PNG vs QOI)");
+        testMenu->RegisterTest<test::TestTextureAtlas>("Texture Atlas");
+        testMenu->RegisterTest<test::TestTextureArray>("Texture Array");
+        testMenu->RegisterTest<test::TestBatchRenderer>("Batch Renderer");
+        testMenu->RegisterTest<test::TestSamplers>("Samplers");
+        testMenu->RegisterTest<test::TestVirtualTexture>("Virtual Texture");
+        testMenu->RegisterTest<test::TestResidency>("Texture Residency");
+        testMenu->RegisterTest<test::TestCanvas>("Canvas (dirty rects)");
+        testMenu->RegisterTest<test::TestAssets>("Asset Manager");
+        testMenu->RegisterTest<test::TestJobSystem>("Job System");
+        startup.Begin("First frame");
+
         glm::vec3 translationA = glm::vec3(0, 0, 0);
         glm::vec3 translationB = glm::vec3(0, 0, 0);
 
@@ -128,57 +257,202 @@ int main(void)
         /* Loop until the user closes the window */
         while (!glfwWindowShouldClose(window))
         {
-            /* Render here */
-            renderer.Clear();
-
-            ImGui_ImplOpenGL3_NewFrame();
-            ImGui_ImplGlfw_NewFrame();
-            ImGui::NewFrame();
+            // what the frame three frames ago allocated is reused, the render thread is done with it
+            FrameAllocator::BeginFrame();
+            AllocationTracker::BeginFrame();
+            Profiler::BeginFrame();
+            PROFILE_SCOPE("Frame");
+
+            // nothing up to AcquireContext touches GL, it runs while the render thread draws the last frame
+            if (currentTest)
+            {
+                PROFILE_SCOPE("Update");
+                currentTest->OnUpdate(0.0f);
+            }
 
+            FramePacket& packet = renderThread.BeginPacket();
+            packet.ViewProjection = proj * view;
+            // tests bind their own textures to slot 0, the quads bind it again
+            glm::mat4 modelA = glm::translate(glm::mat4(1.0f), translationA);
+            glm::mat4 modelB = glm::translate(glm::mat4(1.0f), translationB);
+            packet.Draws.push_back({ &va, &ib, shader.get(), texture.get(), modelA });
+            packet.Draws.push_back({ &va, &ib, shader.get(), texture.get(), modelB });
 
-            //texture.Bind();
-            //shader.SetUniform4f("u_Color", r, 0.4f, 0.3f, 1.0f);
-            shader.Bind();
+            if (r > 1.0f || r < 0.0f)
             {
-                glm::mat4 modelA = glm::translate(glm::mat4(1.0f), translationA);
-	            glm::mat4 MVP = proj * view * modelA;
-	            shader.SetUniformMat4f("u_MVP", MVP);
-	            renderer.Draw(va, ib, shader);
+                increment = -increment;
             }
 
+            r += increment;
+
             {
-                glm::mat4 modelB = glm::translate(glm::mat4(1.0f), translationB);
-                glm::mat4 MVP = proj * view * modelB;
-                shader.SetUniformMat4f("u_MVP", MVP);
-                renderer.Draw(va, ib, shader);
+                PROFILE_SCOPE("Wait for the render thread");
+                renderThread.AcquireContext();
             }
 
-            if (r > 1.0f || r < 0.0f)
+            /* Render here */
+            renderer.Clear();
+
             {
-                increment = -increment;
+                PROFILE_SCOPE("ImGui new frame");
+                ImGui_ImplOpenGL3_NewFrame();
+                ImGui_ImplGlfw_NewFrame();
+                ImGui::NewFrame();
             }
 
-            r += increment;
+            // uploads the assets that finished loading and runs their callbacks before anything draws
+            AssetManager::Update();
 
+            if (currentTest)
             {
+                PROFILE_SCOPE("Render test");
+                currentTest->OnRender();
+                ImGui::Begin("Test");
+                if (currentTest != testMenu && ImGui::Button("<-"))
+                {
+                    delete currentTest;
+                    currentTest = testMenu;
+                }
+                currentTest->OnImGuiRender();
+                ImGui::End();
+            }
+
+            {
+                PROFILE_SCOPE("Debug windows");
+                // collapsed, the timeline isn't collected at all
+                if (ImGui::Begin("Profiler"))
+                {
+                    Profiler::OnImGuiRender();
+                }
+                ImGui::End();
+
                 ImGui::Begin("Debug");                          // Create a window called "Hello, world!" and append into it.
                 ImGui::SliderFloat3("floatA", &translationA.x, 0.0f, 960.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
                 ImGui::SliderFloat3("floatB", &translationB.x, 0.0f, 960.0f);            // Edit 1 float using a slider from 0.0f to 1.0f
                 ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / io.Framerate, io.Framerate);
+                if (ImGui::CollapsingHeader("Render thread"))
+                {
+                    if (ImGui::Checkbox("Draw and present on the render thread", &useRenderThread))
+                    {
+                        // safe here, the context is current on this thread until Submit
+                        if (useRenderThread)
+                        {
+                            renderThread.Start();
+                        }
+                        else
+                        {
+                            renderThread.Stop();
+                        }
+                    }
+                    const RenderThreadStats stats = renderThread.GetStats();
+                    ImGui::Text("Waiting for the context %.2f ms, drawing %.2f ms (swap %.2f ms)",
+                        stats.WaitMilliseconds, stats.RenderMilliseconds, stats.SwapMilliseconds);
+                }
+                if (ImGui::CollapsingHeader("Allocations"))
+                {
+                    AllocationTracker::OnImGuiRender();
+                }
+                if (ImGui::CollapsingHeader("Frame memory"))
+                {
+                    const FrameAllocatorStats stats = FrameAllocator::GetStats();
+                    ImGui::Text("Last frame %.1f KB, peak %.1f KB, arenas %.1f KB", stats.LastFrameBytes / 1024.0f,
+                        stats.PeakBytes / 1024.0f, stats.CapacityBytes / 1024.0f);
+                    ImGui::Text("Spilled to the heap: %u last frame, %u in total", stats.LastFrameHeapAllocations,
+                        stats.HeapAllocations);
+                }
+                if (ImGui::CollapsingHeader("Startup"))
+                {
+                    startup.OnImGuiRender();
+                }
+                if (ImGui::CollapsingHeader("Texture residency"))
+                {
+                    TextureResidency::OnImGuiRender();
+                }
+                if (ImGui::CollapsingHeader("Assets"))
+                {
+                    AssetManager::OnImGuiRender();
+                }
+                if (ImGui::CollapsingHeader("Jobs"))
+                {
+                    const std::vector<JobWorkerStats> workers = JobSystem::GetStats();
+                    for (size_t i = 0; i < workers.size(); ++i)
+                    {
+                        ImGui::Text("Worker %u: %llu jobs, %llu stolen, %.1f ms idle", (unsigned int)i,
+                            (unsigned long long)workers[i].Jobs, (unsigned long long)workers[i].Steals,
+                            workers[i].IdleMilliseconds);
+                    }
+                }
+                if (ImGui::CollapsingHeader("GPU resources"))
+                {
+                    const ResourcePoolStats stats = ResourcePool::GetStats();
+                    for (size_t type = 1; type < (size_t)ResourceType::Count; ++type)
+                    {
+                        ImGui::Text("%s: %u (%.1f KB)", ResourcePool::GetTypeName((ResourceType)type), stats.Live[type],
+                            stats.Bytes[type] / 1024.0f);
+                    }
+                    ImGui::Text("%u created, %u destroyed, %u stale handle lookups", stats.Created, stats.Destroyed,
+                        stats.StaleLookups);
+
+                    bool recycling = DeletionQueue::GetRecycling();
+                    if (ImGui::Checkbox("Recycle released buffers and textures", &recycling))
+                    {
+                        DeletionQueue::SetRecycling(recycling);
+                    }
+                    const DeletionQueueStats deletions = DeletionQueue::GetStats();
+                    ImGui::Text("%u waiting for their frame, %u free buffers (%.1f KB), %u free textures",
+                        deletions.PendingObjects, deletions.FreeBuffers, deletions.FreeBufferBytes / 1024.0f,
+                        deletions.FreeTextures);
+                    ImGui::Text("%u objects deleted in %u calls, %u buffers and %u textures reused", deletions.DeletedObjects,
+                        deletions.DeleteCalls, deletions.RecycledBuffers, deletions.RecycledTextures);
+                }
                 ImGui::End();
             }
 
             // Rendering
-            ImGui::Render();
-            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+            {
+                PROFILE_SCOPE("ImGui render");
+                ImGui::Render();
+                packet.CaptureImGui(ImGui::GetDrawData());
+            }
 
-            /* Swap front and back buffers */
-            GlCall(glfwSwapBuffers(window));
+            {
+                // the quads and ImGui are drawn, then texture residency and deletions run before the swap
+                PROFILE_SCOPE("Submit");
+                renderThread.Submit();
+            }
 
-            /* Poll for and process events */
-            GlCall(glfwPollEvents());
+            {
+                /* Poll for and process events */
+                PROFILE_SCOPE("Poll events");
+                glfwPollEvents();
+            }
+
+            if (startup.GetFirstFrameMilliseconds() == 0.0)
+            {
+                startup.MarkFirstFrame();
+                startup.Print();
+                // the first frame is presented here so the startup timeline ends on its swap
+                if (useRenderThread)
+                {
+                    renderThread.Start();
+                }
+            }
+        }
+        renderThread.Stop();
+
+        if (currentTest != testMenu)
+        {
+            delete testMenu;
         }
+        delete currentTest;
+        AssetManager::Clear();
+        AssetManager::UnmountPacks();
+        JobSystem::Shutdown();
+        SamplerCache::Clear();
+        FrameAllocator::Clear();
     }
+    // everything released, including the objects of the scope above, while the context is still alive
+    DeletionQueue::Flush();
 
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
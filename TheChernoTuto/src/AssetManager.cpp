@@ -0,0 +1,610 @@
+#include "AssetManager.h"
+
+#include "AllocationTracker.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <unordered_set>
+
+AssetManager::AssetMap<Texture> AssetManager::s_TexturePaths;
+AssetManager::AssetMap<Texture> AssetManager::s_TextureContents;
+AssetManager::AssetMap<Shader> AssetManager::s_ShaderPaths;
+AssetManager::AssetMap<Shader> AssetManager::s_ShaderContents;
+std::unordered_map<std::string, AssetManager::PendingTexture> AssetManager::s_PendingTextures;
+std::unordered_map<std::string, AssetManager::PendingShader> AssetManager::s_PendingShaders;
+std::vector<std::unique_ptr<PackFile>> AssetManager::s_Packs;
+std::vector<std::future<FileBatchReaderStats>> AssetManager::s_Batches;
+FileBatchReaderStats AssetManager::s_LastBatch = {};
+bool AssetManager::s_HasLastBatch = false;
+AssetManagerStats AssetManager::s_Stats = {};
+
+std::string AssetManager::NormalizePath(const std::string& filepath)
+{
+	return PackFile::NormalizeName(filepath);
+}
+
+bool AssetManager::HashFile(const std::string& filepath, uint64_t& hash)
+{
+	std::ifstream file(filepath, std::ios::binary);
+	if (!file)
+	{
+		return false;
+	}
+
+	hash = PackFile::Hash(nullptr, 0);
+	char buffer[64 * 1024];
+	while (file)
+	{
+		file.read(buffer, sizeof(buffer));
+		hash = PackFile::Hash((const unsigned char*)buffer, (size_t)file.gcount(), hash);
+	}
+	return true;
+}
+
+std::string AssetManager::GetTextureSuffix(TextureCompression compression, TextureUsage usage)
+{
+	return "|" + std::to_string((int)compression) + "|" + std::to_string((int)usage);
+}
+
+std::string AssetManager::GetContentKey(uint64_t hash)
+{
+	char key[17];
+	snprintf(key, sizeof(key), "%016llx", (unsigned long long)hash);
+	return key;
+}
+
+template<typename T>
+std::shared_ptr<T> AssetManager::Load(AssetMap<T>& paths, AssetMap<T>& contents, const std::string& path,
+	const std::string& suffix, const std::function<std::shared_ptr<T>(const PackFile*, const PackEntry*)>& create)
+{
+	++s_Stats.Requests;
+	if (std::shared_ptr<T> asset = Find(paths, path + suffix))
+	{
+		++s_Stats.PathHits;
+		return asset;
+	}
+
+	const PackEntry* entry = nullptr;
+	const PackFile* pack = FindInPacks(path, entry);
+	uint64_t hash = pack ? entry->ContentHash : 0;
+	const bool hashed = pack || HashFile(path, hash);
+	if (hashed)
+	{
+		if (std::shared_ptr<T> asset = Find(contents, GetContentKey(hash) + suffix))
+		{
+			++s_Stats.ContentHits;
+			paths[path + suffix] = asset;
+			return asset;
+		}
+	}
+
+	std::shared_ptr<T> asset = create(pack, entry);
+	++s_Stats.Loads;
+	paths[path + suffix] = asset;
+	if (hashed)
+	{
+		contents[GetContentKey(hash) + suffix] = asset;
+	}
+	return asset;
+}
+
+std::shared_ptr<Texture> AssetManager::LoadTexture(const std::string& filepath, TextureCompression compression,
+	TextureUsage usage)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	const std::string path = NormalizePath(filepath);
+	return Load<Texture>(s_TexturePaths, s_TextureContents, path, GetTextureSuffix(compression, usage),
+		[&](const PackFile* pack, const PackEntry* entry)
+	{
+		return pack
+			? std::make_shared<Texture>(ReadTexture(*pack, *entry, compression), usage)
+			: std::make_shared<Texture>(path, compression, usage);
+	});
+}
+
+std::shared_ptr<Shader> AssetManager::LoadShader(const std::string& filepath)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	const std::string path = NormalizePath(filepath);
+	return Load<Shader>(s_ShaderPaths, s_ShaderContents, path, "", [&](const PackFile* pack, const PackEntry* entry)
+	{
+		return pack
+			? std::make_shared<Shader>(path, ReadShader(*pack, *entry))
+			: std::make_shared<Shader>(path);
+	});
+}
+
+std::shared_ptr<Texture> AssetManager::LoadTexture(const std::string& filepath, const TextureFileData& data,
+	TextureCompression compression, TextureUsage usage)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	return Load<Texture>(s_TexturePaths, s_TextureContents, NormalizePath(filepath),
+		GetTextureSuffix(compression, usage), [&](const PackFile*, const PackEntry*)
+	{
+		return std::make_shared<Texture>(data, usage);
+	});
+}
+
+std::shared_ptr<Shader> AssetManager::LoadShader(const std::string& filepath, const ShaderProgramSources& sources)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	const std::string path = NormalizePath(filepath);
+	return Load<Shader>(s_ShaderPaths, s_ShaderContents, path, "", [&](const PackFile*, const PackEntry*)
+	{
+		return std::make_shared<Shader>(path, sources);
+	});
+}
+
+void AssetManager::LoadTextureAsync(const std::string& filepath, TextureCompression compression, TextureUsage usage,
+	const TextureCallback& callback)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	++s_Stats.Requests;
+	const std::string path = NormalizePath(filepath);
+	const std::string key = path + GetTextureSuffix(compression, usage);
+	if (std::shared_ptr<Texture> texture = Find(s_TexturePaths, key))
+	{
+		++s_Stats.PathHits;
+		callback(texture);
+		return;
+	}
+
+	auto pending = s_PendingTextures.find(key);
+	if (pending != s_PendingTextures.end())
+	{
+		++s_Stats.PathHits;
+		pending->second.Callbacks.push_back(callback);
+		return;
+	}
+
+	AddPendingTexture(key, path, compression, usage, callback).Result = ReadTextureAsync(path, compression);
+}
+
+void AssetManager::LoadTexturesAsync(const std::vector<std::string>& filepaths, TextureCompression compression,
+	TextureUsage usage, const TextureCallback& callback)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	std::vector<FileReadRequest> requests;
+	std::vector<std::promise<TextureLoad>> promises;
+	const std::string suffix = GetTextureSuffix(compression, usage);
+	for (const std::string& filepath : filepaths)
+	{
+		++s_Stats.Requests;
+		const std::string path = NormalizePath(filepath);
+		const std::string key = path + suffix;
+		if (std::shared_ptr<Texture> texture = Find(s_TexturePaths, key))
+		{
+			++s_Stats.PathHits;
+			callback(texture);
+			continue;
+		}
+
+		// this also catches a file listed twice
+		auto pending = s_PendingTextures.find(key);
+		if (pending != s_PendingTextures.end())
+		{
+			++s_Stats.PathHits;
+			pending->second.Callbacks.push_back(callback);
+			continue;
+		}
+
+		PendingTexture& load = AddPendingTexture(key, path, compression, usage, callback);
+		const PackEntry* entry = nullptr;
+		if (FindInPacks(path, entry))
+		{
+			// already mapped, there is nothing to batch
+			load.Result = ReadTextureAsync(path, compression);
+			continue;
+		}
+		FileReadRequest request;
+		request.Filepath = path;
+		requests.push_back(std::move(request));
+		promises.emplace_back();
+		load.Result = promises.back().get_future();
+	}
+
+	if (!requests.empty())
+	{
+		s_Batches.push_back(std::async(std::launch::async, &AssetManager::DecodeBatch, std::move(requests),
+			std::move(promises), compression));
+	}
+}
+
+void AssetManager::LoadShaderAsync(const std::string& filepath, const ShaderCallback& callback)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	++s_Stats.Requests;
+	const std::string path = NormalizePath(filepath);
+	if (std::shared_ptr<Shader> shader = Find(s_ShaderPaths, path))
+	{
+		++s_Stats.PathHits;
+		callback(shader);
+		return;
+	}
+
+	auto pending = s_PendingShaders.find(path);
+	if (pending != s_PendingShaders.end())
+	{
+		++s_Stats.PathHits;
+		pending->second.Callbacks.push_back(callback);
+		return;
+	}
+
+	// only reading and splitting the file is done ahead, compiling needs the context
+	PendingShader& load = s_PendingShaders[path];
+	load.Filepath = path;
+	load.Callbacks.push_back(callback);
+	const PackEntry* entry = nullptr;
+	const PackFile* pack = FindInPacks(path, entry);
+	load.Result = std::async(std::launch::async, [path, pack, entry]()
+	{
+		ALLOCATION_SCOPE(AllocationTag::Assets);
+		ShaderLoad result;
+		result.Hash = pack ? entry->ContentHash : 0;
+		result.Hashed = pack || HashFile(path, result.Hash);
+		result.Sources = pack ? ReadShader(*pack, *entry) : Shader::ParseShader(path);
+		return result;
+	});
+}
+
+TextureFileData AssetManager::ReadTextureFile(const std::string& filepath, TextureCompression compression)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	const std::string path = NormalizePath(filepath);
+	const PackEntry* entry = nullptr;
+	const PackFile* pack = FindInPacks(path, entry);
+	return pack ? ReadTexture(*pack, *entry, compression) : Texture::LoadFile(path, compression);
+}
+
+ShaderProgramSources AssetManager::ReadShaderFile(const std::string& filepath)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	const std::string path = NormalizePath(filepath);
+	const PackEntry* entry = nullptr;
+	const PackFile* pack = FindInPacks(path, entry);
+	return pack ? ReadShader(*pack, *entry) : Shader::ParseShader(path);
+}
+
+const PackFile* AssetManager::FindInPacks(const std::string& path, const PackEntry*& entry)
+{
+	for (auto pack = s_Packs.rbegin(); pack != s_Packs.rend(); ++pack)
+	{
+		entry = (*pack)->Find(path);
+		if (entry)
+		{
+			return pack->get();
+		}
+	}
+	return nullptr;
+}
+
+AssetManager::PendingTexture& AssetManager::AddPendingTexture(const std::string& key, const std::string& path,
+	TextureCompression compression, TextureUsage usage, const TextureCallback& callback)
+{
+	PendingTexture& load = s_PendingTextures[key];
+	load.Filepath = path;
+	load.Compression = compression;
+	load.Usage = usage;
+	load.Callbacks.push_back(callback);
+	return load;
+}
+
+std::future<AssetManager::TextureLoad> AssetManager::ReadTextureAsync(const std::string& path,
+	TextureCompression compression)
+{
+	// packs stay mounted while loads are in flight, the worker can keep the pointers
+	const PackEntry* entry = nullptr;
+	const PackFile* pack = FindInPacks(path, entry);
+	return std::async(std::launch::async, [path, compression, pack, entry]()
+	{
+		ALLOCATION_SCOPE(AllocationTag::Assets);
+		TextureLoad result;
+		result.Hash = pack ? entry->ContentHash : 0;
+		result.Hashed = pack || HashFile(path, result.Hash);
+		result.Data = pack ? ReadTexture(*pack, *entry, compression) : Texture::LoadFile(path, compression);
+		return result;
+	});
+}
+
+FileBatchReaderStats AssetManager::DecodeBatch(std::vector<FileReadRequest> requests,
+	std::vector<std::promise<TextureLoad>> promises, TextureCompression compression)
+{
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	// decoding is the slow part, every file becomes a job as soon as it is read instead of after the whole batch
+	JobCounter decodes;
+	const FileBatchReaderStats stats = FileBatchReader::Read(requests, [&](size_t index)
+	{
+		JobSystem::Run([&requests, &promises, compression, index]()
+		{
+			ALLOCATION_SCOPE(AllocationTag::Assets);
+			FileReadRequest& request = requests[index];
+			TextureLoad result;
+			result.Hashed = request.Succeeded;
+			result.Hash = PackFile::Hash(request.Data.data(), request.Data.size());
+			// a failed read gives the same empty texture as a missing file
+			result.Data = Texture::LoadMemory(request.Data.data(), request.Data.size(), compression);
+			// the texture still comes from a file it can be streamed back in from
+			result.Data.Filepath = request.Filepath;
+			if (request.Succeeded)
+			{
+				std::vector<unsigned char>().swap(request.Data);
+			}
+			promises[index].set_value(std::move(result));
+		}, &decodes);
+	});
+	JobSystem::Wait(decodes);
+	return stats;
+}
+
+TextureFileData AssetManager::ReadTexture(const PackFile& pack, const PackEntry& entry, TextureCompression compression)
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	std::vector<unsigned char> storage;
+	// a failed read decodes nothing and gives the same empty texture as a missing file
+	if (!pack.Read(entry, data, size, storage))
+	{
+		size = 0;
+	}
+	return Texture::LoadMemory(data, size, compression);
+}
+
+ShaderProgramSources AssetManager::ReadShader(const PackFile& pack, const PackEntry& entry)
+{
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	std::vector<unsigned char> storage;
+	if (!pack.Read(entry, data, size, storage))
+	{
+		return ShaderProgramSources();
+	}
+	return Shader::ParseShader((const char*)data, size);
+}
+
+void AssetManager::WaitForLoads()
+{
+	for (auto& pending : s_PendingTextures)
+	{
+		pending.second.Result.wait();
+	}
+	for (auto& pending : s_PendingShaders)
+	{
+		pending.second.Result.wait();
+	}
+	for (std::future<FileBatchReaderStats>& batch : s_Batches)
+	{
+		batch.wait();
+	}
+}
+
+std::shared_ptr<Texture> AssetManager::FinishTexture(PendingTexture& pending)
+{
+	TextureLoad result = pending.Result.get();
+	const std::string suffix = GetTextureSuffix(pending.Compression, pending.Usage);
+
+	// a synchronous load of the same asset may have finished first
+	std::shared_ptr<Texture> texture = Find(s_TexturePaths, pending.Filepath + suffix);
+	if (!texture && result.Hashed)
+	{
+		texture = Find(s_TextureContents, GetContentKey(result.Hash) + suffix);
+		s_Stats.ContentHits += texture ? 1 : 0;
+	}
+	if (!texture)
+	{
+		texture = std::make_shared<Texture>(result.Data, pending.Usage);
+		++s_Stats.Loads;
+	}
+
+	s_TexturePaths[pending.Filepath + suffix] = texture;
+	if (result.Hashed)
+	{
+		s_TextureContents[GetContentKey(result.Hash) + suffix] = texture;
+	}
+	return texture;
+}
+
+std::shared_ptr<Shader> AssetManager::FinishShader(PendingShader& pending)
+{
+	ShaderLoad result = pending.Result.get();
+
+	std::shared_ptr<Shader> shader = Find(s_ShaderPaths, pending.Filepath);
+	if (!shader && result.Hashed)
+	{
+		shader = Find(s_ShaderContents, GetContentKey(result.Hash));
+		s_Stats.ContentHits += shader ? 1 : 0;
+	}
+	if (!shader)
+	{
+		shader = std::make_shared<Shader>(pending.Filepath, result.Sources);
+		++s_Stats.Loads;
+	}
+
+	s_ShaderPaths[pending.Filepath] = shader;
+	if (result.Hashed)
+	{
+		s_ShaderContents[GetContentKey(result.Hash)] = shader;
+	}
+	return shader;
+}
+
+void AssetManager::Update()
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Assets);
+	// finished loads leave the pending maps before their callbacks run, which may request more assets
+	std::vector<PendingTexture> textures;
+	for (auto it = s_PendingTextures.begin(); it != s_PendingTextures.end();)
+	{
+		if (it->second.Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			textures.push_back(std::move(it->second));
+			it = s_PendingTextures.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	std::vector<PendingShader> shaders;
+	for (auto it = s_PendingShaders.begin(); it != s_PendingShaders.end();)
+	{
+		if (it->second.Result.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			shaders.push_back(std::move(it->second));
+			it = s_PendingShaders.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	for (PendingTexture& pending : textures)
+	{
+		const std::shared_ptr<Texture> texture = FinishTexture(pending);
+		for (const TextureCallback& callback : pending.Callbacks)
+		{
+			callback(texture);
+		}
+	}
+	for (PendingShader& pending : shaders)
+	{
+		const std::shared_ptr<Shader> shader = FinishShader(pending);
+		for (const ShaderCallback& callback : pending.Callbacks)
+		{
+			callback(shader);
+		}
+	}
+
+	for (auto it = s_Batches.begin(); it != s_Batches.end();)
+	{
+		if (it->wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+		{
+			s_LastBatch = it->get();
+			s_HasLastBatch = true;
+			it = s_Batches.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+
+	Prune(s_TexturePaths);
+	Prune(s_TextureContents);
+	Prune(s_ShaderPaths);
+	Prune(s_ShaderContents);
+}
+
+void AssetManager::Clear()
+{
+	WaitForLoads();
+	s_PendingTextures.clear();
+	s_PendingShaders.clear();
+	s_Batches.clear();
+	s_HasLastBatch = false;
+	s_TexturePaths.clear();
+	s_TextureContents.clear();
+	s_ShaderPaths.clear();
+	s_ShaderContents.clear();
+	s_Stats = AssetManagerStats();
+}
+
+bool AssetManager::MountPack(const std::string& filepath)
+{
+	WaitForLoads();
+	std::unique_ptr<PackFile> pack(new PackFile());
+	if (!pack->Open(filepath))
+	{
+		return false;
+	}
+	s_Packs.push_back(std::move(pack));
+	return true;
+}
+
+void AssetManager::UnmountPacks()
+{
+	WaitForLoads();
+	s_Packs.clear();
+}
+
+AssetManagerStats AssetManager::GetStats()
+{
+	AssetManagerStats stats = s_Stats;
+	// several paths can lead to the same asset
+	std::unordered_set<const void*> textures, shaders;
+	for (const auto& asset : s_TexturePaths)
+	{
+		if (std::shared_ptr<Texture> texture = asset.second.lock())
+		{
+			textures.insert(texture.get());
+		}
+	}
+	for (const auto& asset : s_ShaderPaths)
+	{
+		if (std::shared_ptr<Shader> shader = asset.second.lock())
+		{
+			shaders.insert(shader.get());
+		}
+	}
+	stats.Textures = (unsigned int)textures.size();
+	stats.Shaders = (unsigned int)shaders.size();
+	stats.PendingLoads = (unsigned int)(s_PendingTextures.size() + s_PendingShaders.size());
+	return stats;
+}
+
+bool AssetManager::GetLastBatch(FileBatchReaderStats& stats)
+{
+	stats = s_LastBatch;
+	return s_HasLastBatch;
+}
+
+void AssetManager::OnImGuiRender()
+{
+	const AssetManagerStats stats = GetStats();
+	ImGui::Text("%u textures, %u shaders, %u loads in flight", stats.Textures, stats.Shaders, stats.PendingLoads);
+	ImGui::Text("%u requests: %u by path, %u by content, %u loaded", stats.Requests, stats.PathHits, stats.ContentHits,
+		stats.Loads);
+	for (const std::unique_ptr<PackFile>& pack : s_Packs)
+	{
+		ImGui::Text("Pack %s: %u files", pack->GetFilepath().c_str(), (unsigned int)pack->GetEntryCount());
+	}
+	if (s_HasLastBatch)
+	{
+		ImGui::Text("Last batch: %u files (%u failed), %.1f MB in %.2f ms over %s", s_LastBatch.Files,
+			s_LastBatch.Failures, s_LastBatch.Bytes / (1024.0 * 1024.0), s_LastBatch.Milliseconds,
+			FileBatchReader::GetBackendName(s_LastBatch.Backend));
+	}
+
+	if (!ImGui::BeginTable("Assets", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		return;
+	}
+	ImGui::TableSetupColumn("Path");
+	ImGui::TableSetupColumn("References");
+	ImGui::TableHeadersRow();
+	// the manager's own weak references don't count
+	for (const auto& asset : s_TexturePaths)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(asset.first.c_str());
+		ImGui::TableNextColumn();
+		ImGui::Text("%ld", asset.second.use_count());
+	}
+	for (const auto& asset : s_ShaderPaths)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn();
+		ImGui::TextUnformatted(asset.first.c_str());
+		ImGui::TableNextColumn();
+		ImGui::Text("%ld", asset.second.use_count());
+	}
+	ImGui::EndTable();
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "FileBatchReader.h"
+#include "PackFile.h"
+#include "Shader.h"
+#include "Texture.h"
+
+struct AssetManagerStats
+{
+	unsigned int Textures;
+	unsigned int Shaders;
+	unsigned int PendingLoads;
+	// totals since the last Clear
+	unsigned int Requests;
+	unsigned int PathHits;
+	// a different path to a file with the same bytes as an asset already loaded
+	unsigned int ContentHits;
+	unsigned int Loads;
+};
+
+/**
+ * \brief Loads every texture and shader once, however many times and under however many spellings it is asked
+ * for. Assets are shared_ptr owned by their users and the manager only keeps weak references, so an asset goes
+ * away (through DeletionQueue) with its last user. Lookups go by normalized path first, then by a hash of the
+ * file's bytes so copies of a file under another name are shared too. Textures loaded with different
+ * compression or usage are different assets.
+ *
+ * Mounted packs are searched before the file system, by the same normalized path. Their table of contents
+ * already holds every entry's content hash, so nothing is read for an asset that is already loaded, and
+ * stored entries are decoded straight from the mapping.
+ *
+ * Async requests decode on a worker thread, Update uploads the results on the main thread and runs the
+ * callbacks; requests for an asset already being loaded just add their callback to the pending load.
+ * LoadTexturesAsync reads a whole list of files with one FileBatchReader batch and decodes each file as a
+ * JobSystem job as soon as its read completes, instead of one blocking read per worker.
+ */
+class AssetManager
+{
+public:
+	using TextureCallback = std::function<void(const std::shared_ptr<Texture>&)>;
+	using ShaderCallback = std::function<void(const std::shared_ptr<Shader>&)>;
+
+	static std::shared_ptr<Texture> LoadTexture(const std::string& filepath,
+		TextureCompression compression = TextureCompression::None, TextureUsage usage = TextureUsage::Data);
+	static std::shared_ptr<Shader> LoadShader(const std::string& filepath);
+	// For files read ahead with ReadTextureFile / ReadShaderFile: the asset is registered under filepath as if it
+	// had been loaded from it, and data is dropped when that asset is already loaded
+	static std::shared_ptr<Texture> LoadTexture(const std::string& filepath, const TextureFileData& data,
+		TextureCompression compression = TextureCompression::None, TextureUsage usage = TextureUsage::Data);
+	static std::shared_ptr<Shader> LoadShader(const std::string& filepath, const ShaderProgramSources& sources);
+
+	// The callback runs right away when the asset is already loaded, from Update otherwise
+	static void LoadTextureAsync(const std::string& filepath, TextureCompression compression, TextureUsage usage,
+		const TextureCallback& callback);
+	static void LoadShaderAsync(const std::string& filepath, const ShaderCallback& callback);
+
+	// Only the CPU side of a load (mounted packs first, then the file), safe on any thread while no pack is being
+	// mounted. The results go straight to the Texture / Shader constructors, they aren't shared
+	static TextureFileData ReadTextureFile(const std::string& filepath,
+		TextureCompression compression = TextureCompression::None);
+	static ShaderProgramSources ReadShaderFile(const std::string& filepath);
+	// Same as LoadTextureAsync for every file, the callback runs once per file
+	static void LoadTexturesAsync(const std::vector<std::string>& filepaths, TextureCompression compression,
+		TextureUsage usage, const TextureCallback& callback);
+
+	// Once per frame on the main thread
+	static void Update();
+	// Waits for the loads in flight, drops their callbacks and forgets every asset (users keep theirs)
+	static void Clear();
+
+	// The last pack mounted is searched first. Both wait for the loads in flight, which may be reading a pack
+	static bool MountPack(const std::string& filepath);
+	static void UnmountPacks();
+
+	// Forward slashes, no "." or ".." components, lower case on Windows
+	static std::string NormalizePath(const std::string& filepath);
+	// FNV-1a over the file's bytes, false when it can't be read
+	static bool HashFile(const std::string& filepath, uint64_t& hash);
+
+	static AssetManagerStats GetStats();
+	// false until a LoadTexturesAsync batch finished
+	static bool GetLastBatch(FileBatchReaderStats& stats);
+	// Every live asset with its reference count, meant to sit inside an open ImGui window
+	static void OnImGuiRender();
+private:
+	template<typename T>
+	using AssetMap = std::unordered_map<std::string, std::weak_ptr<T>>;
+
+	struct TextureLoad
+	{
+		bool Hashed;
+		uint64_t Hash;
+		TextureFileData Data;
+	};
+
+	struct ShaderLoad
+	{
+		bool Hashed;
+		uint64_t Hash;
+		ShaderProgramSources Sources;
+	};
+
+	struct PendingTexture
+	{
+		std::string Filepath;
+		TextureCompression Compression;
+		TextureUsage Usage;
+		std::future<TextureLoad> Result;
+		std::vector<TextureCallback> Callbacks;
+	};
+
+	struct PendingShader
+	{
+		std::string Filepath;
+		std::future<ShaderLoad> Result;
+		std::vector<ShaderCallback> Callbacks;
+	};
+
+	static std::string GetTextureSuffix(TextureCompression compression, TextureUsage usage);
+	static std::string GetContentKey(uint64_t hash);
+
+	template<typename T>
+	static std::shared_ptr<T> Find(const AssetMap<T>& assets, const std::string& key)
+	{
+		auto it = assets.find(key);
+		return it == assets.end() ? nullptr : it->second.lock();
+	}
+
+	template<typename T>
+	static void Prune(AssetMap<T>& assets)
+	{
+		for (auto it = assets.begin(); it != assets.end();)
+		{
+			it = it->second.expired() ? assets.erase(it) : std::next(it);
+		}
+	}
+
+	// Looks a synchronous load up by path then by content, create makes the asset when neither has it. The pack
+	// entry given to create is nullptr when the file isn't packed
+	template<typename T>
+	static std::shared_ptr<T> Load(AssetMap<T>& paths, AssetMap<T>& contents, const std::string& path,
+		const std::string& suffix, const std::function<std::shared_ptr<T>(const PackFile*, const PackEntry*)>& create);
+
+	// nullptr when no mounted pack has the file
+	static const PackFile* FindInPacks(const std::string& path, const PackEntry*& entry);
+	static TextureFileData ReadTexture(const PackFile& pack, const PackEntry& entry, TextureCompression compression);
+	static ShaderProgramSources ReadShader(const PackFile& pack, const PackEntry& entry);
+	// Registers a load in flight, its Result is left to the caller
+	static PendingTexture& AddPendingTexture(const std::string& key, const std::string& path,
+		TextureCompression compression, TextureUsage usage, const TextureCallback& callback);
+	static std::future<TextureLoad> ReadTextureAsync(const std::string& path, TextureCompression compression);
+	static FileBatchReaderStats DecodeBatch(std::vector<FileReadRequest> requests,
+		std::vector<std::promise<TextureLoad>> promises, TextureCompression compression);
+	static void WaitForLoads();
+
+	static std::shared_ptr<Texture> FinishTexture(PendingTexture& pending);
+	static std::shared_ptr<Shader> FinishShader(PendingShader& pending);
+
+	// keyed by normalized path and by content hash, texture keys end with their compression and usage
+	static AssetMap<Texture> s_TexturePaths;
+	static AssetMap<Texture> s_TextureContents;
+	static AssetMap<Shader> s_ShaderPaths;
+	static AssetMap<Shader> s_ShaderContents;
+	// keyed like s_TexturePaths / s_ShaderPaths
+	static std::unordered_map<std::string, PendingTexture> s_PendingTextures;
+	static std::unordered_map<std::string, PendingShader> s_PendingShaders;
+	static std::vector<std::unique_ptr<PackFile>> s_Packs;
+	static std::vector<std::future<FileBatchReaderStats>> s_Batches;
+	static FileBatchReaderStats s_LastBatch;
+	static bool s_HasLastBatch;
+	static AssetManagerStats s_Stats;
+};
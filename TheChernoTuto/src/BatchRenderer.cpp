@@ -0,0 +1,136 @@
+#include "BatchRenderer.h"
+
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+
+#include <algorithm>
+
+BatchRenderer::BatchRenderer(unsigned int maxQuads)
+	: m_MaxQuads(maxQuads), m_SlotCount(MaxTextureSlots), m_UsedSlots(0), m_Stats()
+{
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	int imageUnits = 0;
+	GlCall(glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &imageUnits));
+	m_SlotCount = std::min((unsigned int)std::max(imageUnits, 1), MaxTextureSlots);
+
+	// quads never share vertices, so the index pattern is the same for every batch
+	std::vector<unsigned int> indices(m_MaxQuads * 6);
+	for (unsigned int i = 0; i < m_MaxQuads; ++i)
+	{
+		const unsigned int first = i * 4;
+		indices[i * 6 + 0] = first;
+		indices[i * 6 + 1] = first + 1;
+		indices[i * 6 + 2] = first + 2;
+		indices[i * 6 + 3] = first + 2;
+		indices[i * 6 + 4] = first + 3;
+		indices[i * 6 + 5] = first;
+	}
+
+	m_VertexArray.reset(new VertexArray());
+	m_VertexBuffer.reset(new VertexBuffer(m_MaxQuads * 4 * (unsigned int)sizeof(Vertex)));
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(2);
+	layout.Push<float>(4);
+	layout.Push<float>(1);
+	m_VertexArray->AddBuffer(*m_VertexBuffer, layout);
+	m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+	m_Vertices.reserve(m_MaxQuads * 4);
+
+	int samplers[MaxTextureSlots];
+	for (unsigned int i = 0; i < MaxTextureSlots; ++i)
+	{
+		samplers[i] = (int)i;
+	}
+	m_Shader.reset(new Shader("res/shaders/Batch.shader"));
+	m_Shader->Bind();
+	m_Shader->SetUniform1iv("u_Textures", (int)m_SlotCount, samplers);
+	m_Shader->Unbind();
+}
+
+void BatchRenderer::Begin(const glm::mat4& viewProjection)
+{
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	m_Shader->Bind();
+	m_Shader->SetUniformMat4f("u_ViewProjection", viewProjection);
+	m_Vertices.clear();
+	m_UsedSlots = 0;
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+	const glm::vec4& uv, const glm::vec4& color)
+{
+	if (m_Vertices.size() == m_MaxQuads * 4)
+	{
+		++m_Stats.BufferFlushes;
+		Flush();
+	}
+	const float slot = GetSlot(texture);
+
+	m_Vertices.push_back({ position, glm::vec2(uv.x, uv.y), color, slot });
+	m_Vertices.push_back({ glm::vec2(position.x + size.x, position.y), glm::vec2(uv.z, uv.y), color, slot });
+	m_Vertices.push_back({ position + size, glm::vec2(uv.z, uv.w), color, slot });
+	m_Vertices.push_back({ glm::vec2(position.x, position.y + size.y), glm::vec2(uv.x, uv.w), color, slot });
+	++m_Stats.Quads;
+}
+
+void BatchRenderer::DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureAtlas& atlas,
+	const AtlasRegion& region, const glm::vec4& color)
+{
+	if (region.Page < 0)
+	{
+		return;
+	}
+	DrawQuad(position, size, atlas.GetPage(region.Page), glm::vec4(region.U0, region.V0, region.U1, region.V1), color);
+}
+
+void BatchRenderer::End()
+{
+	Flush();
+}
+
+void BatchRenderer::ResetStats()
+{
+	m_Stats = BatchStats();
+}
+
+void BatchRenderer::Flush()
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	if (!m_Vertices.empty())
+	{
+		m_VertexBuffer->SetData(m_Vertices.data(), (unsigned int)(m_Vertices.size() * sizeof(Vertex)));
+
+		Renderer renderer;
+		renderer.Draw(*m_VertexArray, *m_IndexBuffer, *m_Shader, (unsigned int)(m_Vertices.size() / 4 * 6));
+		++m_Stats.DrawCalls;
+	}
+	m_Vertices.clear();
+	m_UsedSlots = 0;
+}
+
+float BatchRenderer::GetSlot(const Texture& texture)
+{
+	const ResourceHandle handle = texture.GetHandle();
+	for (unsigned int i = 0; i < m_UsedSlots; ++i)
+	{
+		if (m_Slots[i] == handle)
+		{
+			return (float)i;
+		}
+	}
+
+	// a new texture only ends the batch once every slot holds a texture the batch still uses
+	if (m_UsedSlots == m_SlotCount)
+	{
+		++m_Stats.SlotFlushes;
+		Flush();
+	}
+	m_Slots[m_UsedSlots] = handle;
+	texture.Bind(m_UsedSlots);
+	++m_Stats.TextureBinds;
+	return (float)m_UsedSlots++;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "TextureAtlas.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+struct BatchStats
+{
+	unsigned int DrawCalls;
+	unsigned int Quads;
+	unsigned int TextureBinds;
+	// why batches were cut short, the rest end with End()
+	unsigned int SlotFlushes;
+	unsigned int BufferFlushes;
+};
+
+/**
+ * \brief Accumulates textured quads into one dynamic vertex buffer and draws them with as few calls as possible.
+ * Up to MaxTextureSlots different textures (fewer if the driver exposes fewer image units) are bound at once and
+ * each vertex carries the index of its slot, so a batch only ends when the slot table or the buffer is full.
+ */
+class BatchRenderer
+{
+public:
+	// res/shaders/Batch.shader declares its sampler array with this size
+	static const unsigned int MaxTextureSlots = 16;
+private:
+	struct Vertex
+	{
+		glm::vec2 Position;
+		glm::vec2 TextCoord;
+		glm::vec4 Color;
+		float TexIndex;
+	};
+
+	unsigned int m_MaxQuads;
+	unsigned int m_SlotCount;
+	std::unique_ptr<VertexArray> m_VertexArray;
+	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	std::unique_ptr<Shader> m_Shader;
+
+	std::vector<Vertex> m_Vertices;
+	ResourceHandle m_Slots[MaxTextureSlots];
+	unsigned int m_UsedSlots;
+	BatchStats m_Stats;
+public:
+	explicit BatchRenderer(unsigned int maxQuads = 10000);
+
+	void Begin(const glm::mat4& viewProjection);
+	// uv is (u0, v0, u1, v1), origin bottom left
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const Texture& texture,
+		const glm::vec4& uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f), const glm::vec4& color = glm::vec4(1.0f));
+	// Draws a region of an atlas page, sprites sharing a page share a slot
+	void DrawQuad(const glm::vec2& position, const glm::vec2& size, const TextureAtlas& atlas,
+		const AtlasRegion& region, const glm::vec4& color = glm::vec4(1.0f));
+	void End();
+
+	void ResetStats();
+
+	inline const BatchStats& GetStats() const
+	{
+		return m_Stats;
+	}
+
+	inline unsigned int GetSlotCount() const
+	{
+		return m_SlotCount;
+	}
+private:
+	void Flush();
+	float GetSlot(const Texture& texture);
+};
@@ -0,0 +1,121 @@
+#include "CommandBuffer.h"
+
+#include "AllocationTracker.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+CommandBuffer::CommandBuffer()
+	:m_Size(0)
+{
+}
+
+void CommandBuffer::Add(const SpriteCommand& command)
+{
+	if (m_Size == m_Blocks.size() * BlockSize)
+	{
+		ALLOCATION_SCOPE(AllocationTag::Renderer);
+		m_Blocks.emplace_back(new SpriteCommand[BlockSize]);
+	}
+	m_Blocks[m_Size / BlockSize][m_Size % BlockSize] = command;
+	++m_Size;
+}
+
+void CommandBuffer::Reset()
+{
+	m_Size = 0;
+}
+
+CommandRecorder::CommandRecorder()
+	:m_MergeMilliseconds(0.0)
+{
+}
+
+void CommandRecorder::Begin()
+{
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	const size_t count = (size_t)JobSystem::GetWorkerCount() + 1;
+	while (m_Buffers.size() < count)
+	{
+		m_Buffers.emplace_back(new CommandBuffer());
+	}
+	for (const std::unique_ptr<CommandBuffer>& buffer : m_Buffers)
+	{
+		buffer->Reset();
+	}
+	m_Sorted.clear();
+}
+
+CommandBuffer& CommandRecorder::GetBuffer()
+{
+	// the last buffer is the one of the threads outside the pool
+	const int index = JobSystem::GetWorkerIndex();
+	return index < 0 || (size_t)index + 1 >= m_Buffers.size() ? *m_Buffers.back() : *m_Buffers[index];
+}
+
+const std::vector<SortedCommand>& CommandRecorder::Merge()
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_Runs.clear();
+	m_RunStarts.clear();
+	for (const std::unique_ptr<CommandBuffer>& buffer : m_Buffers)
+	{
+		m_RunStarts.push_back(m_Runs.size());
+		for (size_t i = 0; i < buffer->GetSize(); ++i)
+		{
+			const SpriteCommand& command = buffer->Get(i);
+			m_Runs.push_back({ command.SortKey, &command });
+		}
+	}
+	m_RunStarts.push_back(m_Runs.size());
+
+	const auto byKey = [](const SortedCommand& a, const SortedCommand& b)
+	{
+		return a.Key < b.Key;
+	};
+	// the runs are independent, every worker sorts the one it recorded or steals another
+	JobSystem::ParallelFor(m_Buffers.size(), 1, [&](size_t begin, size_t end)
+	{
+		for (size_t run = begin; run < end; ++run)
+		{
+			std::sort(m_Runs.begin() + m_RunStarts[run], m_Runs.begin() + m_RunStarts[run + 1], byKey);
+		}
+	});
+
+	// a handful of runs, picking the smallest head by hand beats a heap
+	m_RunHeads.assign(m_RunStarts.begin(), m_RunStarts.end() - 1);
+	m_Sorted.resize(m_Runs.size());
+	for (SortedCommand& out : m_Sorted)
+	{
+		size_t best = m_Buffers.size();
+		for (size_t run = 0; run < m_Buffers.size(); ++run)
+		{
+			if (m_RunHeads[run] < m_RunStarts[run + 1]
+				&& (best == m_Buffers.size() || m_Runs[m_RunHeads[run]].Key < m_Runs[m_RunHeads[best]].Key))
+			{
+				best = run;
+			}
+		}
+		out = m_Runs[m_RunHeads[best]++];
+	}
+	m_MergeMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+	return m_Sorted;
+}
+
+CommandRecorderStats CommandRecorder::GetStats() const
+{
+	CommandRecorderStats stats = {};
+	for (const std::unique_ptr<CommandBuffer>& buffer : m_Buffers)
+	{
+		stats.Commands += (unsigned int)buffer->GetSize();
+		stats.ActiveBuffers += buffer->GetSize() > 0 ? 1 : 0;
+		stats.ArenaBytes += buffer->GetCapacityInBytes();
+	}
+	stats.MergeMilliseconds = m_MergeMilliseconds;
+	return stats;
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+class Texture;
+
+struct SpriteCommand
+{
+	uint64_t SortKey;
+	glm::vec2 Position;
+	glm::vec2 Size;
+	// (u0, v0, u1, v1), origin bottom left
+	glm::vec4 UV;
+	glm::vec4 Color;
+	const Texture* Image;
+};
+
+/**
+ * \brief Commands recorded by a single thread. They are stored in fixed size blocks that are kept from one frame
+ * to the next, so once the buffer has grown to a frame's worth of commands recording never allocates again and
+ * a command never moves once added.
+ */
+class CommandBuffer
+{
+public:
+	static const size_t BlockSize = 1024;
+
+	CommandBuffer();
+
+	CommandBuffer(const CommandBuffer&) = delete;
+	CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+	void Add(const SpriteCommand& command);
+	// Forgets the commands, the blocks stay
+	void Reset();
+
+	inline size_t GetSize() const
+	{
+		return m_Size;
+	}
+
+	inline const SpriteCommand& Get(size_t index) const
+	{
+		return m_Blocks[index / BlockSize][index % BlockSize];
+	}
+
+	inline size_t GetCapacityInBytes() const
+	{
+		return m_Blocks.size() * BlockSize * sizeof(SpriteCommand);
+	}
+private:
+	std::vector<std::unique_ptr<SpriteCommand[]>> m_Blocks;
+	size_t m_Size;
+};
+
+struct SortedCommand
+{
+	uint64_t Key;
+	const SpriteCommand* Command;
+};
+
+struct CommandRecorderStats
+{
+	unsigned int Commands;
+	// buffers that received at least one command, roughly how many threads took part
+	unsigned int ActiveBuffers;
+	size_t ArenaBytes;
+	double MergeMilliseconds;
+};
+
+/**
+ * \brief Lets jobs record sprites in parallel: every job system worker gets its own CommandBuffer, the threads
+ * outside the pool share one more, so recording needs no synchronization at all. Merge then sorts each buffer
+ * on the workers and merges the sorted runs into a single list for the thread owning the GL context.
+ *
+ * Keys are compared as plain integers. MakeKey puts the layer first and the material (the texture) second, so
+ * sprites of one layer sharing a texture end up next to each other and batch together. The order field keeps
+ * the result the same whichever worker recorded what, as long as every command of a frame has its own.
+ */
+class CommandRecorder
+{
+public:
+	static inline uint64_t MakeKey(unsigned int layer, unsigned int material, unsigned int order)
+	{
+		return (uint64_t)(layer & 0xFF) << 56 | (uint64_t)(material & 0xFFFFFF) << 32 | order;
+	}
+
+	CommandRecorder();
+
+	// Clears every buffer, one per worker of the job system as it is running now
+	void Begin();
+	// The buffer of the calling thread, the threads outside the job system must not record at the same time
+	CommandBuffer& GetBuffer();
+	// Every command recorded since Begin, sorted by key. Valid until the next Begin
+	const std::vector<SortedCommand>& Merge();
+
+	inline const std::vector<SortedCommand>& GetSorted() const
+	{
+		return m_Sorted;
+	}
+
+	CommandRecorderStats GetStats() const;
+private:
+	std::vector<std::unique_ptr<CommandBuffer>> m_Buffers;
+	// one sorted run per buffer, then the merged result. Cleared every frame, they keep their capacity
+	std::vector<SortedCommand> m_Runs;
+	std::vector<size_t> m_RunStarts;
+	std::vector<size_t> m_RunHeads;
+	std::vector<SortedCommand> m_Sorted;
+	double m_MergeMilliseconds;
+};
@@ -0,0 +1,43 @@
+#include "CookedAsset.h"
+
+#include <cstring>
+
+const CookedTextureHeader* CookedAsset::GetTexture(const unsigned char* data, size_t size)
+{
+	if (!data || size < sizeof(CookedTextureHeader))
+	{
+		return nullptr;
+	}
+	const CookedTextureHeader* header = (const CookedTextureHeader*)data;
+	if (std::memcmp(header->Magic, "CTEX", 4) != 0 || header->Version != Version || header->LevelCount == 0
+		|| header->Channels < 1 || header->Channels > 4
+		|| header->LevelCount > (size - sizeof(CookedTextureHeader)) / sizeof(CookedTextureLevel))
+	{
+		return nullptr;
+	}
+
+	const CookedTextureLevel* levels = GetTextureLevels(header);
+	for (uint32_t i = 0; i < header->LevelCount; ++i)
+	{
+		if (levels[i].Offset > size || levels[i].Size > size - levels[i].Offset)
+		{
+			return nullptr;
+		}
+	}
+	return header;
+}
+
+const CookedShaderHeader* CookedAsset::GetShader(const unsigned char* data, size_t size)
+{
+	if (!data || size < sizeof(CookedShaderHeader))
+	{
+		return nullptr;
+	}
+	const CookedShaderHeader* header = (const CookedShaderHeader*)data;
+	if (std::memcmp(header->Magic, "CSHD", 4) != 0 || header->Version != Version
+		|| (uint64_t)header->VertexSize + header->FragmentSize > size - sizeof(CookedShaderHeader))
+	{
+		return nullptr;
+	}
+	return header;
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Cooked texture layout: a CookedTextureHeader, LevelCount CookedTextureLevel records, then the data of every mip
+ * level down to 1x1 (level 0 first, each 16 byte aligned) exactly as glTexImage2D / glCompressedTexImage2D take
+ * it: rows already bottom-up, in the source channel count and depth, or BC blocks when cooked with compression.
+ * Cook with compression only for GPUs that support the format, cooked blocks are never decoded back.
+ */
+struct CookedTextureHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t Width, Height;
+	uint32_t Channels;
+	// GL_UNSIGNED_BYTE, GL_UNSIGNED_SHORT or GL_FLOAT
+	uint32_t Type;
+	// a TextureCompression
+	uint32_t Compression;
+	uint32_t LevelCount;
+	// FNV-1a of the source file, how the cooker tells an up to date output
+	uint64_t SourceHash;
+	// one texel of Type, see DecodedImage::ComputeAverage
+	unsigned char AverageTexel[16];
+};
+
+struct CookedTextureLevel
+{
+	uint64_t Offset;
+	uint64_t Size;
+	uint32_t Width, Height;
+};
+
+// Cooked shader layout: a CookedShaderHeader then the vertex and fragment sources, without comments or blank lines
+struct CookedShaderHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t VertexSize;
+	uint32_t FragmentSize;
+	uint64_t SourceHash;
+};
+
+/**
+ * \brief Recognizes cooked files. The loaders check every file they open, so cooked and source assets can be
+ * mixed freely under the same names, on disk or in a pack.
+ */
+class CookedAsset
+{
+public:
+	static const uint32_t Version = 1;
+
+	// nullptr unless data holds a whole cooked texture of this version, every level inside the buffer
+	static const CookedTextureHeader* GetTexture(const unsigned char* data, size_t size);
+	static const CookedShaderHeader* GetShader(const unsigned char* data, size_t size);
+
+	static inline const CookedTextureLevel* GetTextureLevels(const CookedTextureHeader* header)
+	{
+		return (const CookedTextureLevel*)(header + 1);
+	}
+};
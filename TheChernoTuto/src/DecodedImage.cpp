@@ -0,0 +1,164 @@
+#include "DecodedImage.h"
+
+#include "GL/glew.h"
+
+#include "ImageDecoder.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+
+namespace
+{
+	template<typename T>
+	T AverageOf(double sum, double count)
+	{
+		return (T)(sum / count + 0.5);
+	}
+
+	template<>
+	float AverageOf<float>(double sum, double count)
+	{
+		return (float)(sum / count);
+	}
+
+	template<typename T>
+	std::vector<unsigned char> HalveLevel(const unsigned char* source, int width, int height, int channels)
+	{
+		const T* pixels = (const T*)source;
+		const int halfWidth = DecodedImage::GetLevelDimension(width, 1);
+		const int halfHeight = DecodedImage::GetLevelDimension(height, 1);
+		std::vector<unsigned char> result((size_t)halfWidth * halfHeight * channels * sizeof(T));
+		T* dst = (T*)result.data();
+		for (int y = 0; y < halfHeight; ++y)
+		{
+			const int y0 = std::min(y * 2, height - 1), y1 = std::min(y * 2 + 1, height - 1);
+			for (int x = 0; x < halfWidth; ++x)
+			{
+				const int x0 = std::min(x * 2, width - 1), x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < channels; ++c)
+				{
+					const double sum = (double)pixels[((size_t)y0 * width + x0) * channels + c]
+						+ pixels[((size_t)y0 * width + x1) * channels + c]
+						+ pixels[((size_t)y1 * width + x0) * channels + c]
+						+ pixels[((size_t)y1 * width + x1) * channels + c];
+					dst[((size_t)y * halfWidth + x) * channels + c] = AverageOf<T>(sum, 4.0);
+				}
+			}
+		}
+		return result;
+	}
+
+	template<typename T>
+	std::vector<unsigned char> AverageTexel(const unsigned char* source, int width, int height, int channels)
+	{
+		const T* pixels = (const T*)source;
+		const size_t count = (size_t)width * height;
+		std::vector<unsigned char> texel(channels * sizeof(T));
+		for (int c = 0; c < channels; ++c)
+		{
+			double sum = 0.0;
+			for (size_t i = 0; i < count; ++i)
+			{
+				sum += pixels[i * channels + c];
+			}
+			((T*)texel.data())[c] = AverageOf<T>(sum, (double)count);
+		}
+		return texel;
+	}
+}
+
+DecodedImage::DecodedImage(const std::string& filepath)
+	:Pixels(nullptr), Width(0), Height(0), Channels(0), Type(GL_UNSIGNED_BYTE)
+{
+	// thread local so that level loaders on worker threads don't race with the main thread
+	stbi_set_flip_vertically_on_load_thread(1);
+
+	if (stbi_is_hdr(filepath.c_str()))
+	{
+		Pixels = (unsigned char*)stbi_loadf(filepath.c_str(), &Width, &Height, &Channels, 0);
+		Type = GL_FLOAT;
+	}
+	else if (stbi_is_16_bit(filepath.c_str()))
+	{
+		Pixels = (unsigned char*)stbi_load_16(filepath.c_str(), &Width, &Height, &Channels, 0);
+		Type = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		// PNG and QOI fast paths, detected from the signature rather than the extension
+		Pixels = ImageDecoder::Load(filepath, &Width, &Height, &Channels, 0, true);
+	}
+}
+
+DecodedImage::DecodedImage(const unsigned char* buffer, size_t length)
+	:Pixels(nullptr), Width(0), Height(0), Channels(0), Type(GL_UNSIGNED_BYTE)
+{
+	if (!buffer || length == 0)
+	{
+		return;
+	}
+	stbi_set_flip_vertically_on_load_thread(1);
+
+	if (stbi_is_hdr_from_memory(buffer, (int)length))
+	{
+		Pixels = (unsigned char*)stbi_loadf_from_memory(buffer, (int)length, &Width, &Height, &Channels, 0);
+		Type = GL_FLOAT;
+	}
+	else if (stbi_is_16_bit_from_memory(buffer, (int)length))
+	{
+		Pixels = (unsigned char*)stbi_load_16_from_memory(buffer, (int)length, &Width, &Height, &Channels, 0);
+		Type = GL_UNSIGNED_SHORT;
+	}
+	else
+	{
+		Pixels = ImageDecoder::LoadFromMemory(buffer, (int)length, &Width, &Height, &Channels, 0, true);
+	}
+}
+
+DecodedImage::~DecodedImage()
+{
+	if (!Pixels)
+	{
+		return;
+	}
+	if (Type == GL_UNSIGNED_BYTE)
+	{
+		ImageDecoder::Free(Pixels);
+	}
+	else
+	{
+		stbi_image_free(Pixels);
+	}
+}
+
+size_t DecodedImage::GetComponentSize(unsigned int type)
+{
+	return type == GL_UNSIGNED_BYTE ? 1 : type == GL_UNSIGNED_SHORT ? 2 : 4;
+}
+
+int DecodedImage::GetLevelDimension(int size, int level)
+{
+	return std::max(1, size >> level);
+}
+
+std::vector<unsigned char> DecodedImage::Halve(const unsigned char* pixels, int width, int height, int channels,
+	unsigned int type)
+{
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT: return HalveLevel<unsigned short>(pixels, width, height, channels);
+	case GL_FLOAT:          return HalveLevel<float>(pixels, width, height, channels);
+	default:                return HalveLevel<unsigned char>(pixels, width, height, channels);
+	}
+}
+
+std::vector<unsigned char> DecodedImage::ComputeAverage(const unsigned char* pixels, int width, int height,
+	int channels, unsigned int type)
+{
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT: return AverageTexel<unsigned short>(pixels, width, height, channels);
+	case GL_FLOAT:          return AverageTexel<float>(pixels, width, height, channels);
+	default:                return AverageTexel<unsigned char>(pixels, width, height, channels);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * \brief An image file decoded with its own channel count and depth instead of expanding everything to RGBA8:
+ * GL_FLOAT for HDR files, GL_UNSIGNED_SHORT for 16 bit ones, GL_UNSIGNED_BYTE otherwise. Rows are flipped to
+ * OpenGL's bottom-up order. Pixels is nullptr when the file couldn't be decoded.
+ *
+ * The static helpers work on any tightly packed pixels of those types and are shared by the texture
+ * streaming code and the offline cooker.
+ */
+class DecodedImage
+{
+public:
+	unsigned char* Pixels;
+	int Width, Height, Channels;
+	unsigned int Type;
+
+	explicit DecodedImage(const std::string& filepath);
+	// The encoded buffer is only read during the call
+	DecodedImage(const unsigned char* buffer, size_t length);
+	~DecodedImage();
+
+	DecodedImage(const DecodedImage&) = delete;
+	DecodedImage& operator=(const DecodedImage&) = delete;
+
+	static size_t GetComponentSize(unsigned int type);
+	static int GetLevelDimension(int size, int level);
+	// 2x2 box filter down to the next mip size, the last column / row is repeated for odd sizes
+	static std::vector<unsigned char> Halve(const unsigned char* pixels, int width, int height, int channels,
+		unsigned int type);
+	// One texel of the image's type, the color a texture is drawn with while it is not resident
+	static std::vector<unsigned char> ComputeAverage(const unsigned char* pixels, int width, int height, int channels,
+		unsigned int type);
+};
@@ -0,0 +1,246 @@
+#include "DeletionQueue.h"
+
+#include "Profiler.h"
+#include "Renderer.h"
+
+#include <utility>
+
+DeletionQueue::Batch DeletionQueue::s_Current;
+std::vector<DeletionQueue::Batch> DeletionQueue::s_Pending;
+std::vector<DeletionQueue::BufferEntry> DeletionQueue::s_FreeBuffers;
+std::vector<DeletionQueue::TextureEntry> DeletionQueue::s_FreeTextures;
+bool DeletionQueue::s_Recycling = true;
+unsigned long long DeletionQueue::s_Frame = 0;
+DeletionQueueStats DeletionQueue::s_Stats = {};
+
+void DeletionQueue::DeleteBuffer(unsigned int id, size_t size, unsigned int usage)
+{
+	if (id != 0)
+	{
+		s_Current.Buffers.push_back({ id, size, usage, 0 });
+	}
+}
+
+void DeletionQueue::DeleteTexture(unsigned int id, int width, int height, unsigned int internalFormat)
+{
+	if (id != 0)
+	{
+		s_Current.Textures.push_back({ id, width, height, internalFormat, 0 });
+	}
+}
+
+void DeletionQueue::DeleteVertexArray(unsigned int id)
+{
+	if (id != 0)
+	{
+		s_Current.VertexArrays.push_back(id);
+	}
+}
+
+void DeletionQueue::DeleteProgram(unsigned int id)
+{
+	if (id != 0)
+	{
+		s_Current.Programs.push_back(id);
+	}
+}
+
+unsigned int DeletionQueue::AcquireBuffer(size_t size, unsigned int usage)
+{
+	// most recently released first, the likeliest to still be in the driver's caches
+	for (size_t i = s_FreeBuffers.size(); i-- > 0;)
+	{
+		if (s_FreeBuffers[i].Size == size && s_FreeBuffers[i].Usage == usage)
+		{
+			const unsigned int id = s_FreeBuffers[i].ID;
+			s_FreeBuffers.erase(s_FreeBuffers.begin() + i);
+			++s_Stats.RecycledBuffers;
+			return id;
+		}
+	}
+	return 0;
+}
+
+unsigned int DeletionQueue::AcquireTexture(int width, int height, unsigned int internalFormat)
+{
+	for (size_t i = s_FreeTextures.size(); i-- > 0;)
+	{
+		const TextureEntry& entry = s_FreeTextures[i];
+		if (entry.Width == width && entry.Height == height && entry.InternalFormat == internalFormat)
+		{
+			const unsigned int id = entry.ID;
+			s_FreeTextures.erase(s_FreeTextures.begin() + i);
+			++s_Stats.RecycledTextures;
+			return id;
+		}
+	}
+	return 0;
+}
+
+void DeletionQueue::SetRecycling(bool recycling)
+{
+	s_Recycling = recycling;
+	if (!recycling)
+	{
+		DeleteIdle(true);
+	}
+}
+
+bool DeletionQueue::IsEmpty(const Batch& batch)
+{
+	return batch.Buffers.empty() && batch.Textures.empty() && batch.VertexArrays.empty() && batch.Programs.empty();
+}
+
+void DeletionQueue::Retire(Batch& batch, bool recycle)
+{
+	std::vector<unsigned int> buffers, textures;
+	for (BufferEntry& entry : batch.Buffers)
+	{
+		if (recycle && s_FreeBuffers.size() + s_FreeTextures.size() < MaxFreeObjects)
+		{
+			entry.ReleaseFrame = s_Frame;
+			s_FreeBuffers.push_back(entry);
+		}
+		else
+		{
+			buffers.push_back(entry.ID);
+		}
+	}
+	for (TextureEntry& entry : batch.Textures)
+	{
+		if (recycle && entry.InternalFormat != 0 && s_FreeBuffers.size() + s_FreeTextures.size() < MaxFreeObjects)
+		{
+			entry.ReleaseFrame = s_Frame;
+			s_FreeTextures.push_back(entry);
+		}
+		else
+		{
+			textures.push_back(entry.ID);
+		}
+	}
+	DeleteObjects(buffers, textures);
+
+	if (!batch.VertexArrays.empty())
+	{
+		GlCall(glDeleteVertexArrays((GLsizei)batch.VertexArrays.size(), batch.VertexArrays.data()));
+		++s_Stats.DeleteCalls;
+		s_Stats.DeletedObjects += (unsigned int)batch.VertexArrays.size();
+	}
+	// programs have no batched delete
+	for (unsigned int program : batch.Programs)
+	{
+		GlCall(glDeleteProgram(program));
+		++s_Stats.DeleteCalls;
+		++s_Stats.DeletedObjects;
+	}
+	batch = Batch();
+}
+
+void DeletionQueue::DeleteObjects(const std::vector<unsigned int>& buffers, const std::vector<unsigned int>& textures)
+{
+	if (!buffers.empty())
+	{
+		GlCall(glDeleteBuffers((GLsizei)buffers.size(), buffers.data()));
+		++s_Stats.DeleteCalls;
+		s_Stats.DeletedObjects += (unsigned int)buffers.size();
+	}
+	if (!textures.empty())
+	{
+		GlCall(glDeleteTextures((GLsizei)textures.size(), textures.data()));
+		++s_Stats.DeleteCalls;
+		s_Stats.DeletedObjects += (unsigned int)textures.size();
+	}
+}
+
+void DeletionQueue::DeleteIdle(bool all)
+{
+	std::vector<unsigned int> buffers, textures;
+	for (size_t i = 0; i < s_FreeBuffers.size();)
+	{
+		if (all || s_Frame - s_FreeBuffers[i].ReleaseFrame > MaxIdleFrames)
+		{
+			buffers.push_back(s_FreeBuffers[i].ID);
+			s_FreeBuffers.erase(s_FreeBuffers.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+	for (size_t i = 0; i < s_FreeTextures.size();)
+	{
+		if (all || s_Frame - s_FreeTextures[i].ReleaseFrame > MaxIdleFrames)
+		{
+			textures.push_back(s_FreeTextures[i].ID);
+			s_FreeTextures.erase(s_FreeTextures.begin() + i);
+		}
+		else
+		{
+			++i;
+		}
+	}
+	DeleteObjects(buffers, textures);
+}
+
+void DeletionQueue::EndFrame()
+{
+	PROFILE_FUNCTION();
+	// fences signal in submission order, stop at the first one still running
+	size_t retired = 0;
+	for (; retired < s_Pending.size(); ++retired)
+	{
+		GLsync fence = (GLsync)s_Pending[retired].Fence;
+		GlCall(GLenum status = glClientWaitSync(fence, 0, 0));
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+		GlCall(glDeleteSync(fence));
+		Retire(s_Pending[retired], s_Recycling);
+	}
+	s_Pending.erase(s_Pending.begin(), s_Pending.begin() + retired);
+
+	if (!IsEmpty(s_Current))
+	{
+		GlCall(s_Current.Fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+		s_Pending.push_back(std::move(s_Current));
+		s_Current = Batch();
+	}
+
+	DeleteIdle(false);
+	++s_Frame;
+}
+
+void DeletionQueue::Flush()
+{
+	for (Batch& batch : s_Pending)
+	{
+		GlCall(glDeleteSync((GLsync)batch.Fence));
+		Retire(batch, false);
+	}
+	s_Pending.clear();
+	Retire(s_Current, false);
+	DeleteIdle(true);
+	s_Stats = DeletionQueueStats();
+}
+
+DeletionQueueStats DeletionQueue::GetStats()
+{
+	DeletionQueueStats stats = s_Stats;
+	stats.PendingObjects = 0;
+	for (const Batch& batch : s_Pending)
+	{
+		stats.PendingObjects += (unsigned int)(batch.Buffers.size() + batch.Textures.size() + batch.VertexArrays.size()
+			+ batch.Programs.size());
+	}
+	stats.PendingObjects += (unsigned int)(s_Current.Buffers.size() + s_Current.Textures.size()
+		+ s_Current.VertexArrays.size() + s_Current.Programs.size());
+	stats.FreeBuffers = (unsigned int)s_FreeBuffers.size();
+	stats.FreeTextures = (unsigned int)s_FreeTextures.size();
+	stats.FreeBufferBytes = 0;
+	for (const BufferEntry& entry : s_FreeBuffers)
+	{
+		stats.FreeBufferBytes += entry.Size;
+	}
+	return stats;
+}
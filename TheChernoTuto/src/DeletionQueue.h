@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+struct DeletionQueueStats
+{
+	// waiting for the fence of the frame that released them
+	unsigned int PendingObjects;
+	// released and kept around to be handed out again
+	unsigned int FreeBuffers;
+	unsigned int FreeTextures;
+	size_t FreeBufferBytes;
+	// totals since the last Flush
+	unsigned int DeleteCalls;
+	unsigned int DeletedObjects;
+	unsigned int RecycledBuffers;
+	unsigned int RecycledTextures;
+};
+
+/**
+ * \brief Collects the GL objects released by the wrappers during a frame instead of deleting them on the spot.
+ * EndFrame puts a fence behind the frame's releases, and once a fence has signaled its objects are deleted with
+ * one glDelete*(n, ids) call per type. Buffers and uncompressed textures can instead go to a free list that
+ * hands them back out to a new object of the same size and format, so the wrappers only refill their storage.
+ * Free objects nobody asked for within MaxIdleFrames are deleted as well.
+ */
+class DeletionQueue
+{
+public:
+	static const unsigned int MaxFreeObjects = 64;
+	static const unsigned int MaxIdleFrames = 120;
+
+	static void DeleteBuffer(unsigned int id, size_t size, unsigned int usage);
+	// width, height and internalFormat describe level 0, 0 for textures that must not be reused
+	static void DeleteTexture(unsigned int id, int width, int height, unsigned int internalFormat);
+	static void DeleteVertexArray(unsigned int id);
+	static void DeleteProgram(unsigned int id);
+
+	// A released object with exactly that storage, 0 when there is none and a new one has to be created
+	static unsigned int AcquireBuffer(size_t size, unsigned int usage);
+	static unsigned int AcquireTexture(int width, int height, unsigned int internalFormat);
+
+	static void SetRecycling(bool recycling);
+
+	inline static bool GetRecycling()
+	{
+		return s_Recycling;
+	}
+
+	// Once per frame after the last draw: fences this frame's releases and deletes what the GPU is done with
+	static void EndFrame();
+	// Deletes everything right away, for shutdown while the context is still current
+	static void Flush();
+
+	static DeletionQueueStats GetStats();
+private:
+	struct BufferEntry
+	{
+		unsigned int ID;
+		size_t Size;
+		unsigned int Usage;
+		unsigned long long ReleaseFrame;
+	};
+
+	struct TextureEntry
+	{
+		unsigned int ID;
+		int Width, Height;
+		unsigned int InternalFormat;
+		unsigned long long ReleaseFrame;
+	};
+
+	struct Batch
+	{
+		// GLsync, null while the batch is still being filled
+		void* Fence = nullptr;
+		std::vector<BufferEntry> Buffers;
+		std::vector<TextureEntry> Textures;
+		std::vector<unsigned int> VertexArrays;
+		std::vector<unsigned int> Programs;
+	};
+
+	static bool IsEmpty(const Batch& batch);
+	// Deletes the batch's objects, or moves buffers and textures to the free lists while there is room
+	static void Retire(Batch& batch, bool recycle);
+	static void DeleteObjects(const std::vector<unsigned int>& buffers, const std::vector<unsigned int>& textures);
+	static void DeleteIdle(bool all);
+
+	static Batch s_Current;
+	static std::vector<Batch> s_Pending;
+	static std::vector<BufferEntry> s_FreeBuffers;
+	static std::vector<TextureEntry> s_FreeTextures;
+	static bool s_Recycling;
+	static unsigned long long s_Frame;
+	static DeletionQueueStats s_Stats;
+};
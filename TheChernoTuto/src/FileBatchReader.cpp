@@ -0,0 +1,509 @@
+#include "FileBatchReader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <numeric>
+#include <thread>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define FILE_BATCH_READER_IO_URING
+#endif
+#endif
+
+#ifdef FILE_BATCH_READER_IO_URING
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+std::atomic<bool> FileBatchReader::s_UseIoUring(true);
+
+namespace
+{
+	bool ReadWholeFile(FileReadRequest& request)
+	{
+		std::ifstream file(request.Filepath, std::ios::binary | std::ios::ate);
+		if (!file)
+		{
+			return false;
+		}
+		const std::streamoff size = file.tellg();
+		file.seekg(0);
+		// directories open fine on some platforms and report a bogus size, but nothing can be read from them
+		if (size < 0 || file.peek() == std::char_traits<char>::eof())
+		{
+			return size == 0;
+		}
+		request.Data.resize((size_t)size);
+		return size == 0 || (bool)file.read((char*)request.Data.data(), size);
+	}
+
+#ifdef FILE_BATCH_READER_IO_URING
+	// a single read's length is 32 bit
+	const size_t MaxChunk = (size_t)1 << 30;
+
+	// The submission and completion rings shared with the kernel, mapped as the io_uring_setup man page describes
+	class Ring
+	{
+	public:
+		Ring()
+			:m_Descriptor(-1), m_SubmissionRing(MAP_FAILED), m_CompletionRing(MAP_FAILED), m_Entries(MAP_FAILED),
+			m_SubmissionSize(0), m_CompletionSize(0), m_EntriesSize(0)
+		{
+		}
+
+		~Ring()
+		{
+			if (m_Entries != MAP_FAILED)
+			{
+				munmap(m_Entries, m_EntriesSize);
+			}
+			if (m_CompletionRing != MAP_FAILED && m_CompletionRing != m_SubmissionRing)
+			{
+				munmap(m_CompletionRing, m_CompletionSize);
+			}
+			if (m_SubmissionRing != MAP_FAILED)
+			{
+				munmap(m_SubmissionRing, m_SubmissionSize);
+			}
+			if (m_Descriptor >= 0)
+			{
+				close(m_Descriptor);
+			}
+		}
+
+		Ring(const Ring&) = delete;
+		Ring& operator=(const Ring&) = delete;
+
+		bool Setup(unsigned int entries)
+		{
+			io_uring_params params;
+			std::memset(&params, 0, sizeof(params));
+			m_Descriptor = (int)syscall(__NR_io_uring_setup, entries, &params);
+			if (m_Descriptor < 0)
+			{
+				return false;
+			}
+
+			m_SubmissionSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+			m_CompletionSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+			const bool singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+			if (singleMap)
+			{
+				m_SubmissionSize = m_CompletionSize = std::max(m_SubmissionSize, m_CompletionSize);
+			}
+			m_SubmissionRing = mmap(nullptr, m_SubmissionSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+				m_Descriptor, IORING_OFF_SQ_RING);
+			if (m_SubmissionRing == MAP_FAILED)
+			{
+				return false;
+			}
+			m_CompletionRing = singleMap ? m_SubmissionRing : mmap(nullptr, m_CompletionSize, PROT_READ | PROT_WRITE,
+				MAP_SHARED | MAP_POPULATE, m_Descriptor, IORING_OFF_CQ_RING);
+			m_EntriesSize = params.sq_entries * sizeof(io_uring_sqe);
+			m_Entries = mmap(nullptr, m_EntriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_Descriptor,
+				IORING_OFF_SQES);
+			if (m_CompletionRing == MAP_FAILED || m_Entries == MAP_FAILED)
+			{
+				return false;
+			}
+
+			unsigned char* submission = (unsigned char*)m_SubmissionRing;
+			m_SubmissionTail = (unsigned int*)(submission + params.sq_off.tail);
+			m_SubmissionMask = *(unsigned int*)(submission + params.sq_off.ring_mask);
+			m_SubmissionArray = (unsigned int*)(submission + params.sq_off.array);
+			unsigned char* completion = (unsigned char*)m_CompletionRing;
+			m_CompletionHead = (unsigned int*)(completion + params.cq_off.head);
+			m_CompletionTail = (unsigned int*)(completion + params.cq_off.tail);
+			m_CompletionMask = *(unsigned int*)(completion + params.cq_off.ring_mask);
+			m_Completions = (io_uring_cqe*)(completion + params.cq_off.cqes);
+			m_Capacity = params.sq_entries;
+			// IORING_OP_READ came with 5.6, older kernels take the ring but fail every read with -EINVAL
+			return SupportsOperation(IORING_OP_READ);
+		}
+
+		inline unsigned int GetCapacity() const
+		{
+			return m_Capacity;
+		}
+
+		// Only queues the read, Enter hands it to the kernel
+		void PushRead(int descriptor, unsigned char* buffer, unsigned int length, uint64_t offset, uint64_t userData)
+		{
+			const unsigned int tail = *m_SubmissionTail;
+			const unsigned int index = tail & m_SubmissionMask;
+			io_uring_sqe& entry = ((io_uring_sqe*)m_Entries)[index];
+			std::memset(&entry, 0, sizeof(entry));
+			entry.opcode = IORING_OP_READ;
+			entry.fd = descriptor;
+			entry.addr = (uint64_t)(uintptr_t)buffer;
+			entry.len = length;
+			entry.off = offset;
+			entry.user_data = userData;
+			m_SubmissionArray[index] = index;
+			// the kernel must see the entry before the new tail
+			__atomic_store_n(m_SubmissionTail, tail + 1, __ATOMIC_RELEASE);
+		}
+
+		// Submits up to count queued reads and waits for at least one completion unless some were left over. Returns
+		// how many the kernel took, the rest stay queued for the next call, or -1 once the ring is unusable
+		long Enter(unsigned int count)
+		{
+			while (true)
+			{
+				const long result = syscall(__NR_io_uring_enter, m_Descriptor, count, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+				if (result >= 0)
+				{
+					return result;
+				}
+				// short of memory, or completions to reap before more can go out
+				if (errno == EAGAIN || errno == EBUSY)
+				{
+					return 0;
+				}
+				if (errno != EINTR)
+				{
+					return -1;
+				}
+			}
+		}
+
+		template<typename F>
+		void ForEachCompletion(F handle)
+		{
+			unsigned int head = *m_CompletionHead;
+			const unsigned int tail = __atomic_load_n(m_CompletionTail, __ATOMIC_ACQUIRE);
+			for (; head != tail; ++head)
+			{
+				const io_uring_cqe& completion = m_Completions[head & m_CompletionMask];
+				handle(completion.user_data, completion.res);
+			}
+			__atomic_store_n(m_CompletionHead, head, __ATOMIC_RELEASE);
+		}
+	private:
+		// The probe came with 5.6 too, kernels without it refuse the register call
+		bool SupportsOperation(unsigned int operation) const
+		{
+			const unsigned int count = 256;
+			std::vector<unsigned char> buffer(sizeof(io_uring_probe) + count * sizeof(io_uring_probe_op));
+			io_uring_probe* probe = (io_uring_probe*)buffer.data();
+			if (syscall(__NR_io_uring_register, m_Descriptor, IORING_REGISTER_PROBE, probe, count) < 0)
+			{
+				return false;
+			}
+			return operation <= probe->last_op && (probe->ops[operation].flags & IO_URING_OP_SUPPORTED) != 0;
+		}
+
+		int m_Descriptor;
+		void* m_SubmissionRing;
+		void* m_CompletionRing;
+		void* m_Entries;
+		size_t m_SubmissionSize, m_CompletionSize, m_EntriesSize;
+		unsigned int* m_SubmissionTail = nullptr;
+		unsigned int* m_SubmissionArray = nullptr;
+		unsigned int m_SubmissionMask = 0;
+		unsigned int* m_CompletionHead = nullptr;
+		unsigned int* m_CompletionTail = nullptr;
+		unsigned int m_CompletionMask = 0;
+		io_uring_cqe* m_Completions = nullptr;
+		unsigned int m_Capacity = 0;
+	};
+#endif
+}
+
+FileBatchReaderStats FileBatchReader::Read(std::vector<FileReadRequest>& requests, const CompletionCallback& onComplete,
+	unsigned int threadCount)
+{
+	const auto start = std::chrono::high_resolution_clock::now();
+	FileBatchReaderStats stats = {};
+	stats.Backend = FileReadBackend::ThreadPool;
+	for (FileReadRequest& request : requests)
+	{
+		request.Data.clear();
+		request.Succeeded = false;
+	}
+
+	// a ring that can't be set up leaves every request untouched, the pool takes over, and so it does for the
+	// requests a ring that broke down midway left unfinished
+	std::vector<size_t> leftover;
+	if (!s_UseIoUring.load(std::memory_order_relaxed) || !ReadWithIoUring(requests, onComplete, stats, leftover))
+	{
+		stats.Backend = FileReadBackend::ThreadPool;
+		stats.Submissions = 0;
+		leftover.resize(requests.size());
+		std::iota(leftover.begin(), leftover.end(), (size_t)0);
+	}
+	if (!leftover.empty())
+	{
+		ReadWithThreads(requests, leftover, onComplete, threadCount);
+	}
+
+	stats.Files = (unsigned int)requests.size();
+	for (const FileReadRequest& request : requests)
+	{
+		stats.Failures += request.Succeeded ? 0 : 1;
+		stats.Bytes += request.Data.size();
+	}
+	const auto elapsed = std::chrono::high_resolution_clock::now() - start;
+	stats.Milliseconds = std::chrono::duration<double, std::milli>(elapsed).count();
+	return stats;
+}
+
+bool FileBatchReader::ReadWithIoUring(std::vector<FileReadRequest>& requests, const CompletionCallback& onComplete,
+	FileBatchReaderStats& stats, std::vector<size_t>& leftover)
+{
+#ifdef FILE_BATCH_READER_IO_URING
+	Ring ring;
+	if (!ring.Setup(QueueDepth))
+	{
+		return false;
+	}
+	stats.Backend = FileReadBackend::IoUring;
+
+	struct Chunk
+	{
+		size_t Request;
+		uint64_t Offset;
+		size_t Length;
+	};
+
+	std::vector<int> descriptors(requests.size(), -1);
+	std::vector<size_t> remaining(requests.size(), 0);
+	std::deque<Chunk> chunks;
+	auto finish = [&](size_t index, bool succeeded)
+	{
+		if (descriptors[index] >= 0)
+		{
+			close(descriptors[index]);
+			descriptors[index] = -1;
+		}
+		requests[index].Succeeded = succeeded;
+		if (!succeeded)
+		{
+			requests[index].Data.clear();
+		}
+		if (onComplete)
+		{
+			onComplete(index);
+		}
+	};
+
+	// sizes first, so every buffer exists before the first read goes out
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		const int descriptor = open(requests[i].Filepath.c_str(), O_RDONLY | O_CLOEXEC);
+		struct stat status;
+		if (descriptor < 0 || fstat(descriptor, &status) != 0 || !S_ISREG(status.st_mode))
+		{
+			if (descriptor >= 0)
+			{
+				close(descriptor);
+			}
+			finish(i, false);
+			continue;
+		}
+		descriptors[i] = descriptor;
+		remaining[i] = (size_t)status.st_size;
+		requests[i].Data.resize(remaining[i]);
+		if (remaining[i] == 0)
+		{
+			finish(i, true);
+			continue;
+		}
+		for (size_t offset = 0; offset < remaining[i]; offset += MaxChunk)
+		{
+			chunks.push_back({ i, offset, std::min(MaxChunk, remaining[i] - offset) });
+		}
+	}
+
+	// user data is the chunk's slot in flight, its request may still need more chunks
+	std::vector<Chunk> inFlight(ring.GetCapacity());
+	std::vector<unsigned int> freeSlots;
+	for (unsigned int slot = ring.GetCapacity(); slot > 0; --slot)
+	{
+		freeSlots.push_back(slot - 1);
+	}
+	// queued counts the reads pushed but not yet taken by the kernel, active those it took and hasn't completed
+	unsigned int queued = 0;
+	unsigned int active = 0;
+	// a failed request only finishes once none of its chunks is queued or active, they still write into its buffer
+	std::vector<bool> failed(requests.size(), false);
+	std::vector<unsigned int> chunksInFlight(requests.size(), 0);
+
+	while (!chunks.empty() || queued > 0 || active > 0)
+	{
+		while (!chunks.empty() && !freeSlots.empty())
+		{
+			const Chunk chunk = chunks.front();
+			chunks.pop_front();
+			if (failed[chunk.Request])
+			{
+				continue;
+			}
+			const unsigned int slot = freeSlots.back();
+			freeSlots.pop_back();
+			inFlight[slot] = chunk;
+			++chunksInFlight[chunk.Request];
+			ring.PushRead(descriptors[chunk.Request], requests[chunk.Request].Data.data() + chunk.Offset,
+				(unsigned int)chunk.Length, chunk.Offset, slot);
+			++queued;
+		}
+		if (queued == 0 && active == 0)
+		{
+			break;
+		}
+
+		++stats.Submissions;
+		const long submitted = ring.Enter(queued);
+		if (submitted < 0)
+		{
+			// the reads the kernel took still write into their buffers, wait them out before anything is handed over
+			while (active > 0)
+			{
+				if (ring.Enter(0) < 0)
+				{
+					std::this_thread::yield();
+				}
+				ring.ForEachCompletion([&](uint64_t, int) { --active; });
+			}
+			for (size_t i = 0; i < requests.size(); ++i)
+			{
+				if (descriptors[i] >= 0)
+				{
+					close(descriptors[i]);
+					descriptors[i] = -1;
+					requests[i].Data.clear();
+					leftover.push_back(i);
+				}
+			}
+			return true;
+		}
+		queued -= (unsigned int)submitted;
+		active += (unsigned int)submitted;
+
+		ring.ForEachCompletion([&](uint64_t slot, int result)
+		{
+			const Chunk chunk = inFlight[(size_t)slot];
+			freeSlots.push_back((unsigned int)slot);
+			--active;
+			--chunksInFlight[chunk.Request];
+			if (failed[chunk.Request])
+			{
+				if (chunksInFlight[chunk.Request] == 0)
+				{
+					finish(chunk.Request, false);
+				}
+				return;
+			}
+
+			if (result == -EINTR || result == -EAGAIN)
+			{
+				chunks.push_front(chunk);
+				return;
+			}
+			// errors and a file that shrank since it was sized
+			if (result <= 0)
+			{
+				failed[chunk.Request] = true;
+				if (chunksInFlight[chunk.Request] == 0)
+				{
+					finish(chunk.Request, false);
+				}
+				return;
+			}
+			if ((size_t)result < chunk.Length)
+			{
+				chunks.push_front({ chunk.Request, chunk.Offset + result, chunk.Length - result });
+			}
+			remaining[chunk.Request] -= (size_t)result;
+			if (remaining[chunk.Request] == 0)
+			{
+				finish(chunk.Request, true);
+			}
+		});
+	}
+	return true;
+#else
+	(void)requests;
+	(void)onComplete;
+	(void)stats;
+	(void)leftover;
+	return false;
+#endif
+}
+
+void FileBatchReader::ReadWithThreads(std::vector<FileReadRequest>& requests, const std::vector<size_t>& indices,
+	const CompletionCallback& onComplete, unsigned int threadCount)
+{
+	std::atomic<size_t> next(0);
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < indices.size(); i = next++)
+		{
+			const size_t index = indices[i];
+			FileReadRequest& request = requests[index];
+			request.Succeeded = ReadWholeFile(request);
+			if (!request.Succeeded)
+			{
+				request.Data.clear();
+			}
+			if (onComplete)
+			{
+				onComplete(index);
+			}
+		}
+	};
+
+	unsigned int workers = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	workers = (unsigned int)std::min<size_t>(workers, indices.size());
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < workers; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
+
+bool FileBatchReader::IsIoUringSupported()
+{
+#ifdef FILE_BATCH_READER_IO_URING
+	// disabled kernels (kernel.io_uring_disabled) and seccomp filters refuse the setup call, kernels before 5.6
+	// can't do plain reads
+	static const bool supported = []()
+	{
+		Ring ring;
+		return ring.Setup(1);
+	}();
+	return supported;
+#else
+	return false;
+#endif
+}
+
+void FileBatchReader::SetUseIoUring(bool enabled)
+{
+	s_UseIoUring.store(enabled, std::memory_order_relaxed);
+}
+
+bool FileBatchReader::GetUseIoUring()
+{
+	return s_UseIoUring.load(std::memory_order_relaxed);
+}
+
+const char* FileBatchReader::GetBackendName(FileReadBackend backend)
+{
+	return backend == FileReadBackend::IoUring ? "io_uring" : "thread pool";
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct FileReadRequest
+{
+	// input
+	std::string Filepath;
+
+	// output, Data holds the whole file when Succeeded
+	std::vector<unsigned char> Data;
+	bool Succeeded = false;
+};
+
+enum class FileReadBackend
+{
+	IoUring,
+	ThreadPool
+};
+
+struct FileBatchReaderStats
+{
+	FileReadBackend Backend;
+	unsigned int Files;
+	unsigned int Failures;
+	size_t Bytes;
+	// io_uring_enter calls, 0 for the thread pool
+	unsigned int Submissions;
+	double Milliseconds;
+};
+
+/**
+ * \brief Reads a whole set of files at once instead of one blocking read after the other. Every file is opened and
+ * sized first so its buffer is allocated up front, then the reads are issued together.
+ *
+ * On Linux they go through io_uring, QueueDepth reads in flight at a time (files over 1 GB are read in chunks,
+ * short reads are resubmitted), so the disk always has the whole queue to work on. Elsewhere, or when the kernel
+ * refuses io_uring or predates its plain reads (5.6), a pool of threads doing blocking reads gives the same
+ * overlap. The ring is set up with raw system calls, there is no liburing dependency.
+ */
+class FileBatchReader
+{
+public:
+	static const unsigned int QueueDepth = 64;
+
+	// Runs once per file as soon as its read finished (or failed), on a reading thread: the io_uring thread or
+	// any of the pool's threads concurrently
+	using CompletionCallback = std::function<void(size_t index)>;
+
+	// Blocks until every request completed, threadCount only applies to the thread pool (0 for every core)
+	static FileBatchReaderStats Read(std::vector<FileReadRequest>& requests,
+		const CompletionCallback& onComplete = nullptr, unsigned int threadCount = 0);
+
+	static bool IsIoUringSupported();
+	// Off forces the thread pool even where io_uring works, to compare both
+	static void SetUseIoUring(bool enabled);
+	static bool GetUseIoUring();
+	static const char* GetBackendName(FileReadBackend backend);
+private:
+	// False when no ring could be set up, leftover gets the requests a ring failing midway left for the pool
+	static bool ReadWithIoUring(std::vector<FileReadRequest>& requests, const CompletionCallback& onComplete,
+		FileBatchReaderStats& stats, std::vector<size_t>& leftover);
+	static void ReadWithThreads(std::vector<FileReadRequest>& requests, const std::vector<size_t>& indices,
+		const CompletionCallback& onComplete, unsigned int threadCount);
+
+	// toggled from the UI while batches are read on other threads
+	static std::atomic<bool> s_UseIoUring;
+};
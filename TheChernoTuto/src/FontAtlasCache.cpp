@@ -0,0 +1,256 @@
+#include "FontAtlasCache.h"
+
+#include "MappedFile.h"
+#include "PackFile.h"
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace
+{
+	template<typename T>
+	uint64_t HashValue(const T& value, uint64_t hash)
+	{
+		return PackFile::Hash((const unsigned char*)&value, sizeof(value), hash);
+	}
+
+	// custom glyphs are added to their font again by every build, a restored glyph table would get them twice
+	bool HasCustomGlyphs(const ImFontAtlas& atlas)
+	{
+		for (const ImFontAtlasCustomRect& rect : atlas.CustomRects)
+		{
+			if (rect.Font != nullptr)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+uint64_t FontAtlasCache::ComputeKey(const ImFontAtlas& atlas)
+{
+	const uint32_t version = Version;
+	uint64_t hash = PackFile::Hash(nullptr, 0);
+	hash = HashValue(version, hash);
+	hash = HashValue(IMGUI_VERSION_NUM, hash);
+	hash = HashValue(sizeof(ImFontGlyph), hash);
+	hash = HashValue(atlas.Flags, hash);
+	hash = HashValue(atlas.TexDesiredWidth, hash);
+	hash = HashValue(atlas.TexGlyphPadding, hash);
+	hash = HashValue(atlas.FontBuilderFlags, hash);
+	for (const ImFontAtlasCustomRect& rect : atlas.CustomRects)
+	{
+		hash = HashValue(rect.Width, hash);
+		hash = HashValue(rect.Height, hash);
+	}
+
+	for (const ImFontConfig& config : atlas.ConfigData)
+	{
+		// the bytes rather than the file name, an edited font file gets a new key
+		hash = PackFile::Hash((const unsigned char*)config.FontData, (size_t)config.FontDataSize, hash);
+		hash = HashValue(config.FontNo, hash);
+		hash = HashValue(config.SizePixels, hash);
+		hash = HashValue(config.OversampleH, hash);
+		hash = HashValue(config.OversampleV, hash);
+		hash = HashValue(config.PixelSnapH, hash);
+		hash = HashValue(config.GlyphExtraSpacing, hash);
+		hash = HashValue(config.GlyphOffset, hash);
+		hash = HashValue(config.GlyphMinAdvanceX, hash);
+		hash = HashValue(config.GlyphMaxAdvanceX, hash);
+		hash = HashValue(config.MergeMode, hash);
+		hash = HashValue(config.FontBuilderFlags, hash);
+		hash = HashValue(config.RasterizerMultiply, hash);
+		hash = HashValue(config.RasterizerDensity, hash);
+		hash = HashValue(config.EllipsisChar, hash);
+		// no ranges means the default ones, which are fixed for a given ImGui version
+		for (const ImWchar* range = config.GlyphRanges; range && *range; ++range)
+		{
+			hash = HashValue(*range, hash);
+		}
+		hash = HashValue((ImWchar)0, hash);
+	}
+	return hash;
+}
+
+bool FontAtlasCache::Build(ImFontAtlas& atlas, const std::string& filepath)
+{
+	if (HasCustomGlyphs(atlas))
+	{
+		atlas.Build();
+		return false;
+	}
+
+	const uint64_t key = ComputeKey(atlas);
+	if (Load(atlas, filepath, key))
+	{
+		return true;
+	}
+	if (atlas.Build())
+	{
+		Save(atlas, filepath, key);
+	}
+	return false;
+}
+
+bool FontAtlasCache::Load(ImFontAtlas& atlas, const std::string& filepath, uint64_t key)
+{
+	// a missing file is the usual first run, not worth a message
+	if (!std::ifstream(filepath))
+	{
+		return false;
+	}
+	MappedFile file;
+	if (!file.Open(filepath) || file.GetSize() < sizeof(FontAtlasCacheHeader))
+	{
+		return false;
+	}
+
+	// everything is checked before the atlas is touched, a stale or truncated file just means a normal build
+	const unsigned char* data = file.GetData();
+	const unsigned char* end = data + file.GetSize();
+	FontAtlasCacheHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	data += sizeof(header);
+	if (std::memcmp(header.Magic, "FONT", 4) != 0 || header.Version != Version || header.Key != key
+		|| (header.BytesPerPixel != 1 && header.BytesPerPixel != 4) || header.FontCount != (uint32_t)atlas.Fonts.Size
+		|| header.Width == 0 || header.Height == 0 || header.Width > 16384 || header.Height > 16384)
+	{
+		return false;
+	}
+
+	if ((size_t)(end - data) < header.RectCount * sizeof(FontAtlasCacheRect))
+	{
+		return false;
+	}
+	std::vector<FontAtlasCacheRect> rects(header.RectCount);
+	std::memcpy(rects.data(), data, rects.size() * sizeof(FontAtlasCacheRect));
+	data += rects.size() * sizeof(FontAtlasCacheRect);
+
+	std::vector<FontAtlasCacheFont> fonts(header.FontCount);
+	std::vector<const unsigned char*> glyphs(header.FontCount);
+	for (uint32_t i = 0; i < header.FontCount; ++i)
+	{
+		if ((size_t)(end - data) < sizeof(FontAtlasCacheFont))
+		{
+			return false;
+		}
+		std::memcpy(&fonts[i], data, sizeof(FontAtlasCacheFont));
+		data += sizeof(FontAtlasCacheFont);
+		if (fonts[i].GlyphCount == 0 || (size_t)(end - data) / sizeof(ImFontGlyph) < fonts[i].GlyphCount)
+		{
+			return false;
+		}
+		glyphs[i] = data;
+		data += fonts[i].GlyphCount * sizeof(ImFontGlyph);
+	}
+
+	const size_t pixelBytes = (size_t)header.Width * header.Height * header.BytesPerPixel;
+	if ((size_t)(end - data) != pixelBytes)
+	{
+		return false;
+	}
+
+	// registers the mouse cursor and line rectangles, and rounds the sizes, exactly as a build starts
+	atlas.ClearTexData();
+	ImFontAtlasBuildInit(&atlas);
+	if (atlas.CustomRects.Size != (int)header.RectCount)
+	{
+		return false;
+	}
+	for (int i = 0; i < atlas.CustomRects.Size; ++i)
+	{
+		atlas.CustomRects[i].X = rects[i].X;
+		atlas.CustomRects[i].Y = rects[i].Y;
+	}
+
+	atlas.TexWidth = (int)header.Width;
+	atlas.TexHeight = (int)header.Height;
+	atlas.TexUvScale = ImVec2(1.0f / atlas.TexWidth, 1.0f / atlas.TexHeight);
+	// the atlas releases its pixels with IM_FREE
+	void* pixels = IM_ALLOC(pixelBytes);
+	std::memcpy(pixels, data, pixelBytes);
+	if (header.BytesPerPixel == 1)
+	{
+		atlas.TexPixelsAlpha8 = (unsigned char*)pixels;
+	}
+	else
+	{
+		atlas.TexPixelsRGBA32 = (unsigned int*)pixels;
+		atlas.TexPixelsUseColors = true;
+	}
+
+	for (int i = 0; i < atlas.Fonts.Size; ++i)
+	{
+		ImFont* font = atlas.Fonts[i];
+		ImFontAtlasBuildSetupFont(&atlas, font, (ImFontConfig*)font->ConfigData, fonts[i].Ascent, fonts[i].Descent);
+		font->Glyphs.resize((int)fonts[i].GlyphCount);
+		std::memcpy(font->Glyphs.Data, glyphs[i], fonts[i].GlyphCount * sizeof(ImFontGlyph));
+		font->FallbackChar = (ImWchar)fonts[i].FallbackChar;
+		font->EllipsisChar = (ImWchar)fonts[i].EllipsisChar;
+		font->MetricsTotalSurface = fonts[i].MetricsTotalSurface;
+		font->DirtyLookupTables = true;
+	}
+
+	// draws the cursors and lines into the pixels again (they are already there) and builds the lookup tables
+	ImFontAtlasBuildFinish(&atlas);
+	return true;
+}
+
+bool FontAtlasCache::Save(const ImFontAtlas& atlas, const std::string& filepath, uint64_t key)
+{
+	const unsigned char* pixels = atlas.TexPixelsAlpha8
+		? atlas.TexPixelsAlpha8 : (const unsigned char*)atlas.TexPixelsRGBA32;
+	if (!atlas.TexReady || !pixels)
+	{
+		return false;
+	}
+
+	std::ofstream file(filepath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to create " << filepath << std::endl;
+		return false;
+	}
+
+	FontAtlasCacheHeader header = {};
+	std::memcpy(header.Magic, "FONT", 4);
+	header.Version = Version;
+	header.Key = key;
+	header.Width = (uint32_t)atlas.TexWidth;
+	header.Height = (uint32_t)atlas.TexHeight;
+	header.BytesPerPixel = atlas.TexPixelsAlpha8 ? 1 : 4;
+	header.FontCount = (uint32_t)atlas.Fonts.Size;
+	header.RectCount = (uint32_t)atlas.CustomRects.Size;
+	file.write((const char*)&header, sizeof(header));
+
+	for (const ImFontAtlasCustomRect& rect : atlas.CustomRects)
+	{
+		const FontAtlasCacheRect packed = { rect.X, rect.Y };
+		file.write((const char*)&packed, sizeof(packed));
+	}
+	for (const ImFont* font : atlas.Fonts)
+	{
+		FontAtlasCacheFont info = {};
+		info.Ascent = font->Ascent;
+		info.Descent = font->Descent;
+		info.FallbackChar = font->FallbackChar;
+		info.EllipsisChar = font->EllipsisChar;
+		info.GlyphCount = (uint32_t)font->Glyphs.Size;
+		info.MetricsTotalSurface = font->MetricsTotalSurface;
+		file.write((const char*)&info, sizeof(info));
+		file.write((const char*)font->Glyphs.Data, font->Glyphs.Size * sizeof(ImFontGlyph));
+	}
+	file.write((const char*)pixels, (std::streamsize)atlas.TexWidth * atlas.TexHeight * header.BytesPerPixel);
+
+	if (!file)
+	{
+		std::cout << "Failed to write " << filepath << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+struct ImFontAtlas;
+
+/**
+ * Font atlas cache layout: a FontAtlasCacheHeader, RectCount FontAtlasCacheRect (where every custom rectangle was
+ * packed), then for every font a FontAtlasCacheFont followed by its GlyphCount ImFontGlyph, and last the atlas
+ * pixels, Width * Height * BytesPerPixel bytes (1 for alpha only atlases, 4 when a font has colored glyphs).
+ */
+struct FontAtlasCacheHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	// FontAtlasCache::ComputeKey of the atlas the file was built from
+	uint64_t Key;
+	uint32_t Width, Height;
+	uint32_t BytesPerPixel;
+	uint32_t FontCount;
+	uint32_t RectCount;
+	uint32_t Reserved;
+};
+
+struct FontAtlasCacheRect
+{
+	uint16_t X, Y;
+};
+
+struct FontAtlasCacheFont
+{
+	float Ascent, Descent;
+	uint32_t FallbackChar;
+	uint32_t EllipsisChar;
+	uint32_t GlyphCount;
+	int32_t MetricsTotalSurface;
+};
+
+/**
+ * \brief Saves the rasterized ImGui font atlas, its pixels and glyph tables, to disk and loads it back on the next
+ * runs instead of rasterizing every glyph again with stb_truetype. The file is keyed by a hash of everything the
+ * build depends on (font file bytes, sizes, glyph ranges, oversampling and the other font and atlas settings, the
+ * ImGui version), so changing any of them just rebuilds and rewrites it.
+ */
+class FontAtlasCache
+{
+public:
+	static const uint32_t Version = 1;
+
+	/**
+	 * \brief Builds the atlas, from the cache file when it matches. The fonts have to be added (AddFont*) and the
+	 * atlas not built yet. Touches nothing but the atlas, so it can run on a worker thread.
+	 * \return true when the atlas came from the cache
+	 */
+	static bool Build(ImFontAtlas& atlas, const std::string& filepath);
+
+	static uint64_t ComputeKey(const ImFontAtlas& atlas);
+	static bool Load(ImFontAtlas& atlas, const std::string& filepath, uint64_t key);
+	static bool Save(const ImFontAtlas& atlas, const std::string& filepath, uint64_t key);
+};
@@ -0,0 +1,85 @@
+#include "FrameAllocator.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameAllocator::Arena FrameAllocator::s_Arenas[FrameAllocator::FramesInFlight];
+unsigned int FrameAllocator::s_Current = 0;
+std::mutex FrameAllocator::s_OverflowMutex;
+FrameAllocatorStats FrameAllocator::s_Stats = {};
+
+void FrameAllocator::BeginFrame()
+{
+	Arena& finished = s_Arenas[s_Current];
+	const size_t used = std::min(finished.Offset.load(), finished.Capacity) + finished.OverflowBytes;
+	s_Stats.LastFrameBytes = used;
+	s_Stats.PeakBytes = std::max(s_Stats.PeakBytes, used);
+	s_Stats.LastFrameHeapAllocations = (unsigned int)finished.Overflow.size();
+
+	// last used FramesInFlight frames ago, nothing points into it anymore
+	s_Current = (s_Current + 1) % FramesInFlight;
+	Arena& arena = s_Arenas[s_Current];
+	arena.Overflow.clear();
+	arena.OverflowBytes = 0;
+	arena.Offset = 0;
+
+	// a little headroom so a frame slightly bigger than the peak doesn't spill right away
+	const size_t wanted = std::max(MinArenaSize, s_Stats.PeakBytes + s_Stats.PeakBytes / 4);
+	if (arena.Capacity < wanted)
+	{
+		s_Stats.CapacityBytes += wanted - arena.Capacity;
+		arena.Memory.reset(new unsigned char[wanted]);
+		arena.Capacity = wanted;
+	}
+}
+
+void* FrameAllocator::Allocate(size_t size, size_t alignment)
+{
+	Arena& arena = s_Arenas[s_Current];
+	// the address is rounded up, not the offset: operator new[] only aligns the arena for fundamental types
+	const uintptr_t base = (uintptr_t)arena.Memory.get();
+	size_t offset = arena.Offset.load(std::memory_order_relaxed);
+	while (true)
+	{
+		const size_t aligned = (size_t)(((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+		if (aligned + size > arena.Capacity)
+		{
+			return AllocateOverflow(arena, size, alignment);
+		}
+		if (arena.Offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed))
+		{
+			return arena.Memory.get() + aligned;
+		}
+	}
+}
+
+void* FrameAllocator::AllocateOverflow(Arena& arena, size_t size, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(s_OverflowMutex);
+	std::unique_ptr<unsigned char[]> memory(new unsigned char[size + alignment]);
+	const uintptr_t address = (uintptr_t)memory.get();
+	void* aligned = (void*)((address + alignment - 1) & ~(uintptr_t)(alignment - 1));
+	arena.Overflow.push_back(std::move(memory));
+	arena.OverflowBytes += size;
+	++s_Stats.HeapAllocations;
+	return aligned;
+}
+
+void FrameAllocator::Clear()
+{
+	for (Arena& arena : s_Arenas)
+	{
+		arena.Memory.reset();
+		arena.Capacity = 0;
+		arena.Offset = 0;
+		arena.Overflow.clear();
+		arena.OverflowBytes = 0;
+	}
+	s_Stats.CapacityBytes = 0;
+}
+
+FrameAllocatorStats FrameAllocator::GetStats()
+{
+	std::lock_guard<std::mutex> lock(s_OverflowMutex);
+	return s_Stats;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+struct FrameAllocatorStats
+{
+	// bytes handed out by the last finished frame, and by the busiest frame since the start
+	size_t LastFrameBytes;
+	size_t PeakBytes;
+	// all the arenas together
+	size_t CapacityBytes;
+	// allocations that didn't fit in their arena and went to the heap, in the last frame and in total
+	unsigned int LastFrameHeapAllocations;
+	unsigned int HeapAllocations;
+};
+
+/**
+ * \brief Bump allocator for data that only lives for a frame. There is one arena per frame in flight: memory
+ * allocated during frame N stays valid until BeginFrame starts frame N + FramesInFlight, which leaves time for
+ * the render thread to draw the packet of frame N while the main thread builds the next one. Nothing is freed
+ * one by one, BeginFrame just rewinds the arena it reuses.
+ *
+ * An allocation that doesn't fit goes to the heap, and the arena is grown to the peak frame size the next time
+ * it is reused, so after the first frames allocating here never reaches the heap. Allocate can be called from
+ * any thread, BeginFrame only while nobody allocates.
+ */
+class FrameAllocator
+{
+public:
+	static const unsigned int FramesInFlight = 3;
+	static const size_t MinArenaSize = 256 * 1024;
+
+	static void BeginFrame();
+
+	static void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template<typename T>
+	static T* Allocate(size_t count)
+	{
+		return static_cast<T*>(Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// Releases every arena, nothing allocated here may be used afterwards
+	static void Clear();
+
+	static FrameAllocatorStats GetStats();
+private:
+	struct Arena
+	{
+		std::unique_ptr<unsigned char[]> Memory;
+		size_t Capacity = 0;
+		std::atomic<size_t> Offset{ 0 };
+		// allocations that didn't fit, freed when the arena is reused
+		std::vector<std::unique_ptr<unsigned char[]>> Overflow;
+		size_t OverflowBytes = 0;
+	};
+
+	static void* AllocateOverflow(Arena& arena, size_t size, size_t alignment);
+
+	static Arena s_Arenas[FramesInFlight];
+	static unsigned int s_Current;
+	static std::mutex s_OverflowMutex;
+	static FrameAllocatorStats s_Stats;
+};
+
+/**
+ * \brief Standard allocator on top of FrameAllocator, deallocate does nothing. A container using it must not
+ * outlive the frame it was filled in, which makes it a local of that frame rather than a member: debug builds of
+ * the standard library allocate the container's own bookkeeping through it too.
+ */
+template<typename T>
+class FrameStlAllocator
+{
+public:
+	using value_type = T;
+	using propagate_on_container_move_assignment = std::true_type;
+	using is_always_equal = std::true_type;
+
+	FrameStlAllocator() = default;
+
+	template<typename U>
+	FrameStlAllocator(const FrameStlAllocator<U>&)
+	{
+	}
+
+	T* allocate(size_t count)
+	{
+		return FrameAllocator::Allocate<T>(count);
+	}
+
+	void deallocate(T*, size_t)
+	{
+	}
+
+	template<typename U>
+	bool operator==(const FrameStlAllocator<U>&) const
+	{
+		return true;
+	}
+
+	template<typename U>
+	bool operator!=(const FrameStlAllocator<U>&) const
+	{
+		return false;
+	}
+};
+
+template<typename T>
+using FrameVector = std::vector<T, FrameStlAllocator<T>>;
@@ -0,0 +1,569 @@
+#include "ImageDecoder.h"
+
+#include "Qoi.h"
+#include "stb_image/stb_image.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_DECODER_SSE2 1
+#include <emmintrin.h>
+#else
+#define IMAGE_DECODER_SSE2 0
+#endif
+
+namespace
+{
+	const unsigned char PngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	enum PngFilter
+	{
+		FilterNone = 0,
+		FilterSub = 1,
+		FilterUp = 2,
+		FilterAvg = 3,
+		FilterPaeth = 4
+	};
+
+	// Everything the unfilter stage needs once the IDAT stream has been inflated
+	struct PngState
+	{
+		int Width = 0, Height = 0;
+		int ColorType = 0;
+		int FileChannels = 0;		// channels stored per pixel in the file, 1 for palette images
+		int OutputChannels = 0;		// channels after palette expansion
+		unsigned char Palette[256][4] = {};
+		bool HasTransparency = false;
+		unsigned char* Inflated = nullptr;
+		int InflatedSize = 0;
+	};
+
+	inline unsigned int ReadU32(const unsigned char* bytes)
+	{
+		return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3];
+	}
+
+	bool IsPng(const unsigned char* buffer, int length)
+	{
+		return buffer && length >= 8 && std::memcmp(buffer, PngSignature, 8) == 0;
+	}
+
+	/**
+	 * \brief Reads the chunks and inflates the concatenated IDAT data
+	 * \return false when the image needs a feature the fast path doesn't implement
+	 */
+	bool InflatePng(const unsigned char* buffer, int length, PngState& state)
+	{
+		if (!IsPng(buffer, length))
+		{
+			return false;
+		}
+
+		std::vector<unsigned char> idat;
+		bool hasHeader = false;
+		int p = 8;
+		while (p + 12 <= length)
+		{
+			const unsigned int chunkLength = ReadU32(buffer + p);
+			const unsigned char* type = buffer + p + 4;
+			const unsigned char* data = buffer + p + 8;
+			if (chunkLength > (unsigned int)(length - p - 12))
+			{
+				return false;
+			}
+
+			if (std::memcmp(type, "IHDR", 4) == 0)
+			{
+				if (chunkLength != 13)
+				{
+					return false;
+				}
+				state.Width = (int)ReadU32(data);
+				state.Height = (int)ReadU32(data + 4);
+				const int bitDepth = data[8];
+				state.ColorType = data[9];
+				const int interlace = data[12];
+				if (bitDepth != 8 || interlace != 0 || state.Width <= 0 || state.Height <= 0
+					|| (long long)state.Width * state.Height > (1 << 28))
+				{
+					return false;
+				}
+
+				switch (state.ColorType)
+				{
+				case 0: state.FileChannels = 1; break;
+				case 2: state.FileChannels = 3; break;
+				case 3: state.FileChannels = 1; break;
+				case 4: state.FileChannels = 2; break;
+				case 6: state.FileChannels = 4; break;
+				default: return false;
+				}
+				state.OutputChannels = state.ColorType == 3 ? 3 : state.FileChannels;
+				hasHeader = true;
+			}
+			else if (std::memcmp(type, "CgBI", 4) == 0)
+			{
+				// Apple's premultiplied BGR variant, stb_image knows how to undo it
+				return false;
+			}
+			else if (std::memcmp(type, "PLTE", 4) == 0)
+			{
+				const unsigned int entries = chunkLength / 3;
+				for (unsigned int i = 0; i < entries && i < 256; ++i)
+				{
+					state.Palette[i][0] = data[i * 3 + 0];
+					state.Palette[i][1] = data[i * 3 + 1];
+					state.Palette[i][2] = data[i * 3 + 2];
+					state.Palette[i][3] = 255;
+				}
+			}
+			else if (std::memcmp(type, "tRNS", 4) == 0)
+			{
+				// only palette transparency is handled here, color keyed images go through stb_image
+				if (state.ColorType != 3)
+				{
+					return false;
+				}
+				for (unsigned int i = 0; i < chunkLength && i < 256; ++i)
+				{
+					state.Palette[i][3] = data[i];
+				}
+				state.HasTransparency = true;
+				state.OutputChannels = 4;
+			}
+			else if (std::memcmp(type, "IDAT", 4) == 0)
+			{
+				idat.insert(idat.end(), data, data + chunkLength);
+			}
+			else if (std::memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+			p += 12 + (int)chunkLength;
+		}
+
+		if (!hasHeader || idat.empty())
+		{
+			return false;
+		}
+
+		const int expectedSize = state.Height * (state.Width * state.FileChannels + 1);
+		state.Inflated = (unsigned char*)stbi_zlib_decode_malloc_guesssize_headerflag((const char*)idat.data(),
+			(int)idat.size(), expectedSize, &state.InflatedSize, 1);
+		if (!state.Inflated || state.InflatedSize < expectedSize)
+		{
+			std::free(state.Inflated);
+			state.Inflated = nullptr;
+			return false;
+		}
+		return true;
+	}
+
+	inline unsigned char Paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = std::abs(p - a);
+		const int pb = std::abs(p - b);
+		const int pc = std::abs(p - c);
+		if (pa <= pb && pa <= pc)
+		{
+			return (unsigned char)a;
+		}
+		return (unsigned char)(pb <= pc ? b : c);
+	}
+
+#if IMAGE_DECODER_SSE2
+	// pixels are moved through a general purpose register, a 3 byte memcpy would go through the stack
+	// and stall on store forwarding in these loops
+	template<int Bpp>
+	inline __m128i LoadPixel(const unsigned char* p)
+	{
+		if (Bpp == 4)
+		{
+			int value;
+			std::memcpy(&value, p, 4);
+			return _mm_cvtsi32_si128(value);
+		}
+		return _mm_cvtsi32_si128(p[0] | (p[1] << 8) | (p[2] << 16));
+	}
+
+	template<int Bpp>
+	inline void StorePixel(unsigned char* p, __m128i pixel)
+	{
+		const int value = _mm_cvtsi128_si32(pixel);
+		if (Bpp == 4)
+		{
+			std::memcpy(p, &value, 4);
+			return;
+		}
+		p[0] = (unsigned char)value;
+		p[1] = (unsigned char)(value >> 8);
+		p[2] = (unsigned char)(value >> 16);
+	}
+
+	// Sub/Avg/Paeth depend on the pixel to the left, so the SIMD lanes are the channels of one pixel
+	template<int Bpp>
+	void UnfilterRowSSE2(int filter, unsigned char* row, const unsigned char* prior, int rowBytes)
+	{
+		const int bpp = Bpp;
+		const __m128i zero = _mm_setzero_si128();
+		switch (filter)
+		{
+		case FilterSub:
+		{
+			__m128i a = zero;
+			for (int i = 0; i < rowBytes; i += bpp)
+			{
+				a = _mm_add_epi8(a, LoadPixel<Bpp>(row + i));
+				StorePixel<Bpp>(row + i, a);
+			}
+			break;
+		}
+		case FilterAvg:
+		{
+			const __m128i one = _mm_set1_epi8(1);
+			__m128i a = zero;
+			for (int i = 0; i < rowBytes; i += bpp)
+			{
+				const __m128i b = LoadPixel<Bpp>(prior + i);
+				// _mm_avg_epu8 rounds up, PNG floors
+				__m128i average = _mm_avg_epu8(a, b);
+				average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(a, b), one));
+				a = _mm_add_epi8(average, LoadPixel<Bpp>(row + i));
+				StorePixel<Bpp>(row + i, a);
+			}
+			break;
+		}
+		case FilterPaeth:
+		{
+			// 16 bit lanes so that a + b - c can't overflow
+			__m128i a = zero, c = zero;
+			for (int i = 0; i < rowBytes; i += bpp)
+			{
+				const __m128i b = _mm_unpacklo_epi8(LoadPixel<Bpp>(prior + i), zero);
+				const __m128i x = _mm_unpacklo_epi8(LoadPixel<Bpp>(row + i), zero);
+
+				__m128i pa = _mm_sub_epi16(b, c);
+				__m128i pb = _mm_sub_epi16(a, c);
+				__m128i pc = _mm_add_epi16(pa, pb);
+				pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+				pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+				pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+
+				const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+				const __m128i useA = _mm_cmpeq_epi16(smallest, pa);
+				const __m128i useB = _mm_andnot_si128(useA, _mm_cmpeq_epi16(smallest, pb));
+				const __m128i useC = _mm_andnot_si128(_mm_or_si128(useA, useB), _mm_set1_epi16(-1));
+				const __m128i predictor = _mm_or_si128(_mm_or_si128(_mm_and_si128(useA, a), _mm_and_si128(useB, b)),
+					_mm_and_si128(useC, c));
+
+				a = _mm_and_si128(_mm_add_epi16(x, predictor), _mm_set1_epi16(0xFF));
+				c = b;
+				StorePixel<Bpp>(row + i, _mm_packus_epi16(a, zero));
+			}
+			break;
+		}
+		default:
+			break;
+		}
+	}
+#endif
+
+	void UnfilterRow(int filter, unsigned char* row, const unsigned char* prior, int rowBytes, int bpp)
+	{
+		switch (filter)
+		{
+		case FilterNone:
+			return;
+		case FilterUp:
+		{
+			int i = 0;
+#if IMAGE_DECODER_SSE2
+			// no dependency between bytes, 16 at a time
+			for (; i + 16 <= rowBytes; i += 16)
+			{
+				const __m128i x = _mm_loadu_si128((const __m128i*)(row + i));
+				const __m128i b = _mm_loadu_si128((const __m128i*)(prior + i));
+				_mm_storeu_si128((__m128i*)(row + i), _mm_add_epi8(x, b));
+			}
+#endif
+			for (; i < rowBytes; ++i)
+			{
+				row[i] = (unsigned char)(row[i] + prior[i]);
+			}
+			return;
+		}
+		default:
+			break;
+		}
+
+#if IMAGE_DECODER_SSE2
+		if (bpp == 3)
+		{
+			UnfilterRowSSE2<3>(filter, row, prior, rowBytes);
+			return;
+		}
+		if (bpp == 4)
+		{
+			UnfilterRowSSE2<4>(filter, row, prior, rowBytes);
+			return;
+		}
+#endif
+
+		for (int i = 0; i < rowBytes; ++i)
+		{
+			const int a = i >= bpp ? row[i - bpp] : 0;
+			const int b = prior[i];
+			const int c = i >= bpp ? prior[i - bpp] : 0;
+			switch (filter)
+			{
+			case FilterSub:		row[i] = (unsigned char)(row[i] + a); break;
+			case FilterAvg:		row[i] = (unsigned char)(row[i] + ((a + b) >> 1)); break;
+			case FilterPaeth:	row[i] = (unsigned char)(row[i] + Paeth(a, b, c)); break;
+			default: break;
+			}
+		}
+	}
+
+	inline unsigned char ComputeLuma(int r, int g, int b)
+	{
+		// same weights as stb_image so both paths agree
+		return (unsigned char)((r * 77 + g * 150 + b * 29) >> 8);
+	}
+
+	void ConvertRow(const unsigned char* src, int srcChannels, unsigned char* dst, int dstChannels, int width)
+	{
+		for (int x = 0; x < width; ++x, src += srcChannels, dst += dstChannels)
+		{
+			unsigned char rgba[4];
+			switch (srcChannels)
+			{
+			case 1: rgba[0] = rgba[1] = rgba[2] = src[0]; rgba[3] = 255; break;
+			case 2: rgba[0] = rgba[1] = rgba[2] = src[0]; rgba[3] = src[1]; break;
+			case 3: rgba[0] = src[0]; rgba[1] = src[1]; rgba[2] = src[2]; rgba[3] = 255; break;
+			default: std::memcpy(rgba, src, 4); break;
+			}
+
+			switch (dstChannels)
+			{
+			case 1: dst[0] = srcChannels <= 2 ? rgba[0] : ComputeLuma(rgba[0], rgba[1], rgba[2]); break;
+			case 2: dst[0] = srcChannels <= 2 ? rgba[0] : ComputeLuma(rgba[0], rgba[1], rgba[2]); dst[1] = rgba[3]; break;
+			case 3: dst[0] = rgba[0]; dst[1] = rgba[1]; dst[2] = rgba[2]; break;
+			default: std::memcpy(dst, rgba, 4); break;
+			}
+		}
+	}
+
+	// Second stage: unfilters every row and converts it to the requested layout, releases the inflated data
+	unsigned char* UnfilterPng(PngState& state, int* width, int* height, int* channels, int desiredChannels, bool flipVertically)
+	{
+		const int w = state.Width;
+		const int h = state.Height;
+		const int bpp = state.FileChannels;
+		const int rowBytes = w * bpp;
+		const int outChannels = desiredChannels ? desiredChannels : state.OutputChannels;
+		const bool palette = state.ColorType == 3;
+		const bool convert = palette || outChannels != state.FileChannels;
+
+		unsigned char* pixels = (unsigned char*)std::malloc((size_t)w * h * outChannels);
+		if (!pixels)
+		{
+			std::free(state.Inflated);
+			state.Inflated = nullptr;
+			return nullptr;
+		}
+
+		// rows are unfiltered straight into the output unless they still need converting
+		std::vector<unsigned char> scratch(convert ? (size_t)rowBytes * 2 : 0);
+		std::vector<unsigned char> zeroRow(rowBytes, 0);
+		const unsigned char* prior = zeroRow.data();
+		unsigned char expanded[4];
+
+		for (int y = 0; y < h; ++y)
+		{
+			const unsigned char* filtered = state.Inflated + (size_t)y * (rowBytes + 1);
+			const int filter = filtered[0];
+			unsigned char* outRow = pixels + (size_t)(flipVertically ? h - 1 - y : y) * w * outChannels;
+			unsigned char* row = convert ? &scratch[(size_t)(y & 1) * rowBytes] : outRow;
+
+			std::memcpy(row, filtered + 1, rowBytes);
+			UnfilterRow(filter > FilterPaeth ? FilterNone : filter, row, prior, rowBytes, bpp);
+			prior = row;
+
+			if (!convert)
+			{
+				continue;
+			}
+			if (palette)
+			{
+				unsigned char* dst = outRow;
+				for (int x = 0; x < w; ++x, dst += outChannels)
+				{
+					const unsigned char* entry = state.Palette[row[x]];
+					if (outChannels >= 3)
+					{
+						std::memcpy(dst, entry, outChannels);
+					}
+					else
+					{
+						std::memcpy(expanded, entry, 4);
+						ConvertRow(expanded, 4, dst, outChannels, 1);
+					}
+				}
+			}
+			else
+			{
+				ConvertRow(row, bpp, outRow, outChannels, w);
+			}
+		}
+
+		std::free(state.Inflated);
+		state.Inflated = nullptr;
+
+		*width = w;
+		*height = h;
+		*channels = state.OutputChannels;
+		return pixels;
+	}
+
+	unsigned char* LoadWithFallback(const unsigned char* buffer, int length, int* width, int* height,
+		int* channels, int desiredChannels, bool flipVertically)
+	{
+		if (Qoi::IsQoi(buffer, length) && (desiredChannels == 0 || desiredChannels >= 3))
+		{
+			return Qoi::LoadFromMemory(buffer, length, width, height, channels, desiredChannels, flipVertically);
+		}
+		stbi_set_flip_vertically_on_load_thread(flipVertically ? 1 : 0);
+		return stbi_load_from_memory(buffer, length, width, height, channels, desiredChannels);
+	}
+}
+
+unsigned char* ImageDecoder::LoadFromMemory(const unsigned char* buffer, int length, int* width, int* height,
+	int* channels, int desiredChannels, bool flipVertically)
+{
+	PngState state;
+	if (!InflatePng(buffer, length, state))
+	{
+		return LoadWithFallback(buffer, length, width, height, channels, desiredChannels, flipVertically);
+	}
+	return UnfilterPng(state, width, height, channels, desiredChannels, flipVertically);
+}
+
+unsigned char* ImageDecoder::Load(const std::string& filepath, int* width, int* height, int* channels,
+	int desiredChannels, bool flipVertically)
+{
+	std::ifstream stream(filepath, std::ios::binary);
+	if (!stream)
+	{
+		return nullptr;
+	}
+	std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+	return LoadFromMemory(bytes.data(), (int)bytes.size(), width, height, channels, desiredChannels, flipVertically);
+}
+
+void ImageDecoder::Free(void* pixels)
+{
+	// stb_image, Qoi and the PNG path all allocate with malloc
+	std::free(pixels);
+}
+
+void ImageDecoder::LoadBatch(std::vector<ImageDecodeRequest>& requests, unsigned int threadCount)
+{
+	struct Job
+	{
+		size_t Request;
+		bool Unfilter;
+	};
+
+	std::vector<PngState> states(requests.size());
+	std::deque<Job> inflateJobs, unfilterJobs;
+	for (size_t i = 0; i < requests.size(); ++i)
+	{
+		requests[i].Pixels = nullptr;
+		inflateJobs.push_back({ i, false });
+	}
+
+	std::mutex mutex;
+	std::condition_variable wakeUp;
+	size_t remaining = requests.size();
+
+	auto worker = [&]()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		while (remaining > 0)
+		{
+			if (inflateJobs.empty() && unfilterJobs.empty())
+			{
+				wakeUp.wait(lock);
+				continue;
+			}
+
+			// finishing images first keeps the number of inflated buffers alive low
+			Job job;
+			if (!unfilterJobs.empty())
+			{
+				job = unfilterJobs.front();
+				unfilterJobs.pop_front();
+			}
+			else
+			{
+				job = inflateJobs.front();
+				inflateJobs.pop_front();
+			}
+			lock.unlock();
+
+			ImageDecodeRequest& request = requests[job.Request];
+			bool finished = true;
+			if (job.Unfilter)
+			{
+				request.Pixels = UnfilterPng(states[job.Request], &request.Width, &request.Height, &request.Channels,
+					request.DesiredChannels, request.FlipVertically);
+			}
+			else if (InflatePng(request.Buffer, request.Length, states[job.Request]))
+			{
+				finished = false;
+			}
+			else
+			{
+				request.Pixels = LoadWithFallback(request.Buffer, request.Length, &request.Width, &request.Height,
+					&request.Channels, request.DesiredChannels, request.FlipVertically);
+			}
+
+			lock.lock();
+			if (finished)
+			{
+				--remaining;
+				if (remaining == 0)
+				{
+					wakeUp.notify_all();
+				}
+			}
+			else
+			{
+				unfilterJobs.push_back({ job.Request, true });
+				wakeUp.notify_one();
+			}
+		}
+	};
+
+	unsigned int workers = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	workers = (unsigned int)std::min<size_t>(workers, std::max<size_t>(1, requests.size() * 2));
+	std::vector<std::thread> threads;
+	for (unsigned int i = 1; i < workers; ++i)
+	{
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <string>
+#include <vector>
+
+struct ImageDecodeRequest
+{
+	// input, the encoded file has to stay alive until LoadBatch returns
+	const unsigned char* Buffer;
+	int Length;
+	int DesiredChannels;
+	bool FlipVertically;
+
+	// output, Pixels is nullptr when the image couldn't be decoded
+	unsigned char* Pixels;
+	int Width, Height, Channels;
+};
+
+/**
+ * \brief 8 bit image decoding with a faster path than stb_image for PNG files: IDAT data is inflated
+ * with stb's zlib and rows are unfiltered with SSE2 for RGB and RGBA images. QOI files go to Qoi,
+ * anything else the fast path doesn't handle (interlaced, 16 bit, ...) falls back to stb_image.
+ * Every buffer returned is allocated with malloc and released with ImageDecoder::Free.
+ */
+class ImageDecoder
+{
+public:
+	// Same call shape as stbi_load_from_memory, flipping is per call instead of stb's global flag
+	static unsigned char* LoadFromMemory(const unsigned char* buffer, int length, int* width, int* height,
+		int* channels, int desiredChannels, bool flipVertically = false);
+	static unsigned char* Load(const std::string& filepath, int* width, int* height, int* channels,
+		int desiredChannels, bool flipVertically = false);
+	static void Free(void* pixels);
+
+	/**
+	 * \brief Decodes several images concurrently. PNG decoding is split into an inflate job and an
+	 * unfilter job so that while one worker unfilters an image the next one is already being inflated.
+	 * \param threadCount number of workers, 0 uses every hardware thread
+	 */
+	static void LoadBatch(std::vector<ImageDecodeRequest>& requests, unsigned int threadCount = 0);
+};
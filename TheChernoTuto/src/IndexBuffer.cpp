@@ -1,4 +1,5 @@
 #include "IndexBuffer.h"
+#include "DeletionQueue.h"
 #include "Renderer.h"
 
 IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
@@ -7,14 +8,49 @@ IndexBuffer::IndexBuffer(const unsigned int* data, unsigned int count)
     ASSERT(sizeof(unsigned int) == sizeof(GLuint));
 
     // Create an index buffer that specify the index of which vertex we should be using to draw our triangles
-    GlCall(glGenBuffers(1, &m_RendererID));
-    GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
-    GlCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    m_RendererID = DeletionQueue::AcquireBuffer(count * sizeof(unsigned int), GL_STATIC_DRAW);
+    if (m_RendererID != 0)
+    {
+        GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+        GlCall(glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, count * sizeof(unsigned int), data));
+    }
+    else
+    {
+        GlCall(glGenBuffers(1, &m_RendererID));
+        GlCall(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_RendererID));
+        GlCall(glBufferData(GL_ELEMENT_ARRAY_BUFFER, count * sizeof(unsigned int), data, GL_STATIC_DRAW));
+    }
+    m_Handle = ResourcePool::Create(ResourceType::IndexBuffer, m_RendererID, count * sizeof(unsigned int));
 }
 
 IndexBuffer::~IndexBuffer()
 {
-    GlCall(glDeleteBuffers(1, &m_RendererID));
+    ResourcePool::Destroy(m_Handle);
+    DeletionQueue::DeleteBuffer(m_RendererID, m_Count * sizeof(unsigned int), GL_STATIC_DRAW);
+}
+
+IndexBuffer::IndexBuffer(IndexBuffer&& other) noexcept
+	:m_RendererID(other.m_RendererID), m_Count(other.m_Count), m_Handle(other.m_Handle)
+{
+    other.m_RendererID = 0;
+    other.m_Count = 0;
+    other.m_Handle = ResourceHandle();
+}
+
+IndexBuffer& IndexBuffer::operator=(IndexBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        ResourcePool::Destroy(m_Handle);
+        DeletionQueue::DeleteBuffer(m_RendererID, m_Count * sizeof(unsigned int), GL_STATIC_DRAW);
+        m_RendererID = other.m_RendererID;
+        m_Count = other.m_Count;
+        m_Handle = other.m_Handle;
+        other.m_RendererID = 0;
+        other.m_Count = 0;
+        other.m_Handle = ResourceHandle();
+    }
+    return *this;
 }
 
 void IndexBuffer::Bind() const
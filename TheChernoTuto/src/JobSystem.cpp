@@ -0,0 +1,507 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace
+{
+	// index into the workers of the current thread, -1 outside the pool
+	thread_local int t_WorkerIndex = -1;
+	// state of the random victim choice, per thread so stealing never shares a cache line
+	thread_local uint32_t t_Random = 0;
+
+	uint32_t NextRandom()
+	{
+		// xorshift32
+		uint32_t x = t_Random ? t_Random : (uint32_t)(std::hash<std::thread::id>()(std::this_thread::get_id()) | 1);
+		x ^= x << 13;
+		x ^= x >> 17;
+		x ^= x << 5;
+		t_Random = x;
+		return x;
+	}
+}
+
+std::vector<std::unique_ptr<JobSystem::Worker>> JobSystem::s_Workers;
+std::atomic<bool> JobSystem::s_Running(false);
+std::atomic<bool> JobSystem::s_Stopping(false);
+std::atomic<int> JobSystem::s_Queued(0);
+std::atomic<int> JobSystem::s_Sleeping(0);
+std::mutex JobSystem::s_SleepMutex;
+std::condition_variable JobSystem::s_SleepCondition;
+std::mutex JobSystem::s_SharedMutex;
+std::deque<Job*> JobSystem::s_Shared;
+std::mutex JobSystem::s_FreeMutex;
+std::vector<Job*> JobSystem::s_FreeJobs;
+thread_local JobSystem::JobCache JobSystem::s_JobCache;
+
+JobCounter::JobCounter()
+	:m_Value(0), m_Continuations(nullptr)
+{
+}
+
+JobSystem::JobCache::JobCache()
+	:Count(0)
+{
+}
+
+JobSystem::JobCache::~JobCache()
+{
+	std::lock_guard<std::mutex> lock(s_FreeMutex);
+	s_FreeJobs.insert(s_FreeJobs.end(), Jobs, Jobs + Count);
+}
+
+JobSystem::Deque::Deque()
+	:m_Top(0), m_Bottom(0), m_Jobs(new std::atomic<Job*>[DequeCapacity])
+{
+}
+
+bool JobSystem::Deque::Push(Job* job)
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed);
+	const int64_t top = m_Top.load(std::memory_order_acquire);
+	if (bottom - top >= (int64_t)DequeCapacity)
+	{
+		return false;
+	}
+	m_Jobs[bottom & (DequeCapacity - 1)].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	return true;
+}
+
+Job* JobSystem::Deque::Pop()
+{
+	const int64_t bottom = m_Bottom.load(std::memory_order_relaxed) - 1;
+	m_Bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t top = m_Top.load(std::memory_order_relaxed);
+	if (top > bottom)
+	{
+		// empty
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = m_Jobs[bottom & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+	if (top == bottom)
+	{
+		// the last job, a thief may be taking it right now
+		if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+		m_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+	return job;
+}
+
+Job* JobSystem::Deque::Steal()
+{
+	int64_t top = m_Top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64_t bottom = m_Bottom.load(std::memory_order_acquire);
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+	Job* job = m_Jobs[top & (DequeCapacity - 1)].load(std::memory_order_relaxed);
+	if (!m_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+	return job;
+}
+
+void JobSystem::Initialize(unsigned int workerCount)
+{
+	if (s_Running)
+	{
+		return;
+	}
+	if (workerCount == 0)
+	{
+		workerCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	s_Stopping = false;
+	s_Workers.clear();
+	for (unsigned int i = 0; i < workerCount; ++i)
+	{
+		std::unique_ptr<Worker> worker(new Worker());
+		worker->Executed = 0;
+		worker->Steals = 0;
+		worker->FailedSteals = 0;
+		worker->IdleNanoseconds = 0;
+		s_Workers.push_back(std::move(worker));
+	}
+	t_WorkerIndex = 0;
+	s_Running = true;
+	// the vector is complete before any worker looks at it
+	for (unsigned int i = 1; i < workerCount; ++i)
+	{
+		s_Workers[i]->Thread = std::thread(&JobSystem::WorkerLoop, i);
+	}
+}
+
+void JobSystem::Shutdown()
+{
+	if (!s_Running)
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(s_SleepMutex);
+		s_Stopping = true;
+	}
+	s_SleepCondition.notify_all();
+	for (size_t i = 1; i < s_Workers.size(); ++i)
+	{
+		s_Workers[i]->Thread.join();
+	}
+
+	// nothing can steal any more, whatever is left runs here (and may queue more)
+	while (Job* job = FindJob(0))
+	{
+		Execute(job);
+	}
+	s_Running = false;
+	t_WorkerIndex = -1;
+	s_Workers.clear();
+
+	// the workers returned theirs when they exited
+	std::lock_guard<std::mutex> lock(s_FreeMutex);
+	s_FreeJobs.insert(s_FreeJobs.end(), s_JobCache.Jobs, s_JobCache.Jobs + s_JobCache.Count);
+	s_JobCache.Count = 0;
+	for (Job* job : s_FreeJobs)
+	{
+		delete job;
+	}
+	s_FreeJobs.clear();
+}
+
+bool JobSystem::IsRunning()
+{
+	return s_Running;
+}
+
+unsigned int JobSystem::GetWorkerCount()
+{
+	return (unsigned int)s_Workers.size();
+}
+
+int JobSystem::GetWorkerIndex()
+{
+	return t_WorkerIndex;
+}
+
+void JobSystem::Run(const JobFunction& function, JobCounter* counter)
+{
+	Job* job = AllocateJob(counter);
+	job->Function = function;
+	Push(job);
+}
+
+void JobSystem::RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter)
+{
+	Job* job = AllocateJob(counter);
+	job->Function = function;
+	{
+		// Finish takes the continuations under the same lock, right after the counter reached zero
+		std::lock_guard<std::mutex> lock(dependency.m_Mutex);
+		if (dependency.m_Value.load(std::memory_order_acquire) != 0)
+		{
+			job->Next = dependency.m_Continuations;
+			dependency.m_Continuations = job;
+			return;
+		}
+	}
+	Push(job);
+}
+
+Job* JobSystem::AllocateJob(JobCounter* counter)
+{
+	if (counter)
+	{
+		counter->m_Value.fetch_add(1, std::memory_order_relaxed);
+	}
+	JobCache& cache = s_JobCache;
+	if (cache.Count == 0)
+	{
+		std::lock_guard<std::mutex> lock(s_FreeMutex);
+		while (cache.Count < JobCacheSize / 2 && !s_FreeJobs.empty())
+		{
+			cache.Jobs[cache.Count++] = s_FreeJobs.back();
+			s_FreeJobs.pop_back();
+		}
+	}
+	Job* job = cache.Count > 0 ? cache.Jobs[--cache.Count] : new Job();
+	job->Counter = counter;
+	job->Range = nullptr;
+	job->Next = nullptr;
+	return job;
+}
+
+void JobSystem::FreeJob(Job* job)
+{
+	// what the function captured goes now, not when the job is reused
+	job->Function = nullptr;
+	JobCache& cache = s_JobCache;
+	if (cache.Count == JobCacheSize)
+	{
+		// a thread that mostly steals ends up with the jobs others started, they go back for them
+		std::lock_guard<std::mutex> lock(s_FreeMutex);
+		while (cache.Count > JobCacheSize / 2)
+		{
+			s_FreeJobs.push_back(cache.Jobs[--cache.Count]);
+		}
+	}
+	cache.Jobs[cache.Count++] = job;
+}
+
+void JobSystem::Push(Job* job)
+{
+	if (!s_Running)
+	{
+		Execute(job);
+		return;
+	}
+
+	const int index = t_WorkerIndex;
+	if (index >= 0 && (size_t)index < s_Workers.size())
+	{
+		// counted before it can be taken, so s_Queued never goes below zero
+		s_Queued.fetch_add(1);
+		if (!s_Workers[index]->Jobs.Push(job))
+		{
+			s_Queued.fetch_sub(1);
+			Execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard<std::mutex> lock(s_SharedMutex);
+		s_Queued.fetch_add(1);
+		s_Shared.push_back(job);
+	}
+	WakeUp();
+}
+
+void JobSystem::WakeUp()
+{
+	// paired with the sleepers counting themselves before they check for work, one of the two sees the other
+	if (s_Sleeping.load() > 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_SleepMutex);
+		}
+		s_SleepCondition.notify_all();
+	}
+}
+
+Job* JobSystem::FindJob(int index)
+{
+	if (index >= 0)
+	{
+		if (Job* job = s_Workers[index]->Jobs.Pop())
+		{
+			s_Queued.fetch_sub(1);
+			return job;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(s_SharedMutex);
+		if (!s_Shared.empty())
+		{
+			Job* job = s_Shared.front();
+			s_Shared.pop_front();
+			s_Queued.fetch_sub(1);
+			return job;
+		}
+	}
+
+	const size_t count = s_Workers.size();
+	const size_t first = NextRandom() % count;
+	for (size_t i = 0; i < count; ++i)
+	{
+		const size_t victim = (first + i) % count;
+		if ((int)victim == index)
+		{
+			continue;
+		}
+		Job* job = s_Workers[victim]->Jobs.Steal();
+		if (index >= 0)
+		{
+			(job ? s_Workers[index]->Steals : s_Workers[index]->FailedSteals).fetch_add(1, std::memory_order_relaxed);
+		}
+		if (job)
+		{
+			s_Queued.fetch_sub(1);
+			return job;
+		}
+	}
+	return nullptr;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	if (job->Range)
+	{
+		SplitRange(job->Begin, job->End, job->GrainSize, *job->Range, *job->Counter);
+	}
+	else
+	{
+		job->Function();
+	}
+	const int index = t_WorkerIndex;
+	if (s_Running && index >= 0)
+	{
+		s_Workers[index]->Executed.fetch_add(1, std::memory_order_relaxed);
+	}
+	if (job->Counter)
+	{
+		Finish(*job->Counter);
+	}
+	FreeJob(job);
+}
+
+void JobSystem::Finish(JobCounter& counter)
+{
+	Job* continuations;
+	{
+		std::lock_guard<std::mutex> lock(counter.m_Mutex);
+		if (counter.m_Value.fetch_sub(1) != 1)
+		{
+			return;
+		}
+		continuations = counter.m_Continuations;
+		counter.m_Continuations = nullptr;
+	}
+	// the counter may be gone from here on, Wait returns as soon as it can take the lock
+	while (Job* job = continuations)
+	{
+		continuations = job->Next;
+		job->Next = nullptr;
+		Push(job);
+	}
+	// threads outside the pool sleep in Wait
+	WakeUp();
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	const int index = t_WorkerIndex;
+	while (!counter.IsDone())
+	{
+		if (index >= 0)
+		{
+			// a worker keeps the pool busy instead of blocking it
+			if (Job* job = FindJob(index))
+			{
+				Execute(job);
+				continue;
+			}
+			// what is left is running elsewhere
+			const auto start = std::chrono::high_resolution_clock::now();
+			std::this_thread::yield();
+			const auto idle = std::chrono::high_resolution_clock::now() - start;
+			s_Workers[index]->IdleNanoseconds.fetch_add(
+				(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(idle).count(), std::memory_order_relaxed);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(s_SleepMutex);
+		s_Sleeping.fetch_add(1);
+		s_SleepCondition.wait(lock, [&]() { return counter.IsDone(); });
+		s_Sleeping.fetch_sub(1);
+	}
+	// the last job may still be inside Finish, holding the counter's lock
+	std::lock_guard<std::mutex> lock(counter.m_Mutex);
+}
+
+void JobSystem::WorkerLoop(unsigned int index)
+{
+	t_WorkerIndex = (int)index;
+	Worker& worker = *s_Workers[index];
+	while (!s_Stopping)
+	{
+		if (Job* job = FindJob((int)index))
+		{
+			Execute(job);
+			continue;
+		}
+
+		const auto start = std::chrono::high_resolution_clock::now();
+		{
+			std::unique_lock<std::mutex> lock(s_SleepMutex);
+			s_Sleeping.fetch_add(1);
+			s_SleepCondition.wait(lock, []() { return s_Queued.load() > 0 || s_Stopping; });
+			s_Sleeping.fetch_sub(1);
+		}
+		const auto idle = std::chrono::high_resolution_clock::now() - start;
+		worker.IdleNanoseconds.fetch_add(
+			(uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(idle).count(), std::memory_order_relaxed);
+	}
+}
+
+void JobSystem::SplitRange(size_t begin, size_t end, size_t grainSize, const RangeFunction& function,
+	JobCounter& counter)
+{
+	while (end - begin > grainSize)
+	{
+		const size_t middle = begin + (end - begin) / 2;
+		Job* job = AllocateJob(&counter);
+		job->Range = &function;
+		job->Begin = middle;
+		job->End = end;
+		job->GrainSize = grainSize;
+		Push(job);
+		end = middle;
+	}
+	function(begin, end);
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, const RangeFunction& function)
+{
+	grainSize = std::max<size_t>(grainSize, 1);
+	if (count <= grainSize || !s_Running)
+	{
+		if (count > 0)
+		{
+			function(0, count);
+		}
+		return;
+	}
+
+	JobCounter counter;
+	SplitRange(0, count, grainSize, function, counter);
+	Wait(counter);
+}
+
+std::vector<JobWorkerStats> JobSystem::GetStats()
+{
+	std::vector<JobWorkerStats> stats;
+	for (const std::unique_ptr<Worker>& worker : s_Workers)
+	{
+		JobWorkerStats entry;
+		entry.Jobs = worker->Executed.load(std::memory_order_relaxed);
+		entry.Steals = worker->Steals.load(std::memory_order_relaxed);
+		entry.FailedSteals = worker->FailedSteals.load(std::memory_order_relaxed);
+		entry.IdleMilliseconds = worker->IdleNanoseconds.load(std::memory_order_relaxed) / 1000000.0;
+		stats.push_back(entry);
+	}
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (const std::unique_ptr<Worker>& worker : s_Workers)
+	{
+		worker->Executed = 0;
+		worker->Steals = 0;
+		worker->FailedSteals = 0;
+		worker->IdleNanoseconds = 0;
+	}
+}
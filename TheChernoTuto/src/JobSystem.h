@@ -0,0 +1,179 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct Job;
+
+/**
+ * \brief Number of jobs still to finish. Jobs started with a counter add one when started and remove it when
+ * done, JobSystem::Wait returns once it is back to zero and RunAfter jobs start at that moment. A counter can
+ * be used again once it reached zero.
+ */
+class JobCounter
+{
+public:
+	JobCounter();
+
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+
+	inline bool IsDone() const
+	{
+		return m_Value.load() == 0;
+	}
+private:
+	friend class JobSystem;
+
+	std::atomic<int> m_Value;
+	// the last job to finish takes the continuations and releases the counter under the lock
+	std::mutex m_Mutex;
+	// linked through Job::Next
+	Job* m_Continuations;
+};
+
+struct Job
+{
+	std::function<void()> Function;
+	JobCounter* Counter;
+	// set for the ParallelFor ranges instead of Function, their captures wouldn't fit in every std::function
+	// without allocating
+	const std::function<void(size_t begin, size_t end)>* Range;
+	size_t Begin;
+	size_t End;
+	size_t GrainSize;
+	// the next continuation waiting on the same counter
+	Job* Next;
+};
+
+struct JobWorkerStats
+{
+	uint64_t Jobs;
+	// jobs taken from another worker's deque, and attempts that found nothing or lost the race
+	uint64_t Steals;
+	uint64_t FailedSteals;
+	// asleep without work, or inside Wait with nothing left to take
+	double IdleMilliseconds;
+};
+
+/**
+ * \brief Work stealing job scheduler. Every worker thread, and the thread that called Initialize as worker 0,
+ * owns a Chase-Lev deque: it pushes and pops jobs at the bottom of its own deque without locking while the
+ * others steal from the top when they run dry, so a job that spawns more jobs keeps them local until someone
+ * is idle. Jobs started from threads outside the pool go through a shared queue instead. Idle workers sleep
+ * until a job is queued, Wait on a worker runs other jobs in the meantime.
+ *
+ * Job objects are recycled: every thread keeps a few finished ones at hand and trades them with a shared free
+ * list in batches, so once the pool has grown to the number of jobs in flight, starting a job doesn't allocate.
+ *
+ * Before Initialize and after Shutdown every job runs right away on the calling thread, so code using the job
+ * system also works in tools that never start it.
+ */
+class JobSystem
+{
+public:
+	using JobFunction = std::function<void()>;
+	using RangeFunction = std::function<void(size_t begin, size_t end)>;
+
+	// jobs pushed to a full deque run on the spot
+	static const unsigned int DequeCapacity = 4096;
+	// free jobs a thread keeps for itself, half of them go back to the shared list when it fills up
+	static const unsigned int JobCacheSize = 64;
+
+	// workerCount includes the calling thread, 0 for one per hardware thread
+	static void Initialize(unsigned int workerCount = 0);
+	// Runs what is still queued and joins the workers
+	static void Shutdown();
+
+	static bool IsRunning();
+	static unsigned int GetWorkerCount();
+	// Index of the calling thread among the workers, -1 outside the pool
+	static int GetWorkerIndex();
+
+	static void Run(const JobFunction& function, JobCounter* counter = nullptr);
+	// Starts the job once dependency reached zero, right away when it already has
+	static void RunAfter(JobCounter& dependency, const JobFunction& function, JobCounter* counter = nullptr);
+	static void Wait(JobCounter& counter);
+
+	/**
+	 * \brief Calls function over [0, count) in ranges of at most grainSize and returns when all are done. The
+	 * range is split in halves recursively, the upper half becoming a job other workers can steal, so only
+	 * idle workers split it further.
+	 */
+	static void ParallelFor(size_t count, size_t grainSize, const RangeFunction& function);
+
+	// One entry per worker, worker 0 being the thread that called Initialize
+	static std::vector<JobWorkerStats> GetStats();
+	static void ResetStats();
+private:
+	// Chase-Lev deque with a fixed capacity, "Correct and Efficient Work-Stealing for Weak Memory Models"
+	class Deque
+	{
+	public:
+		Deque();
+
+		// Owner only
+		bool Push(Job* job);
+		Job* Pop();
+		// Any thread, nullptr when empty or when another thread took the job first
+		Job* Steal();
+	private:
+		std::atomic<int64_t> m_Top;
+		std::atomic<int64_t> m_Bottom;
+		std::unique_ptr<std::atomic<Job*>[]> m_Jobs;
+	};
+
+	struct JobCache
+	{
+		Job* Jobs[JobCacheSize];
+		unsigned int Count;
+
+		JobCache();
+		// hands the jobs to the shared list when the thread exits
+		~JobCache();
+	};
+
+	struct Worker
+	{
+		Deque Jobs;
+		std::thread Thread;
+		std::atomic<uint64_t> Executed;
+		std::atomic<uint64_t> Steals;
+		std::atomic<uint64_t> FailedSteals;
+		std::atomic<uint64_t> IdleNanoseconds;
+	};
+
+	// A recycled job with nothing to run yet, already counted on counter
+	static Job* AllocateJob(JobCounter* counter);
+	static void FreeJob(Job* job);
+	static void WorkerLoop(unsigned int index);
+	static void Push(Job* job);
+	// Own deque, then the shared queue, then the other workers from a random one on
+	static Job* FindJob(int index);
+	static void Execute(Job* job);
+	static void Finish(JobCounter& counter);
+	static void SplitRange(size_t begin, size_t end, size_t grainSize, const RangeFunction& function,
+		JobCounter& counter);
+	static void WakeUp();
+
+	static std::vector<std::unique_ptr<Worker>> s_Workers;
+	static std::atomic<bool> s_Running;
+	static std::atomic<bool> s_Stopping;
+	// jobs sitting in a deque or the shared queue, and threads sleeping until there are some
+	static std::atomic<int> s_Queued;
+	static std::atomic<int> s_Sleeping;
+	static std::mutex s_SleepMutex;
+	static std::condition_variable s_SleepCondition;
+	static std::mutex s_SharedMutex;
+	static std::deque<Job*> s_Shared;
+	static std::mutex s_FreeMutex;
+	static std::vector<Job*> s_FreeJobs;
+	static thread_local JobCache s_JobCache;
+};
@@ -0,0 +1,186 @@
+#include "Lz4.h"
+
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	const size_t MinMatch = 4;
+	// the format wants the last 5 bytes as literals and the last match to start 12 bytes before the end
+	const size_t LastLiterals = 5;
+	const size_t MatchFindLimit = 12;
+	const size_t MaxOffset = 65535;
+	const unsigned int HashBits = 16;
+
+	uint32_t Read32(const unsigned char* p)
+	{
+		uint32_t value;
+		std::memcpy(&value, p, sizeof(value));
+		return value;
+	}
+
+	uint32_t Hash(uint32_t sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - HashBits);
+	}
+
+	void WriteLength(size_t length, std::vector<unsigned char>& output)
+	{
+		while (length >= 255)
+		{
+			output.push_back(255);
+			length -= 255;
+		}
+		output.push_back((unsigned char)length);
+	}
+
+	void WriteSequence(const unsigned char* literals, size_t literalCount, size_t offset, size_t matchLength,
+		std::vector<unsigned char>& output)
+	{
+		const size_t matchCode = matchLength - MinMatch;
+		output.push_back((unsigned char)(((literalCount < 15 ? literalCount : 15) << 4) | (matchCode < 15 ? matchCode : 15)));
+		if (literalCount >= 15)
+		{
+			WriteLength(literalCount - 15, output);
+		}
+		output.insert(output.end(), literals, literals + literalCount);
+		output.push_back((unsigned char)(offset & 0xff));
+		output.push_back((unsigned char)(offset >> 8));
+		if (matchCode >= 15)
+		{
+			WriteLength(matchCode - 15, output);
+		}
+	}
+
+	bool ReadLength(const unsigned char* source, size_t sourceSize, size_t& position, size_t& length)
+	{
+		unsigned char byte;
+		do
+		{
+			if (position >= sourceSize)
+			{
+				return false;
+			}
+			byte = source[position++];
+			length += byte;
+		} while (byte == 255);
+		return true;
+	}
+}
+
+size_t Lz4::GetMaxCompressedSize(size_t size)
+{
+	return size + size / 255 + 16;
+}
+
+void Lz4::Compress(const unsigned char* source, size_t size, std::vector<unsigned char>& output)
+{
+	output.reserve(output.size() + GetMaxCompressedSize(size));
+
+	size_t anchor = 0;
+	if (size > MatchFindLimit)
+	{
+		// positions + 1, 0 marks an empty slot
+		std::vector<uint32_t> table((size_t)1 << HashBits, 0);
+		const size_t matchStartLimit = size - MatchFindLimit;
+		const size_t matchEndLimit = size - LastLiterals;
+
+		size_t position = 0;
+		while (position <= matchStartLimit)
+		{
+			const uint32_t sequence = Read32(source + position);
+			uint32_t& slot = table[Hash(sequence)];
+			const size_t candidate = (size_t)slot - 1;
+			slot = (uint32_t)(position + 1);
+
+			if (candidate == (size_t)-1 || position - candidate > MaxOffset || Read32(source + candidate) != sequence)
+			{
+				++position;
+				continue;
+			}
+
+			size_t matchLength = MinMatch;
+			while (position + matchLength < matchEndLimit && source[candidate + matchLength] == source[position + matchLength])
+			{
+				++matchLength;
+			}
+			WriteSequence(source + anchor, position - anchor, position - candidate, matchLength, output);
+			position += matchLength;
+			anchor = position;
+		}
+	}
+
+	// the last sequence is literals only
+	const size_t literalCount = size - anchor;
+	output.push_back((unsigned char)((literalCount < 15 ? literalCount : 15) << 4));
+	if (literalCount >= 15)
+	{
+		WriteLength(literalCount - 15, output);
+	}
+	output.insert(output.end(), source + anchor, source + size);
+}
+
+bool Lz4::Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination, size_t destinationSize)
+{
+	size_t in = 0, out = 0;
+	while (in < sourceSize)
+	{
+		const unsigned char token = source[in++];
+
+		size_t literalCount = token >> 4;
+		if (literalCount == 15 && !ReadLength(source, sourceSize, in, literalCount))
+		{
+			return false;
+		}
+		if (literalCount > sourceSize - in || literalCount > destinationSize - out)
+		{
+			return false;
+		}
+		std::memcpy(destination + out, source + in, literalCount);
+		in += literalCount;
+		out += literalCount;
+
+		if (in == sourceSize)
+		{
+			break;
+		}
+
+		if (sourceSize - in < 2)
+		{
+			return false;
+		}
+		const size_t offset = source[in] | ((size_t)source[in + 1] << 8);
+		in += 2;
+		if (offset == 0 || offset > out)
+		{
+			return false;
+		}
+
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !ReadLength(source, sourceSize, in, matchLength))
+		{
+			return false;
+		}
+		matchLength += MinMatch;
+		if (matchLength > destinationSize - out)
+		{
+			return false;
+		}
+
+		// matches may overlap their own output (offset < length repeats a pattern), copy byte by byte then
+		const unsigned char* match = destination + out - offset;
+		if (offset >= matchLength)
+		{
+			std::memcpy(destination + out, match, matchLength);
+		}
+		else
+		{
+			for (size_t i = 0; i < matchLength; ++i)
+			{
+				destination[out + i] = match[i];
+			}
+		}
+		out += matchLength;
+	}
+	return out == destinationSize;
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+/**
+ * \brief Encoder and decoder for the LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+ * Blocks only, without the frame format around them: the decompressed size has to be stored elsewhere, the pack
+ * file keeps it in its table of contents. The encoder is the plain greedy one with a 64K entry hash table, the
+ * decoder checks every length and offset against both buffers so a corrupt block fails instead of overrunning.
+ */
+class Lz4
+{
+public:
+	static size_t GetMaxCompressedSize(size_t size);
+
+	// Appends the block to output
+	static void Compress(const unsigned char* source, size_t size, std::vector<unsigned char>& output);
+	// False unless the block decodes to exactly destinationSize bytes
+	static bool Decompress(const unsigned char* source, size_t sourceSize, unsigned char* destination,
+		size_t destinationSize);
+};
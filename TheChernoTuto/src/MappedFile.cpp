@@ -0,0 +1,138 @@
+#include "MappedFile.h"
+
+#include <iostream>
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	:m_Data(nullptr), m_Size(0)
+#ifdef _WIN32
+	, m_File(nullptr), m_Mapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+	:m_Data(other.m_Data), m_Size(other.m_Size)
+#ifdef _WIN32
+	, m_File(other.m_File), m_Mapping(other.m_Mapping)
+#endif
+{
+	other.m_Data = nullptr;
+	other.m_Size = 0;
+#ifdef _WIN32
+	other.m_File = nullptr;
+	other.m_Mapping = nullptr;
+#endif
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		std::swap(m_Data, other.m_Data);
+		std::swap(m_Size, other.m_Size);
+#ifdef _WIN32
+		std::swap(m_File, other.m_File);
+		std::swap(m_Mapping, other.m_Mapping);
+#endif
+	}
+	return *this;
+}
+
+bool MappedFile::Open(const std::string& filepath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		std::cout << "Failed to open " << filepath << std::endl;
+		return false;
+	}
+	LARGE_INTEGER size;
+	// an empty file cannot be mapped
+	if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+	{
+		std::cout << "Failed to map " << filepath << std::endl;
+		CloseHandle(file);
+		return false;
+	}
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+	if (!view)
+	{
+		std::cout << "Failed to map " << filepath << std::endl;
+		if (mapping)
+		{
+			CloseHandle(mapping);
+		}
+		CloseHandle(file);
+		return false;
+	}
+	m_File = file;
+	m_Mapping = mapping;
+	m_Data = (const unsigned char*)view;
+	m_Size = (size_t)size.QuadPart;
+#else
+	const int descriptor = open(filepath.c_str(), O_RDONLY);
+	if (descriptor < 0)
+	{
+		std::cout << "Failed to open " << filepath << std::endl;
+		return false;
+	}
+	struct stat status;
+	void* view = MAP_FAILED;
+	if (fstat(descriptor, &status) == 0 && status.st_size > 0)
+	{
+		view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	}
+	// the mapping keeps its own reference to the file
+	close(descriptor);
+	if (view == MAP_FAILED)
+	{
+		std::cout << "Failed to map " << filepath << std::endl;
+		return false;
+	}
+	m_Data = (const unsigned char*)view;
+	m_Size = (size_t)status.st_size;
+#endif
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (!m_Data)
+	{
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(m_Data);
+	CloseHandle(m_Mapping);
+	CloseHandle(m_File);
+	m_File = nullptr;
+	m_Mapping = nullptr;
+#else
+	munmap((void*)m_Data, m_Size);
+#endif
+	m_Data = nullptr;
+	m_Size = 0;
+}
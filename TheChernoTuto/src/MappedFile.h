@@ -0,0 +1,45 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+/**
+ * \brief Read-only memory mapping of a whole file. Pages are faulted in by the OS as they are touched, so
+ * opening is cheap whatever the size and data that is never read is never loaded. Move-only, the view is
+ * unmapped on destruction.
+ */
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const std::string& filepath);
+	void Close();
+
+	inline bool IsOpen() const
+	{
+		return m_Data != nullptr;
+	}
+
+	inline const unsigned char* GetData() const
+	{
+		return m_Data;
+	}
+
+	inline size_t GetSize() const
+	{
+		return m_Size;
+	}
+private:
+	const unsigned char* m_Data;
+	size_t m_Size;
+#ifdef _WIN32
+	void* m_File;
+	void* m_Mapping;
+#endif
+};
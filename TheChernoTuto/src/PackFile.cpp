@@ -0,0 +1,319 @@
+#include "PackFile.h"
+
+#include "Lz4.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+	// compares a name against an entry's name in the blob, plain byte order like std::string
+	int CompareName(const std::string& name, const char* other, size_t otherLength)
+	{
+		const int result = std::memcmp(name.data(), other, std::min(name.size(), otherLength));
+		if (result != 0)
+		{
+			return result;
+		}
+		return name.size() < otherLength ? -1 : name.size() > otherLength ? 1 : 0;
+	}
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+bool PackFile::Open(const std::string& filepath)
+{
+	Close();
+	if (!m_File.Open(filepath))
+	{
+		return false;
+	}
+
+	const unsigned char* data = m_File.GetData();
+	const size_t size = m_File.GetSize();
+	const PackHeader* header = (const PackHeader*)data;
+	if (size < sizeof(PackHeader) || std::memcmp(header->Magic, "PACK", 4) != 0 || header->Version != Version)
+	{
+		std::cout << filepath << " is not a pack file" << std::endl;
+		m_File.Close();
+		return false;
+	}
+
+	// every entry has to lie inside the file before anything is trusted
+	bool valid = header->TocOffset % alignof(PackEntry) == 0
+		&& header->TocOffset <= size && header->EntryCount <= (size - header->TocOffset) / sizeof(PackEntry)
+		&& header->NamesOffset <= size && header->NamesSize <= size - header->NamesOffset;
+	const PackEntry* entries = valid ? (const PackEntry*)(data + header->TocOffset) : nullptr;
+	for (uint32_t i = 0; valid && i < header->EntryCount; ++i)
+	{
+		const PackEntry& entry = entries[i];
+		valid = entry.Offset <= size && entry.StoredSize <= size - entry.Offset
+			&& (uint64_t)entry.NameOffset + entry.NameLength <= header->NamesSize
+			&& ((entry.Flags & PackEntryCompressed) || entry.StoredSize == entry.Size);
+	}
+	if (!valid)
+	{
+		std::cout << filepath << " is corrupt" << std::endl;
+		m_File.Close();
+		return false;
+	}
+
+	m_Filepath = filepath;
+	m_Header = header;
+	m_Entries = entries;
+	m_Names = (const char*)data + header->NamesOffset;
+	return true;
+}
+
+void PackFile::Close()
+{
+	m_File.Close();
+	m_Filepath.clear();
+	m_Header = nullptr;
+	m_Entries = nullptr;
+	m_Names = nullptr;
+}
+
+std::string PackFile::GetName(const PackEntry& entry) const
+{
+	return std::string(m_Names + entry.NameOffset, entry.NameLength);
+}
+
+const PackEntry* PackFile::Find(const std::string& name) const
+{
+	if (!m_Header)
+	{
+		return nullptr;
+	}
+
+	const std::string key = NormalizeName(name);
+	size_t first = 0, last = m_Header->EntryCount;
+	while (first < last)
+	{
+		const size_t middle = first + (last - first) / 2;
+		const PackEntry& entry = m_Entries[middle];
+		const int order = CompareName(key, m_Names + entry.NameOffset, entry.NameLength);
+		if (order == 0)
+		{
+			return &entry;
+		}
+		if (order < 0)
+		{
+			last = middle;
+		}
+		else
+		{
+			first = middle + 1;
+		}
+	}
+	return nullptr;
+}
+
+bool PackFile::Read(const PackEntry& entry, const unsigned char*& data, size_t& size,
+	std::vector<unsigned char>& storage) const
+{
+	const unsigned char* stored = m_File.GetData() + entry.Offset;
+	if (!(entry.Flags & PackEntryCompressed))
+	{
+		data = stored;
+		size = (size_t)entry.Size;
+		return true;
+	}
+
+	storage.resize((size_t)entry.Size);
+	if (!Lz4::Decompress(stored, (size_t)entry.StoredSize, storage.data(), storage.size()))
+	{
+		std::cout << "Failed to decompress " << GetName(entry) << " from " << m_Filepath << std::endl;
+		return false;
+	}
+	data = storage.data();
+	size = storage.size();
+	return true;
+}
+
+std::string PackFile::NormalizeName(const std::string& filepath)
+{
+	std::string path = filepath;
+	std::replace(path.begin(), path.end(), '\\', '/');
+#ifdef _WIN32
+	std::transform(path.begin(), path.end(), path.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+#endif
+
+	// ".." only cancels a real directory, leading ones of a relative path are kept
+	std::vector<std::string> parts;
+	size_t start = 0;
+	while (start <= path.size())
+	{
+		size_t end = path.find('/', start);
+		if (end == std::string::npos)
+		{
+			end = path.size();
+		}
+		const std::string part = path.substr(start, end - start);
+		if (part == "..")
+		{
+			if (!parts.empty() && parts.back() != "..")
+			{
+				parts.pop_back();
+			}
+			else
+			{
+				parts.push_back(part);
+			}
+		}
+		else if (!part.empty() && part != ".")
+		{
+			parts.push_back(part);
+		}
+		start = end + 1;
+	}
+
+	std::string normalized = !path.empty() && path[0] == '/' ? "/" : "";
+	for (size_t i = 0; i < parts.size(); ++i)
+	{
+		normalized += i == 0 ? parts[i] : "/" + parts[i];
+	}
+	return normalized;
+}
+
+uint64_t PackFile::Hash(const unsigned char* data, size_t size, uint64_t hash)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash = (hash ^ data[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+bool PackWriter::AddFile(const std::string& name, const std::string& sourcePath, bool compress)
+{
+	std::ifstream file(sourcePath, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to open " << sourcePath << std::endl;
+		return false;
+	}
+	AddData(name, std::vector<unsigned char>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()),
+		compress);
+	return true;
+}
+
+void PackWriter::AddData(const std::string& name, std::vector<unsigned char> data, bool compress)
+{
+	Entry entry;
+	entry.Name = PackFile::NormalizeName(name);
+	entry.Size = data.size();
+	entry.ContentHash = PackFile::Hash(data.data(), data.size());
+	entry.Compressed = false;
+	if (compress && !data.empty())
+	{
+		std::vector<unsigned char> compressed;
+		Lz4::Compress(data.data(), data.size(), compressed);
+		if (compressed.size() <= data.size() - data.size() / 8)
+		{
+			data = std::move(compressed);
+			entry.Compressed = true;
+		}
+	}
+	entry.Data = std::move(data);
+
+	// adding a name twice replaces the first one
+	auto existing = std::find_if(m_Entries.begin(), m_Entries.end(), [&](const Entry& other)
+	{
+		return other.Name == entry.Name;
+	});
+	if (existing != m_Entries.end())
+	{
+		*existing = std::move(entry);
+	}
+	else
+	{
+		m_Entries.push_back(std::move(entry));
+	}
+}
+
+bool PackWriter::Write(const std::string& destination, uint32_t alignment)
+{
+	if (alignment == 0 || (alignment & (alignment - 1)) != 0)
+	{
+		std::cout << "Pack alignment has to be a power of two" << std::endl;
+		return false;
+	}
+
+	std::ofstream file(destination, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to create " << destination << std::endl;
+		return false;
+	}
+
+	std::sort(m_Entries.begin(), m_Entries.end(), [](const Entry& a, const Entry& b) { return a.Name < b.Name; });
+
+	PackHeader header = {};
+	std::memcpy(header.Magic, "PACK", 4);
+	header.Version = PackFile::Version;
+	header.EntryCount = (uint32_t)m_Entries.size();
+	header.Alignment = alignment;
+	file.write((const char*)&header, sizeof(header));
+
+	m_Stats = PackWriterStats();
+	std::vector<PackEntry> toc(m_Entries.size());
+	std::string names;
+	const char padding[256] = {};
+	uint64_t offset = sizeof(header);
+	for (size_t i = 0; i < m_Entries.size(); ++i)
+	{
+		const Entry& entry = m_Entries[i];
+		const uint64_t aligned = AlignUp(offset, alignment);
+		for (uint64_t remaining = aligned - offset; remaining > 0;)
+		{
+			const size_t count = (size_t)std::min<uint64_t>(remaining, sizeof(padding));
+			file.write(padding, count);
+			remaining -= count;
+		}
+
+		PackEntry& packed = toc[i];
+		packed = PackEntry();
+		packed.Offset = aligned;
+		packed.StoredSize = entry.Data.size();
+		packed.Size = entry.Size;
+		packed.ContentHash = entry.ContentHash;
+		packed.NameOffset = (uint32_t)names.size();
+		packed.NameLength = (uint32_t)entry.Name.size();
+		packed.Flags = entry.Compressed ? (uint32_t)PackEntryCompressed : 0u;
+		names += entry.Name;
+
+		file.write((const char*)entry.Data.data(), entry.Data.size());
+		offset = aligned + entry.Data.size();
+
+		++m_Stats.Entries;
+		m_Stats.CompressedEntries += entry.Compressed ? 1 : 0;
+		m_Stats.SourceBytes += entry.Size;
+	}
+
+	// the table is read in place from the mapping, keep it aligned for its 64 bit fields
+	const uint64_t tocOffset = AlignUp(offset, alignof(PackEntry));
+	file.write(padding, (size_t)(tocOffset - offset));
+	file.write((const char*)toc.data(), toc.size() * sizeof(PackEntry));
+	file.write(names.data(), names.size());
+
+	header.TocOffset = tocOffset;
+	header.NamesOffset = tocOffset + toc.size() * sizeof(PackEntry);
+	header.NamesSize = names.size();
+	file.seekp(0);
+	file.write((const char*)&header, sizeof(header));
+	m_Stats.PackBytes = header.NamesOffset + header.NamesSize;
+	if (!file)
+	{
+		std::cout << "Failed to write " << destination << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+/**
+ * Pack layout: a PackHeader, the entries' data, each starting on a multiple of the header's Alignment, then the
+ * table of contents (one PackEntry per file, sorted by name) and the names blob the entries point into. The table
+ * comes last so the writer streams the data without knowing the final offsets up front. Names are paths
+ * normalized by PackFile::NormalizeName, the same key AssetManager looks assets up with.
+ */
+struct PackHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t EntryCount;
+	uint32_t Alignment;
+	uint64_t TocOffset;
+	uint64_t NamesOffset;
+	uint64_t NamesSize;
+};
+
+enum PackEntryFlags : uint32_t
+{
+	PackEntryCompressed = 1
+};
+
+struct PackEntry
+{
+	uint64_t Offset;
+	// bytes in the pack, Size once decompressed
+	uint64_t StoredSize;
+	uint64_t Size;
+	// FNV-1a of the uncompressed bytes, identical to AssetManager::HashFile on the source file
+	uint64_t ContentHash;
+	uint32_t NameOffset;
+	uint32_t NameLength;
+	uint32_t Flags;
+	uint32_t Reserved;
+};
+
+/**
+ * \brief Read side of a pack, memory mapped. Opening only validates the header and the table of contents,
+ * entries are paged in by the OS when read. Stored entries are handed out as pointers into the mapping
+ * without a copy, LZ4 compressed ones are decoded into a caller owned buffer. Everything is const after
+ * Open, so any thread can read entries concurrently.
+ */
+class PackFile
+{
+public:
+	static const uint32_t Version = 1;
+
+	bool Open(const std::string& filepath);
+	void Close();
+
+	inline bool IsOpen() const
+	{
+		return m_Header != nullptr;
+	}
+
+	inline const std::string& GetFilepath() const
+	{
+		return m_Filepath;
+	}
+
+	inline size_t GetEntryCount() const
+	{
+		return m_Header ? m_Header->EntryCount : 0;
+	}
+
+	inline const PackEntry& GetEntry(size_t index) const
+	{
+		return m_Entries[index];
+	}
+
+	std::string GetName(const PackEntry& entry) const;
+	// Binary search on the table of contents, nullptr when the pack has no such file
+	const PackEntry* Find(const std::string& name) const;
+
+	/**
+	 * \brief Points data at the entry's bytes: straight into the mapping when it is stored, into storage after
+	 * decompressing it otherwise. The pointer lives as long as the pack stays open and storage is untouched.
+	 */
+	bool Read(const PackEntry& entry, const unsigned char*& data, size_t& size, std::vector<unsigned char>& storage) const;
+
+	// Forward slashes, no "." or ".." components, lower case on Windows
+	static std::string NormalizeName(const std::string& filepath);
+	static uint64_t Hash(const unsigned char* data, size_t size, uint64_t hash = 14695981039346656037ull);
+private:
+	std::string m_Filepath;
+	MappedFile m_File;
+	const PackHeader* m_Header = nullptr;
+	const PackEntry* m_Entries = nullptr;
+	const char* m_Names = nullptr;
+};
+
+struct PackWriterStats
+{
+	unsigned int Entries;
+	unsigned int CompressedEntries;
+	uint64_t SourceBytes;
+	uint64_t PackBytes;
+};
+
+/**
+ * \brief Builds a pack file. Files are read when added; with compression on, an entry is kept LZ4 compressed
+ * only when that saves at least an eighth of its size, already compressed formats (PNG, QOI) are stored as is
+ * and stay zero-copy.
+ */
+class PackWriter
+{
+public:
+	static const uint32_t DefaultAlignment = 64;
+
+	bool AddFile(const std::string& name, const std::string& sourcePath, bool compress);
+	void AddData(const std::string& name, std::vector<unsigned char> data, bool compress);
+
+	// alignment has to be a power of two, 64 keeps every entry on its own cache line
+	bool Write(const std::string& destination, uint32_t alignment = DefaultAlignment);
+
+	inline const PackWriterStats& GetStats() const
+	{
+		return m_Stats;
+	}
+private:
+	struct Entry
+	{
+		std::string Name;
+		std::vector<unsigned char> Data;
+		uint64_t Size;
+		uint64_t ContentHash;
+		bool Compressed;
+	};
+
+	std::vector<Entry> m_Entries;
+	PackWriterStats m_Stats = {};
+};
@@ -0,0 +1,335 @@
+#include "Profiler.h"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+
+namespace
+{
+	const auto s_Epoch = std::chrono::high_resolution_clock::now();
+
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c; ++c)
+		{
+			switch (*c)
+			{
+			case '"':	stream << "\\\""; break;
+			case '\\':	stream << "\\\\"; break;
+			case '\n':	stream << "\\n"; break;
+			case '\t':	stream << "\\t"; break;
+			default:
+				if ((unsigned char)*c < 0x20)
+				{
+					stream << "\\u00" << "0123456789abcdef"[(*c >> 4) & 0xf] << "0123456789abcdef"[*c & 0xf];
+				}
+				else
+				{
+					stream << *c;
+				}
+			}
+		}
+		stream << '"';
+	}
+
+	// the same scope keeps its colour from frame to frame
+	ImU32 GetScopeColor(const char* name)
+	{
+		uint32_t hash = 2166136261u;
+		for (const char* c = name; *c; ++c)
+		{
+			hash = (hash ^ (unsigned char)*c) * 16777619u;
+		}
+		return ImColor::HSV((hash % 360) / 360.0f, 0.55f, 0.7f);
+	}
+}
+
+std::atomic<bool> Profiler::s_Enabled(true);
+std::mutex Profiler::s_RingsMutex;
+std::vector<std::unique_ptr<Profiler::ThreadRing>> Profiler::s_Rings;
+uint64_t Profiler::s_FrameStarts[MaxFrames];
+uint64_t Profiler::s_Frame = 0;
+bool Profiler::s_Paused = false;
+std::vector<ProfileEvent> Profiler::s_Captured;
+std::vector<const char*> Profiler::s_ThreadNames;
+std::vector<unsigned int> Profiler::s_LaneDepths;
+uint64_t Profiler::s_CapturedStart = 0;
+uint64_t Profiler::s_CapturedEnd = 0;
+std::string Profiler::s_ExportMessage;
+
+void Profiler::SetEnabled(bool enabled)
+{
+	s_Enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Profiler::SetThreadName(const char* name)
+{
+	ThreadRing& ring = GetRing();
+	std::lock_guard<std::mutex> lock(s_RingsMutex);
+	ring.Name = name;
+}
+
+uint64_t Profiler::Now()
+{
+	return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::high_resolution_clock::now() - s_Epoch).count();
+}
+
+uint64_t Profiler::BeginScope()
+{
+	++GetRing().Depth;
+	return Now();
+}
+
+void Profiler::EndScope(const char* name, uint64_t start)
+{
+	const uint64_t end = Now();
+	ThreadRing& ring = GetRing();
+	--ring.Depth;
+	const uint64_t head = ring.Head.load(std::memory_order_relaxed);
+	Slot& slot = ring.Slots[head % RingCapacity];
+	// pairs with the fence in Collect, a reader that sees any of these stores also sees the head that says which
+	// event the slot is being overwritten with
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.Name.store(name, std::memory_order_relaxed);
+	slot.Start.store(start, std::memory_order_relaxed);
+	slot.End.store(end, std::memory_order_relaxed);
+	slot.Depth.store(ring.Depth, std::memory_order_relaxed);
+	ring.Head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::BeginFrame()
+{
+	s_FrameStarts[s_Frame % MaxFrames] = Now();
+	++s_Frame;
+}
+
+void Profiler::Collect(std::vector<ProfileEvent>& events, uint64_t since)
+{
+	std::lock_guard<std::mutex> lock(s_RingsMutex);
+	for (const std::unique_ptr<ThreadRing>& ring : s_Rings)
+	{
+		const size_t first = events.size();
+		const uint64_t head = ring->Head.load(std::memory_order_acquire);
+		const uint64_t oldest = head > RingCapacity ? head - RingCapacity : 0;
+		uint64_t i = head;
+		for (; i > oldest; --i)
+		{
+			const Slot& slot = ring->Slots[(i - 1) % RingCapacity];
+			ProfileEvent event;
+			event.End = slot.End.load(std::memory_order_relaxed);
+			// events are written as they end, everything before this one ended earlier still
+			if (event.End <= since)
+			{
+				break;
+			}
+			event.Name = slot.Name.load(std::memory_order_relaxed);
+			event.Start = slot.Start.load(std::memory_order_relaxed);
+			event.Depth = slot.Depth.load(std::memory_order_relaxed);
+			event.Thread = ring->Index;
+			events.push_back(event);
+		}
+
+		// the writer kept going while the slots were copied, the oldest ones (copied last) may hold newer events
+		std::atomic_thread_fence(std::memory_order_acquire);
+		const uint64_t written = ring->Head.load(std::memory_order_relaxed);
+		const uint64_t valid = written >= RingCapacity ? written - RingCapacity + 1 : 0;
+		if (valid > i)
+		{
+			const size_t stale = (size_t)std::min<uint64_t>(valid - i, events.size() - first);
+			events.erase(events.end() - stale, events.end());
+		}
+	}
+}
+
+bool Profiler::ExportChromeTrace(const std::string& filepath)
+{
+	std::vector<ProfileEvent> events;
+	Collect(events);
+	std::vector<const char*> names;
+	GetThreadNames(names);
+
+	std::ofstream stream(filepath);
+	if (!stream)
+	{
+		return false;
+	}
+	// Chrome wants microseconds
+	stream << std::fixed << std::setprecision(3) << "{\"traceEvents\":[";
+	bool first = true;
+	for (size_t thread = 0; thread < names.size(); ++thread)
+	{
+		stream << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread
+			<< ",\"args\":{\"name\":";
+		if (names[thread])
+		{
+			WriteJsonString(stream, names[thread]);
+		}
+		else
+		{
+			stream << "\"Thread " << thread << "\"";
+		}
+		stream << "}}";
+		first = false;
+	}
+	for (const ProfileEvent& event : events)
+	{
+		stream << (first ? "" : ",") << "\n{\"name\":";
+		WriteJsonString(stream, event.Name);
+		stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":" << event.Start / 1000.0 << ",\"dur\":"
+			<< (event.End - event.Start) / 1000.0 << ",\"pid\":0,\"tid\":" << event.Thread << "}";
+		first = false;
+	}
+	stream << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	return (bool)stream;
+}
+
+void Profiler::OnImGuiRender()
+{
+	bool enabled = IsEnabled();
+	if (ImGui::Checkbox("Record", &enabled))
+	{
+		SetEnabled(enabled);
+	}
+	ImGui::SameLine();
+	ImGui::Checkbox("Pause", &s_Paused);
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace"))
+	{
+		s_ExportMessage = ExportChromeTrace("profile.json") ? "Wrote profile.json, open it in chrome://tracing"
+			: "Couldn't write profile.json";
+	}
+	if (!s_ExportMessage.empty())
+	{
+		ImGui::TextUnformatted(s_ExportMessage.c_str());
+	}
+
+	// the frame that just started is still being recorded, the one before is complete
+	if (!s_Paused && s_Frame >= 2)
+	{
+		s_CapturedStart = s_FrameStarts[(s_Frame - 2) % MaxFrames];
+		s_CapturedEnd = s_FrameStarts[(s_Frame - 1) % MaxFrames];
+		// only what ended since the frame started is copied, the frame after it is dropped here
+		s_Captured.clear();
+		Collect(s_Captured, s_CapturedStart);
+		const uint64_t end = s_CapturedEnd;
+		s_Captured.erase(std::remove_if(s_Captured.begin(), s_Captured.end(), [end](const ProfileEvent& event)
+		{
+			return event.Start >= end;
+		}), s_Captured.end());
+		GetThreadNames(s_ThreadNames);
+	}
+	if (s_CapturedEnd <= s_CapturedStart)
+	{
+		return;
+	}
+	const double duration = (double)(s_CapturedEnd - s_CapturedStart);
+	ImGui::Text("Frame: %.2f ms, %u scopes", duration / 1000000.0, (unsigned int)s_Captured.size());
+
+	// a lane per thread, as deep as its deepest scope in the frame
+	s_LaneDepths.assign(s_ThreadNames.size(), 0);
+	for (const ProfileEvent& event : s_Captured)
+	{
+		if (event.Thread < s_LaneDepths.size())
+		{
+			s_LaneDepths[event.Thread] = std::max(s_LaneDepths[event.Thread], event.Depth + 1);
+		}
+	}
+	unsigned int rows = 0;
+	for (unsigned int& depth : s_LaneDepths)
+	{
+		const unsigned int lane = depth;
+		depth = rows;
+		rows += lane;
+	}
+	if (rows == 0)
+	{
+		return;
+	}
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float labelWidth = 70.0f;
+	const float width = std::max(ImGui::GetContentRegionAvail().x - labelWidth, 100.0f);
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::InvisibleButton("Timeline", ImVec2(labelWidth + width, rowHeight * rows));
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	const ImVec2 mouse = ImGui::GetMousePos();
+	const bool hovered = ImGui::IsItemHovered();
+
+	char label[32];
+	for (size_t thread = 0; thread < s_ThreadNames.size(); ++thread)
+	{
+		const unsigned int next = thread + 1 < s_LaneDepths.size() ? s_LaneDepths[thread + 1] : rows;
+		if (next == s_LaneDepths[thread])
+		{
+			continue;
+		}
+		const ImVec2 labelMin(origin.x, origin.y + s_LaneDepths[thread] * rowHeight);
+		if (s_ThreadNames[thread])
+		{
+			drawList->AddText(labelMin, IM_COL32_WHITE, s_ThreadNames[thread]);
+		}
+		else
+		{
+			std::snprintf(label, sizeof(label), "Thread %u", (unsigned int)thread);
+			drawList->AddText(labelMin, IM_COL32_WHITE, label);
+		}
+		drawList->AddLine(ImVec2(origin.x, labelMin.y), ImVec2(origin.x + labelWidth + width, labelMin.y),
+			IM_COL32(255, 255, 255, 40));
+	}
+
+	const float left = origin.x + labelWidth;
+	for (const ProfileEvent& event : s_Captured)
+	{
+		// scopes crossing the frame boundaries are cut at the edges
+		const double start = std::max(event.Start, s_CapturedStart) - s_CapturedStart;
+		const double end = std::min(event.End, s_CapturedEnd) - s_CapturedStart;
+		const float row = (float)(s_LaneDepths[event.Thread] + event.Depth);
+		const ImVec2 min(left + (float)(start / duration) * width, origin.y + row * rowHeight);
+		const ImVec2 max(std::max(left + (float)(end / duration) * width, min.x + 1.0f), min.y + rowHeight - 2.0f);
+		drawList->AddRectFilled(min, max, GetScopeColor(event.Name));
+		drawList->PushClipRect(min, max, true);
+		drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, event.Name);
+		drawList->PopClipRect();
+		if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+		{
+			ImGui::SetTooltip("%s\n%.3f ms at %.3f ms", event.Name, (event.End - event.Start) / 1000000.0,
+				((double)event.Start - (double)s_CapturedStart) / 1000000.0);
+		}
+	}
+}
+
+Profiler::ThreadRing& Profiler::GetRing()
+{
+	thread_local ThreadRing* t_Ring = nullptr;
+	if (!t_Ring)
+	{
+		std::unique_ptr<ThreadRing> ring(new ThreadRing());
+		ring->Slots.reset(new Slot[RingCapacity]());
+		ring->Head.store(0, std::memory_order_relaxed);
+		ring->Depth = 0;
+		ring->Name = nullptr;
+
+		// kept after the thread exits, its events stay in the timeline and the trace
+		std::lock_guard<std::mutex> lock(s_RingsMutex);
+		ring->Index = (unsigned int)s_Rings.size();
+		t_Ring = ring.get();
+		s_Rings.push_back(std::move(ring));
+	}
+	return *t_Ring;
+}
+
+void Profiler::GetThreadNames(std::vector<const char*>& names)
+{
+	std::lock_guard<std::mutex> lock(s_RingsMutex);
+	names.clear();
+	for (const std::unique_ptr<ThreadRing>& ring : s_Rings)
+	{
+		names.push_back(ring->Name);
+	}
+}
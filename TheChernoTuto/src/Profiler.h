@@ -0,0 +1,130 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct ProfileEvent
+{
+	// a string literal or anything else that lives as long as the program
+	const char* Name;
+	// nanoseconds since the profiler started
+	uint64_t Start;
+	uint64_t End;
+	// number of enclosing scopes on the same thread
+	unsigned int Depth;
+	// the recording thread, in the order threads recorded their first event
+	unsigned int Thread;
+};
+
+/**
+ * \brief Hierarchical CPU profiler. PROFILE_SCOPE stamps the start of a scope and, when it closes, writes one
+ * event into a ring owned by the calling thread, so recording never locks and never allocates once a thread
+ * has its ring. Rings keep the last RingCapacity events of their thread and are read without stopping the
+ * writers: a reader copies the slots, then drops those the writer may have overwritten meanwhile.
+ *
+ * BeginFrame marks where frames start. OnImGuiRender draws the last complete frame as a flame graph with a lane
+ * per thread, ExportChromeTrace writes everything still in the rings as a trace chrome://tracing or Perfetto
+ * can open.
+ */
+class Profiler
+{
+public:
+	static const size_t RingCapacity = 16384;
+	static const size_t MaxFrames = 64;
+
+	inline static bool IsEnabled()
+	{
+		return s_Enabled.load(std::memory_order_relaxed);
+	}
+
+	static void SetEnabled(bool enabled);
+	// Names the calling thread in the timeline and the trace, name has to outlive the profiler
+	static void SetThreadName(const char* name);
+
+	static uint64_t Now();
+	// Used by ProfileScope, Begin returns the start timestamp End wants back
+	static uint64_t BeginScope();
+	static void EndScope(const char* name, uint64_t start);
+
+	// Once per frame on the main thread
+	static void BeginFrame();
+
+	// Appends the events still in the rings that ended after since, newest first on every thread
+	static void Collect(std::vector<ProfileEvent>& events, uint64_t since = 0);
+	static bool ExportChromeTrace(const std::string& filepath);
+
+	// Meant to sit inside an open ImGui window
+	static void OnImGuiRender();
+private:
+	struct Slot
+	{
+		std::atomic<const char*> Name;
+		std::atomic<uint64_t> Start;
+		std::atomic<uint64_t> End;
+		std::atomic<unsigned int> Depth;
+	};
+
+	struct ThreadRing
+	{
+		std::unique_ptr<Slot[]> Slots;
+		// events ever written, the next one goes to Head % RingCapacity
+		std::atomic<uint64_t> Head;
+		// owner only
+		unsigned int Depth;
+		unsigned int Index;
+		// guarded by s_RingsMutex, nullptr until the thread names itself
+		const char* Name;
+	};
+
+	static ThreadRing& GetRing();
+	// Thread names by index, nullptr for the threads that never named themselves
+	static void GetThreadNames(std::vector<const char*>& names);
+
+	static std::atomic<bool> s_Enabled;
+	static std::mutex s_RingsMutex;
+	static std::vector<std::unique_ptr<ThreadRing>> s_Rings;
+
+	// main thread only
+	static uint64_t s_FrameStarts[MaxFrames];
+	static uint64_t s_Frame;
+	static bool s_Paused;
+	static std::vector<ProfileEvent> s_Captured;
+	static std::vector<const char*> s_ThreadNames;
+	static std::vector<unsigned int> s_LaneDepths;
+	static uint64_t s_CapturedStart;
+	static uint64_t s_CapturedEnd;
+	static std::string s_ExportMessage;
+};
+
+// Records the enclosing scope under name, which has to outlive the profiler (a literal or __FUNCTION__)
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+		:m_Name(Profiler::IsEnabled() ? name : nullptr), m_Start(m_Name ? Profiler::BeginScope() : 0)
+	{
+	}
+
+	~ProfileScope()
+	{
+		if (m_Name)
+		{
+			Profiler::EndScope(m_Name, m_Start);
+		}
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+private:
+	const char* m_Name;
+	uint64_t m_Start;
+};
+
+#define PROFILE_SCOPE_NAME2(line) profileScope##line
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME2(line)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
@@ -0,0 +1,324 @@
+#include "Qoi.h"
+
+#include "stb_image/stb_image.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+	const unsigned char OpIndex = 0x00;
+	const unsigned char OpDiff = 0x40;
+	const unsigned char OpLuma = 0x80;
+	const unsigned char OpRun = 0xc0;
+	const unsigned char OpRGB = 0xfe;
+	const unsigned char OpRGBA = 0xff;
+	const unsigned char OpMask = 0xc0;
+
+	const unsigned char Padding[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+	// guards against headers that would make width * height * channels overflow
+	const unsigned int MaxPixels = 400000000;
+
+	struct Pixel
+	{
+		unsigned char r, g, b, a;
+	};
+
+	inline bool operator==(const Pixel& lhs, const Pixel& rhs)
+	{
+		return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+	}
+
+	inline unsigned int Hash(const Pixel& p)
+	{
+		return (p.r * 3 + p.g * 5 + p.b * 7 + p.a * 11) & 63;
+	}
+
+	inline unsigned int ReadU32(const unsigned char* bytes)
+	{
+		return ((unsigned int)bytes[0] << 24) | ((unsigned int)bytes[1] << 16) | ((unsigned int)bytes[2] << 8) | bytes[3];
+	}
+
+	inline void WriteU32(std::vector<unsigned char>& output, unsigned int value)
+	{
+		output.push_back((unsigned char)(value >> 24));
+		output.push_back((unsigned char)(value >> 16));
+		output.push_back((unsigned char)(value >> 8));
+		output.push_back((unsigned char)value);
+	}
+
+	bool ReadFile(const std::string& filepath, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+		bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		return true;
+	}
+}
+
+bool Qoi::IsQoi(const unsigned char* data, size_t size)
+{
+	return data && size >= HeaderSize && std::memcmp(data, "qoif", 4) == 0;
+}
+
+bool Qoi::IsQoiFile(const std::string& filepath)
+{
+	std::ifstream stream(filepath, std::ios::binary);
+	unsigned char magic[HeaderSize] = {};
+	stream.read((char*)magic, HeaderSize);
+	return stream && IsQoi(magic, HeaderSize);
+}
+
+unsigned char* Qoi::LoadFromMemory(const unsigned char* data, size_t size, int* width, int* height,
+	int* channels, int desiredChannels, bool flipVertically)
+{
+	if (!IsQoi(data, size) || size < HeaderSize + sizeof(Padding))
+	{
+		return nullptr;
+	}
+
+	const unsigned int w = ReadU32(data + 4);
+	const unsigned int h = ReadU32(data + 8);
+	const int fileChannels = data[12];
+	if (w == 0 || h == 0 || (fileChannels != 3 && fileChannels != 4) || h >= MaxPixels / w)
+	{
+		return nullptr;
+	}
+	if (desiredChannels != 0 && desiredChannels != 3 && desiredChannels != 4)
+	{
+		return nullptr;
+	}
+
+	const int outChannels = desiredChannels ? desiredChannels : fileChannels;
+	const size_t rowSize = (size_t)w * outChannels;
+	unsigned char* pixels = (unsigned char*)std::malloc(rowSize * h);
+	if (!pixels)
+	{
+		return nullptr;
+	}
+
+	Pixel index[64];
+	std::memset(index, 0, sizeof(index));
+	Pixel px = { 0, 0, 0, 255 };
+
+	const size_t chunksEnd = size - sizeof(Padding);
+	size_t p = HeaderSize;
+	int run = 0;
+	for (unsigned int y = 0; y < h; ++y)
+	{
+		unsigned char* row = pixels + rowSize * (flipVertically ? h - 1 - y : y);
+		for (unsigned int x = 0; x < w; ++x)
+		{
+			if (run > 0)
+			{
+				--run;
+			}
+			else if (p < chunksEnd)
+			{
+				const unsigned char b1 = data[p++];
+				if (b1 == OpRGB)
+				{
+					px.r = data[p];
+					px.g = data[p + 1];
+					px.b = data[p + 2];
+					p += 3;
+				}
+				else if (b1 == OpRGBA)
+				{
+					px.r = data[p];
+					px.g = data[p + 1];
+					px.b = data[p + 2];
+					px.a = data[p + 3];
+					p += 4;
+				}
+				else if ((b1 & OpMask) == OpIndex)
+				{
+					px = index[b1];
+				}
+				else if ((b1 & OpMask) == OpDiff)
+				{
+					px.r += ((b1 >> 4) & 0x03) - 2;
+					px.g += ((b1 >> 2) & 0x03) - 2;
+					px.b += (b1 & 0x03) - 2;
+				}
+				else if ((b1 & OpMask) == OpLuma)
+				{
+					const unsigned char b2 = data[p++];
+					const int vg = (b1 & 0x3f) - 32;
+					px.r += vg - 8 + ((b2 >> 4) & 0x0f);
+					px.g += vg;
+					px.b += vg - 8 + (b2 & 0x0f);
+				}
+				else
+				{
+					run = b1 & 0x3f;
+				}
+				index[Hash(px)] = px;
+			}
+
+			unsigned char* dst = row + (size_t)x * outChannels;
+			dst[0] = px.r;
+			dst[1] = px.g;
+			dst[2] = px.b;
+			if (outChannels == 4)
+			{
+				dst[3] = px.a;
+			}
+		}
+	}
+
+	*width = (int)w;
+	*height = (int)h;
+	*channels = fileChannels;
+	return pixels;
+}
+
+unsigned char* Qoi::Load(const std::string& filepath, int* width, int* height, int* channels,
+	int desiredChannels, bool flipVertically)
+{
+	std::vector<unsigned char> bytes;
+	if (!ReadFile(filepath, bytes))
+	{
+		return nullptr;
+	}
+	return LoadFromMemory(bytes.data(), bytes.size(), width, height, channels, desiredChannels, flipVertically);
+}
+
+void Qoi::Free(void* pixels)
+{
+	std::free(pixels);
+}
+
+bool Qoi::Encode(const unsigned char* pixels, int width, int height, int channels, std::vector<unsigned char>& output)
+{
+	if (!pixels || width <= 0 || height <= 0 || (channels != 3 && channels != 4)
+		|| (unsigned int)height >= MaxPixels / (unsigned int)width)
+	{
+		return false;
+	}
+
+	const size_t pixelCount = (size_t)width * height;
+	output.reserve(output.size() + HeaderSize + pixelCount * (channels + 1) / 2 + sizeof(Padding));
+
+	output.insert(output.end(), { 'q', 'o', 'i', 'f' });
+	WriteU32(output, (unsigned int)width);
+	WriteU32(output, (unsigned int)height);
+	output.push_back((unsigned char)channels);
+	output.push_back(0); // sRGB with linear alpha
+
+	Pixel index[64];
+	std::memset(index, 0, sizeof(index));
+	Pixel previous = { 0, 0, 0, 255 };
+	Pixel px = previous;
+	int run = 0;
+
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		const unsigned char* src = pixels + i * channels;
+		px.r = src[0];
+		px.g = src[1];
+		px.b = src[2];
+		if (channels == 4)
+		{
+			px.a = src[3];
+		}
+
+		if (px == previous)
+		{
+			++run;
+			if (run == 62 || i == pixelCount - 1)
+			{
+				output.push_back((unsigned char)(OpRun | (run - 1)));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run > 0)
+		{
+			output.push_back((unsigned char)(OpRun | (run - 1)));
+			run = 0;
+		}
+
+		const unsigned int hash = Hash(px);
+		if (index[hash] == px)
+		{
+			output.push_back((unsigned char)(OpIndex | hash));
+		}
+		else
+		{
+			index[hash] = px;
+			if (px.a == previous.a)
+			{
+				const signed char vr = (signed char)(px.r - previous.r);
+				const signed char vg = (signed char)(px.g - previous.g);
+				const signed char vb = (signed char)(px.b - previous.b);
+				const signed char vgr = (signed char)(vr - vg);
+				const signed char vgb = (signed char)(vb - vg);
+
+				if (vr > -3 && vr < 2 && vg > -3 && vg < 2 && vb > -3 && vb < 2)
+				{
+					output.push_back((unsigned char)(OpDiff | (vr + 2) << 4 | (vg + 2) << 2 | (vb + 2)));
+				}
+				else if (vgr > -9 && vgr < 8 && vg > -33 && vg < 32 && vgb > -9 && vgb < 8)
+				{
+					output.push_back((unsigned char)(OpLuma | (vg + 32)));
+					output.push_back((unsigned char)((vgr + 8) << 4 | (vgb + 8)));
+				}
+				else
+				{
+					output.insert(output.end(), { OpRGB, px.r, px.g, px.b });
+				}
+			}
+			else
+			{
+				output.insert(output.end(), { OpRGBA, px.r, px.g, px.b, px.a });
+			}
+		}
+		previous = px;
+	}
+
+	output.insert(output.end(), Padding, Padding + sizeof(Padding));
+	return true;
+}
+
+bool Qoi::Write(const std::string& filepath, const unsigned char* pixels, int width, int height, int channels)
+{
+	std::vector<unsigned char> bytes;
+	if (!Encode(pixels, width, height, channels, bytes))
+	{
+		return false;
+	}
+
+	std::ofstream stream(filepath, std::ios::binary);
+	stream.write((const char*)bytes.data(), bytes.size());
+	return (bool)stream;
+}
+
+bool Qoi::ConvertFile(const std::string& source, const std::string& destination)
+{
+	int width, height, channels;
+	// stb_image is asked for the file orientation, the flip happens when the QOI file is loaded
+	stbi_set_flip_vertically_on_load_thread(0);
+	if (!stbi_info(source.c_str(), &width, &height, &channels))
+	{
+		return false;
+	}
+
+	// 1 and 2 channel images have no QOI equivalent, gray + alpha keeps its alpha
+	const int outChannels = (channels == 2 || channels == 4) ? 4 : 3;
+	unsigned char* pixels = stbi_load(source.c_str(), &width, &height, &channels, outChannels);
+	if (!pixels)
+	{
+		return false;
+	}
+
+	const bool written = Write(destination, pixels, width, height, outChannels);
+	stbi_image_free(pixels);
+	return written;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+#include <vector>
+
+/**
+ * \brief Encoder and decoder for the "Quite OK Image" format (https://qoiformat.org).
+ * QOI is lossless like PNG with comparable sizes but decodes several times faster since it is
+ * a single pass over the bytes without any entropy coding. Only 3 and 4 channel images exist in QOI.
+ */
+class Qoi
+{
+public:
+	static const unsigned int HeaderSize = 14;
+
+	static bool IsQoi(const unsigned char* data, size_t size);
+	// Only reads the signature, used to route a file to this decoder rather than to stb_image
+	static bool IsQoiFile(const std::string& filepath);
+
+	/**
+	 * \brief Same call shape as stbi_load_from_memory
+	 * \param desiredChannels 0 keeps the channel count of the file, otherwise 3 or 4
+	 * \param flipVertically writes the rows bottom up, like stbi_set_flip_vertically_on_load
+	 * \return pixels allocated with malloc that must be released with Qoi::Free, nullptr on failure
+	 */
+	static unsigned char* LoadFromMemory(const unsigned char* data, size_t size, int* width, int* height,
+		int* channels, int desiredChannels, bool flipVertically = false);
+	static unsigned char* Load(const std::string& filepath, int* width, int* height, int* channels,
+		int desiredChannels, bool flipVertically = false);
+	static void Free(void* pixels);
+
+	// Encodes tightly packed 3 or 4 channel pixels, appending the file to output
+	static bool Encode(const unsigned char* pixels, int width, int height, int channels, std::vector<unsigned char>& output);
+	static bool Write(const std::string& filepath, const unsigned char* pixels, int width, int height, int channels);
+
+	// Converts any image stb_image can read (PNG, TGA, ...) to a QOI file, gray images are widened to RGB(A)
+	static bool ConvertFile(const std::string& source, const std::string& destination);
+};
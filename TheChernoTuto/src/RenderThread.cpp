@@ -0,0 +1,242 @@
+#include "RenderThread.h"
+
+#include "GLFW/glfw3.h"
+#include "imgui/imgui_impl_opengl3.h"
+
+#include "AllocationTracker.h"
+#include "DeletionQueue.h"
+#include "FrameAllocator.h"
+#include "Profiler.h"
+#include "Texture.h"
+#include "TextureResidency.h"
+
+#include <chrono>
+#include <cstring>
+#include <new>
+
+namespace
+{
+	template<typename T>
+	void CopyToFrame(ImVector<T>& destination, const ImVector<T>& source)
+	{
+		T* data = FrameAllocator::Allocate<T>((size_t)source.Size);
+		std::memcpy(data, source.Data, (size_t)source.Size * sizeof(T));
+		destination.Data = data;
+		destination.Size = destination.Capacity = source.Size;
+	}
+}
+
+FramePacket::FramePacket()
+	:Frame(0), ViewProjection(1.0f)
+{
+}
+
+FramePacket::~FramePacket()
+{
+	ReleaseImGui();
+}
+
+void FramePacket::CaptureImGui(const ImDrawData* drawData)
+{
+	ReleaseImGui();
+	if (!drawData || !drawData->Valid)
+	{
+		return;
+	}
+	ImGuiData.Valid = true;
+	ImGuiData.CmdListsCount = drawData->CmdListsCount;
+	ImGuiData.TotalIdxCount = drawData->TotalIdxCount;
+	ImGuiData.TotalVtxCount = drawData->TotalVtxCount;
+	ImGuiData.DisplayPos = drawData->DisplayPos;
+	ImGuiData.DisplaySize = drawData->DisplaySize;
+	ImGuiData.FramebufferScale = drawData->FramebufferScale;
+	ImGuiData.OwnerViewport = drawData->OwnerViewport;
+
+	// the lists ImGui returns are reused by the next NewFrame, the vertices and commands are copied out to frame
+	// memory. The copies are never destroyed, the destructor would hand the frame memory to ImGui's free
+	for (int i = 0; i < drawData->CmdLists.Size; ++i)
+	{
+		const ImDrawList& source = *drawData->CmdLists[i];
+		ImDrawList* list = new (FrameAllocator::Allocate<ImDrawList>(1)) ImDrawList(source._Data);
+		CopyToFrame(list->CmdBuffer, source.CmdBuffer);
+		CopyToFrame(list->IdxBuffer, source.IdxBuffer);
+		CopyToFrame(list->VtxBuffer, source.VtxBuffer);
+		list->Flags = source.Flags;
+		ImGuiData.CmdLists.push_back(list);
+	}
+}
+
+void FramePacket::ReleaseImGui()
+{
+	// the lists live in frame memory, only the array of pointers is kept for the next frame
+	ImGuiData.Clear();
+}
+
+RenderThread::RenderThread(GLFWwindow* window)
+	:m_Window(window), m_Current(nullptr), m_Frame(0), m_RenderOwnsContext(false), m_Stop(false), m_Stats()
+{
+}
+
+RenderThread::~RenderThread()
+{
+	Stop();
+}
+
+void RenderThread::Start()
+{
+	if (IsRunning())
+	{
+		return;
+	}
+	m_Stop = false;
+	m_Thread = std::thread(&RenderThread::Main, this);
+}
+
+void RenderThread::Stop()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Stop = true;
+	}
+	m_Condition.notify_all();
+	m_Thread.join();
+	glfwMakeContextCurrent(m_Window);
+}
+
+FramePacket& RenderThread::BeginPacket()
+{
+	// the other packet is the one that may still be drawn
+	m_Current = &m_Packets[m_Frame % 2];
+	m_Current->Frame = ++m_Frame;
+	m_Current->Draws.clear();
+	m_Current->ReleaseImGui();
+	return *m_Current;
+}
+
+void RenderThread::AcquireContext()
+{
+	if (!IsRunning())
+	{
+		return;
+	}
+	const auto start = std::chrono::high_resolution_clock::now();
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_Condition.wait(lock, [this]()
+		{
+			return !m_RenderOwnsContext;
+		});
+		m_Stats.WaitMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::high_resolution_clock::now() - start).count();
+	}
+	glfwMakeContextCurrent(m_Window);
+}
+
+void RenderThread::Submit()
+{
+	FramePacket& packet = *m_Current;
+	m_Current = nullptr;
+	if (!IsRunning())
+	{
+		Execute(packet);
+		return;
+	}
+
+	glfwMakeContextCurrent(nullptr);
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_RenderOwnsContext = true;
+	}
+	// never full, a packet is only submitted once the render thread gave the context back
+	while (!m_Submitted.TryPush(&packet))
+	{
+		std::this_thread::yield();
+	}
+	{
+		// taken so the render thread can't miss the wakeup between its check and its wait
+		std::lock_guard<std::mutex> lock(m_Mutex);
+	}
+	m_Condition.notify_all();
+}
+
+RenderThreadStats RenderThread::GetStats() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Stats;
+}
+
+void RenderThread::Main()
+{
+	Profiler::SetThreadName("Render");
+	while (true)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Condition.wait(lock, [this]()
+			{
+				return m_Stop || !m_Submitted.IsEmpty();
+			});
+		}
+
+		FramePacket* packet;
+		if (!m_Submitted.TryPop(packet))
+		{
+			// only stopped once everything submitted has been presented
+			return;
+		}
+
+		glfwMakeContextCurrent(m_Window);
+		Execute(*packet);
+		glfwMakeContextCurrent(nullptr);
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_RenderOwnsContext = false;
+		}
+		m_Condition.notify_all();
+	}
+}
+
+void RenderThread::Execute(FramePacket& packet)
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Renderer);
+	const auto start = std::chrono::high_resolution_clock::now();
+	for (const DrawCommand& draw : packet.Draws)
+	{
+		if (draw.Image)
+		{
+			// binding also keeps it from being evicted
+			draw.Image->Bind();
+		}
+		draw.Program->Bind();
+		draw.Program->SetUniformMat4f("u_MVP", packet.ViewProjection * draw.Model);
+		m_Renderer.Draw(*draw.Vertices, *draw.Indices, *draw.Program);
+	}
+	if (packet.ImGuiData.Valid)
+	{
+		PROFILE_SCOPE("ImGui draw");
+		ImGui_ImplOpenGL3_RenderDrawData(&packet.ImGuiData);
+	}
+	packet.ReleaseImGui();
+
+	// every texture drawn this frame has been bound by now
+	TextureResidency::Update();
+	// objects released this frame are deleted once the GPU is past it
+	DeletionQueue::EndFrame();
+
+	const auto swap = std::chrono::high_resolution_clock::now();
+	{
+		PROFILE_SCOPE("Swap buffers");
+		glfwSwapBuffers(m_Window);
+	}
+	const auto end = std::chrono::high_resolution_clock::now();
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Stats.RenderMilliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+	m_Stats.SwapMilliseconds = std::chrono::duration<double, std::milli>(end - swap).count();
+	++m_Stats.Frames;
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "imgui/imgui.h"
+
+#include "Renderer.h"
+#include "SpscQueue.h"
+
+struct GLFWwindow;
+class Texture;
+
+struct DrawCommand
+{
+	const VertexArray* Vertices;
+	const IndexBuffer* Indices;
+	Shader* Program;
+	// bound to slot 0, may be null
+	const Texture* Image;
+	glm::mat4 Model;
+};
+
+/**
+ * \brief Everything the render thread needs to draw one frame: the camera, the draws with their model matrices
+ * and a copy of the ImGui draw lists, so the main thread can start the next ImGui frame while this one is drawn.
+ * The main thread doesn't touch a packet again once it is submitted. The ImGui copy lives in FrameAllocator
+ * memory, the packet has to be drawn before that frame's arena comes around again.
+ */
+struct FramePacket
+{
+	FramePacket();
+	~FramePacket();
+
+	FramePacket(const FramePacket&) = delete;
+	FramePacket& operator=(const FramePacket&) = delete;
+
+	// Deep copy of the draw data returned by ImGui::GetDrawData, allocated from the current frame
+	void CaptureImGui(const ImDrawData* drawData);
+	void ReleaseImGui();
+
+	unsigned long long Frame;
+	glm::mat4 ViewProjection;
+	std::vector<DrawCommand> Draws;
+	ImDrawData ImGuiData;
+};
+
+struct RenderThreadStats
+{
+	// main thread, waiting for the render thread to hand the context back
+	double WaitMilliseconds;
+	// drawing the last packet and presenting it
+	double RenderMilliseconds;
+	double SwapMilliseconds;
+	unsigned long long Frames;
+};
+
+/**
+ * \brief Draws and presents frame packets on its own thread. Each frame the main thread runs the simulation
+ * and fills a packet without the GL context, takes the context with AcquireContext for the work that still
+ * calls GL directly (uploads, the tests' OnRender, building ImGui), then hands packet and context over with
+ * Submit. While the render thread draws and swaps, the main thread already simulates the next frame, so the
+ * frame time gets closer to the longest of the two than to their sum.
+ *
+ * Packets go through a lock free SPSC queue and are double buffered: the next one is filled while the
+ * previous one is still being drawn. The context only ever is current on one thread, the handover goes
+ * through the mutex so everything the main thread did with it is visible to the render thread and back.
+ * When the thread isn't started, Submit draws the packet right away on the calling thread.
+ */
+class RenderThread
+{
+public:
+	explicit RenderThread(GLFWwindow* window);
+	~RenderThread();
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+
+	// Both have to be called from the thread owning the context, between Submit and the next AcquireContext
+	void Start();
+	// Draws what was submitted, joins the thread and makes the context current on the calling thread again
+	void Stop();
+
+	inline bool IsRunning() const
+	{
+		return m_Thread.joinable();
+	}
+
+	// The packet for the next frame, the other one may still be drawn
+	FramePacket& BeginPacket();
+	// Waits until the render thread is done with the last packet and makes the context current here
+	void AcquireContext();
+	// Hands the packet from BeginPacket and the context to the render thread
+	void Submit();
+
+	RenderThreadStats GetStats() const;
+private:
+	void Main();
+	void Execute(FramePacket& packet);
+
+	GLFWwindow* m_Window;
+	Renderer m_Renderer;
+	FramePacket m_Packets[2];
+	FramePacket* m_Current;
+	unsigned long long m_Frame;
+
+	SpscQueue<FramePacket*, 2> m_Submitted;
+	std::thread m_Thread;
+	// only used to sleep and wake up, the packets themselves don't need it
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Condition;
+	bool m_RenderOwnsContext;
+	bool m_Stop;
+	RenderThreadStats m_Stats;
+};
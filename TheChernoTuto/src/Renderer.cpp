@@ -1,4 +1,5 @@
 ﻿#include "Renderer.h"
+#include "Profiler.h"
 #include <iostream>
 
 void GlClearError()
@@ -20,6 +21,7 @@ bool GlLogCall(const char* function, const char* file, int line)
 
 void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const
 {
+    PROFILE_FUNCTION();
     // SET THE STATE
     shader.Bind();
     va.Bind();
@@ -28,6 +30,16 @@ void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader&
     GlCall(glDrawElements(GL_TRIANGLES, ib.GetCount(), GL_UNSIGNED_INT, nullptr));
 }
 
+void Renderer::Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount) const
+{
+    PROFILE_FUNCTION();
+    shader.Bind();
+    va.Bind();
+    ib.Bind();
+
+    GlCall(glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr));
+}
+
 void Renderer::Clear()
 {
     GlCall(glClear(GL_COLOR_BUFFER_BIT));
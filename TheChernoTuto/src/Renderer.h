@@ -19,5 +19,7 @@ class Renderer
 //private:
 public:
 	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader) const;
+	// Only draws the first indexCount indices, for buffers that are filled partially every frame
+	void Draw(const VertexArray& va, const IndexBuffer& ib, const Shader& shader, unsigned int indexCount) const;
 	void Clear();
 };
\ No newline at end of file
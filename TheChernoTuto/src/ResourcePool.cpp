@@ -0,0 +1,139 @@
+#include "ResourcePool.h"
+
+#include "Renderer.h"
+
+std::vector<uint32_t> ResourcePool::s_DenseSlots;
+std::vector<uint8_t> ResourcePool::s_Generations;
+std::vector<uint32_t> ResourcePool::s_FreeIndices;
+std::vector<ResourceHandle> ResourcePool::s_Handles;
+std::vector<unsigned int> ResourcePool::s_RendererIDs;
+std::vector<size_t> ResourcePool::s_Sizes;
+unsigned int ResourcePool::s_Created = 0;
+unsigned int ResourcePool::s_Destroyed = 0;
+unsigned int ResourcePool::s_StaleLookups = 0;
+
+ResourceHandle ResourcePool::Create(ResourceType type, unsigned int rendererID, size_t bytes)
+{
+	ASSERT(type != ResourceType::None && type != ResourceType::Count);
+
+	uint32_t index;
+	if (!s_FreeIndices.empty())
+	{
+		index = s_FreeIndices.back();
+		s_FreeIndices.pop_back();
+	}
+	else
+	{
+		index = (uint32_t)s_DenseSlots.size();
+		ASSERT(index <= ResourceHandle::MaxIndex);
+		s_DenseSlots.push_back(0);
+		s_Generations.push_back(0);
+	}
+
+	ResourceHandle handle;
+	handle.Value = index | ((uint32_t)s_Generations[index] << ResourceHandle::IndexBits)
+		| ((uint32_t)type << (ResourceHandle::IndexBits + ResourceHandle::GenerationBits));
+
+	s_DenseSlots[index] = (uint32_t)s_Handles.size();
+	s_Handles.push_back(handle);
+	s_RendererIDs.push_back(rendererID);
+	s_Sizes.push_back(bytes);
+	++s_Created;
+	return handle;
+}
+
+void ResourcePool::Destroy(ResourceHandle handle)
+{
+	const uint32_t slot = Find(handle);
+	if (slot == InvalidSlot)
+	{
+		return;
+	}
+
+	// the last resource fills the hole so the dense arrays stay packed
+	const uint32_t last = (uint32_t)s_Handles.size() - 1;
+	s_Handles[slot] = s_Handles[last];
+	s_RendererIDs[slot] = s_RendererIDs[last];
+	s_Sizes[slot] = s_Sizes[last];
+	s_DenseSlots[s_Handles[slot].GetIndex()] = slot;
+	s_Handles.pop_back();
+	s_RendererIDs.pop_back();
+	s_Sizes.pop_back();
+
+	const uint32_t index = handle.GetIndex();
+	s_DenseSlots[index] = InvalidSlot;
+	// wraps after 256 reuses of the same slot, enough to catch handles kept a little too long
+	++s_Generations[index];
+	s_FreeIndices.push_back(index);
+	++s_Destroyed;
+}
+
+uint32_t ResourcePool::Find(ResourceHandle handle)
+{
+	if (handle.IsNull())
+	{
+		return InvalidSlot;
+	}
+	const uint32_t index = handle.GetIndex();
+	if (index >= s_DenseSlots.size() || s_Generations[index] != handle.GetGeneration()
+		|| s_DenseSlots[index] == InvalidSlot || s_Handles[s_DenseSlots[index]] != handle)
+	{
+		++s_StaleLookups;
+		return InvalidSlot;
+	}
+	return s_DenseSlots[index];
+}
+
+bool ResourcePool::IsValid(ResourceHandle handle)
+{
+	return Find(handle) != InvalidSlot;
+}
+
+unsigned int ResourcePool::GetRendererID(ResourceHandle handle)
+{
+	const uint32_t slot = Find(handle);
+	return slot == InvalidSlot ? 0 : s_RendererIDs[slot];
+}
+
+size_t ResourcePool::GetSizeInBytes(ResourceHandle handle)
+{
+	const uint32_t slot = Find(handle);
+	return slot == InvalidSlot ? 0 : s_Sizes[slot];
+}
+
+void ResourcePool::SetSizeInBytes(ResourceHandle handle, size_t bytes)
+{
+	const uint32_t slot = Find(handle);
+	if (slot != InvalidSlot)
+	{
+		s_Sizes[slot] = bytes;
+	}
+}
+
+const char* ResourcePool::GetTypeName(ResourceType type)
+{
+	switch (type)
+	{
+	case ResourceType::VertexBuffer: return "Vertex buffer";
+	case ResourceType::IndexBuffer:  return "Index buffer";
+	case ResourceType::VertexArray:  return "Vertex array";
+	case ResourceType::Shader:       return "Shader";
+	case ResourceType::Texture:      return "Texture";
+	default:                         return "None";
+	}
+}
+
+ResourcePoolStats ResourcePool::GetStats()
+{
+	ResourcePoolStats stats = {};
+	for (size_t i = 0; i < s_Handles.size(); ++i)
+	{
+		const size_t type = (size_t)s_Handles[i].GetType();
+		++stats.Live[type];
+		stats.Bytes[type] += s_Sizes[i];
+	}
+	stats.Created = s_Created;
+	stats.Destroyed = s_Destroyed;
+	stats.StaleLookups = s_StaleLookups;
+	return stats;
+}
@@ -0,0 +1,134 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class ResourceType : uint8_t
+{
+	None = 0,
+	VertexBuffer,
+	IndexBuffer,
+	VertexArray,
+	Shader,
+	Texture,
+	Count
+};
+
+/**
+ * \brief 32 bit reference to a GL object owned elsewhere: 20 bits of slot index, 8 bits of generation and 4 bits
+ * of type. The generation changes every time a slot is reused, so a handle to a destroyed resource is detected
+ * instead of silently reaching its successor. Handles compare and sort as plain integers, grouping by type first.
+ */
+struct ResourceHandle
+{
+	static const uint32_t IndexBits = 20;
+	static const uint32_t GenerationBits = 8;
+	static const uint32_t MaxIndex = (1u << IndexBits) - 1;
+
+	// 0 is the null handle, valid handles never have type None
+	uint32_t Value = 0;
+
+	inline uint32_t GetIndex() const
+	{
+		return Value & MaxIndex;
+	}
+
+	inline uint32_t GetGeneration() const
+	{
+		return (Value >> IndexBits) & ((1u << GenerationBits) - 1);
+	}
+
+	inline ResourceType GetType() const
+	{
+		return (ResourceType)(Value >> (IndexBits + GenerationBits));
+	}
+
+	inline bool IsNull() const
+	{
+		return Value == 0;
+	}
+
+	bool operator==(const ResourceHandle& other) const
+	{
+		return Value == other.Value;
+	}
+
+	bool operator!=(const ResourceHandle& other) const
+	{
+		return Value != other.Value;
+	}
+
+	bool operator<(const ResourceHandle& other) const
+	{
+		return Value < other.Value;
+	}
+};
+
+struct ResourcePoolStats
+{
+	unsigned int Live[(size_t)ResourceType::Count];
+	size_t Bytes[(size_t)ResourceType::Count];
+	unsigned int Created;
+	unsigned int Destroyed;
+	// lookups through handles of resources destroyed since
+	unsigned int StaleLookups;
+};
+
+/**
+ * \brief Registry of every live GL object, filled by the owning wrappers (VertexBuffer, IndexBuffer, VertexArray,
+ * Shader, Texture) which stay responsible for creating and deleting the object. Each wrapper is the single owner
+ * of its object, so they are move only: a move hands the object and its handle over, a copy would delete it twice.
+ * Handle indices map to positions in dense arrays (GL id, size, handle) that are kept packed on removal, so walking
+ * every resource of the pool touches contiguous memory only.
+ */
+class ResourcePool
+{
+public:
+	static ResourceHandle Create(ResourceType type, unsigned int rendererID, size_t bytes = 0);
+	// Null and stale handles are ignored
+	static void Destroy(ResourceHandle handle);
+
+	static bool IsValid(ResourceHandle handle);
+	// 0 for null and stale handles
+	static unsigned int GetRendererID(ResourceHandle handle);
+	static size_t GetSizeInBytes(ResourceHandle handle);
+	static void SetSizeInBytes(ResourceHandle handle, size_t bytes);
+
+	// Dense views, one entry per live resource in no particular order
+	inline static const std::vector<ResourceHandle>& GetHandles()
+	{
+		return s_Handles;
+	}
+
+	inline static const std::vector<unsigned int>& GetRendererIDs()
+	{
+		return s_RendererIDs;
+	}
+
+	inline static const std::vector<size_t>& GetSizes()
+	{
+		return s_Sizes;
+	}
+
+	static const char* GetTypeName(ResourceType type);
+	static ResourcePoolStats GetStats();
+private:
+	static const uint32_t InvalidSlot = 0xffffffff;
+
+	// dense position of the handle's resource, InvalidSlot when the handle is stale
+	static uint32_t Find(ResourceHandle handle);
+
+	// indexed by handle index
+	static std::vector<uint32_t> s_DenseSlots;
+	static std::vector<uint8_t> s_Generations;
+	static std::vector<uint32_t> s_FreeIndices;
+
+	// indexed by dense position
+	static std::vector<ResourceHandle> s_Handles;
+	static std::vector<unsigned int> s_RendererIDs;
+	static std::vector<size_t> s_Sizes;
+
+	static unsigned int s_Created;
+	static unsigned int s_Destroyed;
+	static unsigned int s_StaleLookups;
+};
@@ -0,0 +1,100 @@
+#include "SamplerCache.h"
+
+#include "Renderer.h"
+
+#include <algorithm>
+#include <functional>
+
+std::unordered_map<SamplerState, unsigned int, SamplerCache::StateHash> SamplerCache::s_Samplers;
+unsigned int SamplerCache::s_BoundSamplers[SamplerCache::MaxSlots] = {};
+SamplerCacheStats SamplerCache::s_Stats = {};
+
+namespace
+{
+	unsigned int ToGLWrap(TextureWrap wrap)
+	{
+		switch (wrap)
+		{
+		case TextureWrap::Repeat: return GL_REPEAT;
+		case TextureWrap::Mirror: return GL_MIRRORED_REPEAT;
+		default:                  return GL_CLAMP_TO_EDGE;
+		}
+	}
+}
+
+size_t SamplerCache::StateHash::operator()(const SamplerState& state) const
+{
+	return std::hash<float>()(state.MaxAnisotropy) ^ ((size_t)state.Filter << 8) ^ ((size_t)state.Wrap << 12);
+}
+
+unsigned int SamplerCache::Get(const SamplerState& state)
+{
+	auto it = s_Samplers.find(state);
+	if (it != s_Samplers.end())
+	{
+		return it->second;
+	}
+
+	unsigned int sampler = 0;
+	GlCall(glGenSamplers(1, &sampler));
+
+	const unsigned int minFilter = state.Filter == TextureFilter::Nearest ? GL_NEAREST
+		: state.Filter == TextureFilter::Linear ? GL_LINEAR : GL_LINEAR_MIPMAP_LINEAR;
+	GlCall(glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, minFilter));
+	GlCall(glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, state.Filter == TextureFilter::Nearest ? GL_NEAREST : GL_LINEAR));
+	GlCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, ToGLWrap(state.Wrap)));
+	GlCall(glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, ToGLWrap(state.Wrap)));
+
+	if (state.MaxAnisotropy > 1.0f && GLEW_EXT_texture_filter_anisotropic)
+	{
+		float maxSupported = 1.0f;
+		GlCall(glGetFloatv(GL_MAX_TEXTURE_MAX_ANISOTROPY_EXT, &maxSupported));
+		GlCall(glSamplerParameterf(sampler, GL_TEXTURE_MAX_ANISOTROPY_EXT, std::min(state.MaxAnisotropy, maxSupported)));
+	}
+
+	s_Samplers[state] = sampler;
+	++s_Stats.Samplers;
+	return sampler;
+}
+
+void SamplerCache::Bind(unsigned int slot, const SamplerState& state)
+{
+	ASSERT(slot < MaxSlots);
+	const unsigned int sampler = Get(state);
+	if (s_BoundSamplers[slot] == sampler)
+	{
+		++s_Stats.RedundantBinds;
+		return;
+	}
+	GlCall(glBindSampler(slot, sampler));
+	s_BoundSamplers[slot] = sampler;
+	++s_Stats.Binds;
+}
+
+void SamplerCache::Unbind(unsigned int slot)
+{
+	ASSERT(slot < MaxSlots);
+	GlCall(glBindSampler(slot, 0));
+	s_BoundSamplers[slot] = 0;
+}
+
+void SamplerCache::Invalidate()
+{
+	std::fill(s_BoundSamplers, s_BoundSamplers + MaxSlots, 0u);
+}
+
+void SamplerCache::Clear()
+{
+	for (const auto& sampler : s_Samplers)
+	{
+		GlCall(glDeleteSamplers(1, &sampler.second));
+	}
+	s_Samplers.clear();
+	Invalidate();
+	s_Stats = SamplerCacheStats();
+}
+
+SamplerCacheStats SamplerCache::GetStats()
+{
+	return s_Stats;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstddef>
+#include <unordered_map>
+
+enum class TextureFilter
+{
+	Nearest,
+	Linear,
+	// linear between the two closest mip levels, behaves like Linear on textures without mipmaps
+	Trilinear
+};
+
+enum class TextureWrap
+{
+	Clamp,
+	Repeat,
+	Mirror
+};
+
+struct SamplerState
+{
+	TextureFilter Filter = TextureFilter::Linear;
+	TextureWrap Wrap = TextureWrap::Clamp;
+	// 1 disables anisotropic filtering, higher values are clamped to what the driver supports
+	float MaxAnisotropy = 1.0f;
+
+	bool operator==(const SamplerState& other) const
+	{
+		return Filter == other.Filter && Wrap == other.Wrap && MaxAnisotropy == other.MaxAnisotropy;
+	}
+};
+
+struct SamplerCacheStats
+{
+	unsigned int Samplers;
+	unsigned int Binds;
+	// binds skipped because the slot already had that sampler
+	unsigned int RedundantBinds;
+};
+
+/**
+ * \brief Sampler objects shared by every texture. Each distinct SamplerState gets one GL sampler that is
+ * created on first use, and the sampler bound to each texture slot is tracked so binding the same state
+ * again is free. Sampling state lives here rather than in the textures, so one texture can be drawn with
+ * different filters or wraps and switching costs a single glBindSampler.
+ */
+class SamplerCache
+{
+public:
+	static const unsigned int MaxSlots = 32;
+
+	static unsigned int Get(const SamplerState& state);
+	static void Bind(unsigned int slot, const SamplerState& state);
+	// Back to the parameters stored in the bound texture
+	static void Unbind(unsigned int slot);
+	// Forgets the tracked bindings, for code that binds samplers itself
+	static void Invalidate();
+	// Deletes every sampler, has to run while the GL context is still alive
+	static void Clear();
+
+	static SamplerCacheStats GetStats();
+private:
+	struct StateHash
+	{
+		size_t operator()(const SamplerState& state) const;
+	};
+
+	static std::unordered_map<SamplerState, unsigned int, StateHash> s_Samplers;
+	static unsigned int s_BoundSamplers[MaxSlots];
+	static SamplerCacheStats s_Stats;
+};
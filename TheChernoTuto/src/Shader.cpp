@@ -1,8 +1,14 @@
 #include "Shader.h"
 #include "GL/glew.h"
+#include "AllocationTracker.h"
+#include "CookedAsset.h"
+#include "DeletionQueue.h"
+#include "Profiler.h"
 #include "Renderer.h"
 
+#include <cstring>
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <sstream>
 #include <fstream>
@@ -10,15 +16,53 @@
 Shader::Shader(const std::string& filepath)
 	:m_Filepath(filepath), m_RendererID(0)
 {
+    PROFILE_FUNCTION();
+    ALLOCATION_SCOPE(AllocationTag::Shader);
     // Parse the Basic.shader file and gives une back a struct containing the Vertex shader and Fragment shader
     ShaderProgramSources sources = ParseShader(filepath);
     // Create a program that compile and bind our vertex and fragment shader and then bind it to our state
     m_RendererID = CreateShader(sources.VertexSource, sources.FragmentSource);
+    m_Handle = ResourcePool::Create(ResourceType::Shader, m_RendererID);
+}
+
+Shader::Shader(const std::string& filepath, const ShaderProgramSources& sources)
+	:m_Filepath(filepath), m_RendererID(0)
+{
+    PROFILE_FUNCTION();
+    ALLOCATION_SCOPE(AllocationTag::Shader);
+    m_RendererID = CreateShader(sources.VertexSource, sources.FragmentSource);
+    m_Handle = ResourcePool::Create(ResourceType::Shader, m_RendererID);
 }
 
 Shader::~Shader()
 {
-    GlCall(glDeleteProgram(m_RendererID));
+    ResourcePool::Destroy(m_Handle);
+    DeletionQueue::DeleteProgram(m_RendererID);
+}
+
+Shader::Shader(Shader&& other) noexcept
+	:m_Filepath(std::move(other.m_Filepath)), m_RendererID(other.m_RendererID), m_Handle(other.m_Handle),
+	m_UniformLocationCache(std::move(other.m_UniformLocationCache))
+{
+    other.m_RendererID = 0;
+    other.m_Handle = ResourceHandle();
+}
+
+Shader& Shader::operator=(Shader&& other) noexcept
+{
+    if (this != &other)
+    {
+        ResourcePool::Destroy(m_Handle);
+        DeletionQueue::DeleteProgram(m_RendererID);
+        m_Filepath = std::move(other.m_Filepath);
+        m_RendererID = other.m_RendererID;
+        m_Handle = other.m_Handle;
+        m_UniformLocationCache = std::move(other.m_UniformLocationCache);
+        other.m_RendererID = 0;
+        other.m_Handle = ResourceHandle();
+        other.m_UniformLocationCache.clear();
+    }
+    return *this;
 }
 
 
@@ -32,38 +76,58 @@ void Shader::Unbind() const
     GlCall(glUseProgram(0));
 }
 
-void Shader::SetUniform1i(const std::string& name, int value)
+void Shader::SetUniform1i(const char* name, int value)
 {
     // Create a uniform vector4f to set the color from c++
     GlCall(glUniform1i(GetUniformLocation(name), value));
 }
 
-void Shader::SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3)
+void Shader::SetUniform1iv(const char* name, int count, const int* values)
+{
+    // Used to give every element of a sampler array its texture slot
+    GlCall(glUniform1iv(GetUniformLocation(name), count, values));
+}
+
+void Shader::SetUniform1f(const char* name, float value)
+{
+    GlCall(glUniform1f(GetUniformLocation(name), value));
+}
+
+void Shader::SetUniform2f(const char* name, float v0, float v1)
+{
+    GlCall(glUniform2f(GetUniformLocation(name), v0, v1));
+}
+
+void Shader::SetUniform4f(const char* name, float v0, float v1, float v2, float v3)
 {
     // Create a uniform vector4f to set the color from c++
     GlCall(glUniform4f(GetUniformLocation(name), v0, v1, v2, v3));
 }
 
-void Shader::SetUniformMat4f(const std::string& name, const glm::mat4& matrix)
+void Shader::SetUniformMat4f(const char* name, const glm::mat4& matrix)
 {
     // Create a uniform vector4f to set the color from c++
     GlCall(glUniformMatrix4fv(GetUniformLocation(name), 1, GL_FALSE, &matrix[0][0]));
 }
 
-unsigned int Shader::GetUniformLocation(const std::string& name)
+unsigned int Shader::GetUniformLocation(const char* name)
 {
-    if(m_UniformLocationCache.find(name) != m_UniformLocationCache.end())
+    for (const std::pair<std::string, int>& cached : m_UniformLocationCache)
     {
-        return m_UniformLocationCache[name];
+        if (cached.first == name)
+        {
+            return cached.second;
+        }
     }
 
-    GlCall(int location = glGetUniformLocation(m_RendererID, name.c_str()));
+    ALLOCATION_SCOPE(AllocationTag::Shader);
+    GlCall(int location = glGetUniformLocation(m_RendererID, name));
     if(location == -1)
     {
         std::cout << "Warning: Uniform '" << name << "' doesn't exist!\n";
     }
 
-    m_UniformLocationCache[name] = location;
+    m_UniformLocationCache.emplace_back(name, location);
     return location;
 }
 
@@ -75,6 +139,7 @@ unsigned int Shader::GetUniformLocation(const std::string& name)
  */
 unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
 {
+    PROFILE_FUNCTION();
     GlCall(unsigned int id = glCreateShader(type));
     const char* src = source.c_str();
 
@@ -110,6 +175,7 @@ unsigned int Shader::CompileShader(unsigned int type, const std::string& source)
  */
 unsigned int Shader::CreateShader(const std::string& vertexShader, const std::string& fragmentShader)
 {
+    PROFILE_FUNCTION();
     GlCall(unsigned int program = glCreateProgram());
     unsigned int vs = CompileShader(GL_VERTEX_SHADER, vertexShader);
     unsigned int fs = CompileShader(GL_FRAGMENT_SHADER, fragmentShader);
@@ -127,7 +193,24 @@ unsigned int Shader::CreateShader(const std::string& vertexShader, const std::st
 
 ShaderProgramSources Shader::ParseShader(const std::string& filepath)
 {
-    std::ifstream stream(filepath);
+    PROFILE_FUNCTION();
+    ALLOCATION_SCOPE(AllocationTag::Shader);
+    std::ifstream stream(filepath, std::ios::binary);
+    const std::string source((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    return ParseShader(source.data(), source.size());
+}
+
+ShaderProgramSources Shader::ParseShader(const char* source, size_t length)
+{
+    PROFILE_FUNCTION();
+    ALLOCATION_SCOPE(AllocationTag::Shader);
+    // cooked shaders are already split
+    if (const CookedShaderHeader* header = CookedAsset::GetShader((const unsigned char*)source, length))
+    {
+        const char* sources = (const char*)(header + 1);
+        return ShaderProgramSources{ std::string(sources, header->VertexSize),
+            std::string(sources + header->VertexSize, header->FragmentSize) };
+    }
 
     enum class ShaderType
     {
@@ -138,25 +221,39 @@ ShaderProgramSources Shader::ParseShader(const std::string& filepath)
 
     ShaderType type = ShaderType::NONE;
 
-    std::stringstream ss[2];
-    std::string line;
-    while (std::getline(stream, line))
+    std::string sources[2];
+    const char* end = source + length;
+    for (const char* line = source; line < end;)
     {
-        if (line.find("#shader") != std::string::npos)
+        const char* newline = (const char*)std::memchr(line, '\n', end - line);
+        const char* lineEnd = newline ? newline : end;
+        // the file is read in binary, CRLF files keep their \r otherwise
+        if (lineEnd > line && lineEnd[-1] == '\r')
+        {
+            --lineEnd;
+        }
+        const std::string text(line, lineEnd);
+        line = newline ? newline + 1 : end;
+
+        if (text.find("#shader") != std::string::npos)
         {
-            if (line.find("vertex") != std::string::npos)
+            if (text.find("vertex") != std::string::npos)
             {
                 type = ShaderType::VERTEX;
             }
-            else if (line.find("fragment") != std::string::npos)
+            else if (text.find("fragment") != std::string::npos)
             {
                 type = ShaderType::FRAGMENT;
             }
             continue;
         }
 
-        ss[(int)type] << line << "\n";
+        if (type != ShaderType::NONE)
+        {
+            sources[(int)type] += text;
+            sources[(int)type] += '\n';
+        }
     }
 
-    return ShaderProgramSources{ ss[0].str(), ss[1].str() };
+    return ShaderProgramSources{ sources[0], sources[1] };
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 #include "glm/glm.hpp"
+#include "ResourcePool.h"
 
 struct ShaderProgramSources
 {
@@ -14,25 +16,45 @@ class Shader
 private:
 	std::string m_Filepath;
 	unsigned int m_RendererID;
-	// caching uniforms
-	std::unordered_map<std::string, int> m_UniformLocationCache;
+	ResourceHandle m_Handle;
+	// caching uniforms, a shader has a handful so comparing names beats hashing a string built for every call
+	std::vector<std::pair<std::string, int>> m_UniformLocationCache;
 
 public:
 	Shader(const std::string& filepath);
+	// Compiles sources read ahead of time, filepath only names the shader
+	Shader(const std::string& filepath, const ShaderProgramSources& sources);
 	~Shader();
 
+	Shader(const Shader&) = delete;
+	Shader& operator=(const Shader&) = delete;
+	Shader(Shader&& other) noexcept;
+	Shader& operator=(Shader&& other) noexcept;
+
 	void Bind() const;
 	void Unbind() const;
 
+	inline ResourceHandle GetHandle() const
+	{
+		return m_Handle;
+	}
+
 	// Set uniform
-	void SetUniform1i(const std::string& name, int value);
-	void SetUniform4f(const std::string& name, float v0, float v1, float v2, float v3);
-	void SetUniformMat4f(const std::string& name, const glm::mat4& matrix);
+	void SetUniform1i(const char* name, int value);
+	void SetUniform1iv(const char* name, int count, const int* values);
+	void SetUniform1f(const char* name, float value);
+	void SetUniform2f(const char* name, float v0, float v1);
+	void SetUniform4f(const char* name, float v0, float v1, float v2, float v3);
+	void SetUniformMat4f(const char* name, const glm::mat4& matrix);
+
+	// Splits a .shader file at its #shader lines, touches no GL state so it can run on any thread
+	static ShaderProgramSources ParseShader(const std::string& filepath);
+	// Same from a file already in memory, source or cooked, lines before the first #shader are ignored
+	static ShaderProgramSources ParseShader(const char* source, size_t length);
 
 private:
 	bool CompileShader();
-	unsigned int GetUniformLocation(const std::string& name);
+	unsigned int GetUniformLocation(const char* name);
 	unsigned int CompileShader(unsigned int type, const std::string& source);
 	unsigned int CreateShader(const std::string& vertexShader, const std::string& fragmentShader);
-	ShaderProgramSources ParseShader(const std::string& filepath);
 };
@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+/**
+ * \brief Bounded single producer, single consumer ring. Only the producer moves the tail and only the consumer
+ * moves the head, so a push or a pop is one acquire load and one release store, no lock and no compare and
+ * swap. The two indices live on their own cache lines so both sides don't fight over the same line.
+ */
+template<typename T, size_t Capacity>
+class SpscQueue
+{
+	static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity has to be a power of two");
+public:
+	SpscQueue()
+		:m_Head(0), m_Tail(0)
+	{
+	}
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	// Producer only, false when the queue is full
+	bool TryPush(T value)
+	{
+		const size_t tail = m_Tail.load(std::memory_order_relaxed);
+		if (tail - m_Head.load(std::memory_order_acquire) == Capacity)
+		{
+			return false;
+		}
+		m_Items[tail & (Capacity - 1)] = std::move(value);
+		m_Tail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	// Consumer only, false when the queue is empty
+	bool TryPop(T& value)
+	{
+		const size_t head = m_Head.load(std::memory_order_relaxed);
+		if (m_Tail.load(std::memory_order_acquire) == head)
+		{
+			return false;
+		}
+		value = std::move(m_Items[head & (Capacity - 1)]);
+		m_Head.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	inline bool IsEmpty() const
+	{
+		return m_Head.load(std::memory_order_acquire) == m_Tail.load(std::memory_order_acquire);
+	}
+private:
+	alignas(64) std::atomic<size_t> m_Head;
+	alignas(64) std::atomic<size_t> m_Tail;
+	T m_Items[Capacity];
+};
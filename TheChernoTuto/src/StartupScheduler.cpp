@@ -0,0 +1,127 @@
+#include "StartupScheduler.h"
+
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <iostream>
+
+StartupScheduler::StartupScheduler()
+	:m_Start(std::chrono::steady_clock::now()), m_NextLane(1), m_OpenPhase((size_t)-1), m_FirstFrame(0.0)
+{
+}
+
+StartupScheduler::PhaseScope::PhaseScope(StartupScheduler& scheduler, size_t phase)
+	:m_Scheduler(scheduler), m_Phase(phase)
+{
+	const double now = m_Scheduler.GetMilliseconds();
+	std::lock_guard<std::mutex> lock(m_Scheduler.m_Mutex);
+	m_Scheduler.m_Phases[m_Phase].Start = now;
+}
+
+StartupScheduler::PhaseScope::~PhaseScope()
+{
+	const double now = m_Scheduler.GetMilliseconds();
+	std::lock_guard<std::mutex> lock(m_Scheduler.m_Mutex);
+	m_Scheduler.m_Phases[m_Phase].End = now;
+}
+
+size_t StartupScheduler::AddPhase(const std::string& name, unsigned int lane)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	// not started yet, the task may still be waiting for a thread
+	m_Phases.push_back({ name, lane, GetMilliseconds(), -1.0 });
+	return m_Phases.size() - 1;
+}
+
+double StartupScheduler::GetMilliseconds() const
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_Start).count();
+}
+
+void StartupScheduler::Begin(const std::string& name)
+{
+	End();
+	m_OpenPhase = AddPhase(name, 0);
+}
+
+void StartupScheduler::End()
+{
+	if (m_OpenPhase == (size_t)-1)
+	{
+		return;
+	}
+	const double now = GetMilliseconds();
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Phases[m_OpenPhase].End = now;
+	m_OpenPhase = (size_t)-1;
+}
+
+void StartupScheduler::MarkFirstFrame()
+{
+	End();
+	if (m_FirstFrame == 0.0)
+	{
+		m_FirstFrame = GetMilliseconds();
+	}
+}
+
+std::vector<StartupPhase> StartupScheduler::GetPhases() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Phases;
+}
+
+void StartupScheduler::Print() const
+{
+	for (const StartupPhase& phase : GetPhases())
+	{
+		std::cout << (phase.Lane == 0 ? "main   " : "worker ") << phase.Start << " ms +"
+			<< std::max(phase.End - phase.Start, 0.0) << " ms " << phase.Name << std::endl;
+	}
+	std::cout << "First frame after " << m_FirstFrame << " ms" << std::endl;
+}
+
+void StartupScheduler::OnImGuiRender() const
+{
+	const std::vector<StartupPhase> phases = GetPhases();
+	double total = m_FirstFrame;
+	unsigned int lanes = 1;
+	for (const StartupPhase& phase : phases)
+	{
+		total = std::max(total, phase.End);
+		lanes = std::max(lanes, phase.Lane + 1);
+	}
+	ImGui::Text("First frame after %.1f ms", m_FirstFrame);
+	if (total <= 0.0)
+	{
+		return;
+	}
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 100.0f);
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::InvisibleButton("Timeline", ImVec2(width, rowHeight * lanes));
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	const ImVec2 mouse = ImGui::GetMousePos();
+	const bool hovered = ImGui::IsItemHovered();
+
+	for (const StartupPhase& phase : phases)
+	{
+		// still running phases are drawn up to now
+		const double end = phase.End < phase.Start ? total : phase.End;
+		const ImVec2 min(origin.x + (float)(phase.Start / total) * width, origin.y + phase.Lane * rowHeight);
+		const ImVec2 max(std::max(origin.x + (float)(end / total) * width, min.x + 1.0f), min.y + rowHeight - 2.0f);
+		const bool waiting = phase.Lane == 0 && phase.Name.compare(0, 9, "Wait for ") == 0;
+		drawList->AddRectFilled(min, max, waiting ? IM_COL32(200, 80, 60, 255)
+			: phase.Lane == 0 ? IM_COL32(70, 130, 200, 255) : IM_COL32(80, 170, 90, 255));
+		drawList->PushClipRect(min, max, true);
+		drawList->AddText(ImVec2(min.x + 2.0f, min.y), IM_COL32_WHITE, phase.Name.c_str());
+		drawList->PopClipRect();
+		if (hovered && mouse.x >= min.x && mouse.x < max.x && mouse.y >= min.y && mouse.y < max.y)
+		{
+			ImGui::SetTooltip("%s\n%.2f ms at %.2f ms", phase.Name.c_str(), end - phase.Start, phase.Start);
+		}
+	}
+	const float firstFrame = origin.x + (float)(m_FirstFrame / total) * width;
+	drawList->AddLine(ImVec2(firstFrame, origin.y), ImVec2(firstFrame, origin.y + rowHeight * lanes), IM_COL32_WHITE);
+}
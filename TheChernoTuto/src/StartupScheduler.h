@@ -0,0 +1,88 @@
+#pragma once
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct StartupPhase
+{
+	std::string Name;
+	// 0 for the main thread, every task runs on a lane of its own
+	unsigned int Lane;
+	// milliseconds since the scheduler was created, End stays below Start while the phase runs
+	double Start;
+	double End;
+};
+
+/**
+ * \brief Overlaps the CPU only part of startup (reading files, decoding images, splitting shaders, rasterizing
+ * fonts) with the work that has to stay on the main thread (GLFW, the window and its context, GLEW, uploads).
+ * Run starts a task on a worker thread right away and Wait collects its result where the main thread first
+ * needs it. Every task, every Begin / End section and every wait is recorded, so the timeline shows what the
+ * main thread still spends waiting and how long the first frame took to come up.
+ */
+class StartupScheduler
+{
+public:
+	StartupScheduler();
+
+	template<typename F>
+	auto Run(const std::string& name, F task) -> std::future<decltype(task())>
+	{
+		const size_t phase = AddPhase(name, m_NextLane++);
+		return std::async(std::launch::async, [this, phase, task = std::move(task)]() mutable
+		{
+			const PhaseScope scope(*this, phase);
+			return task();
+		});
+	}
+
+	// Waiting is a main thread phase of its own, named after the task
+	template<typename T>
+	T Wait(const std::string& name, std::future<T>& result)
+	{
+		const PhaseScope scope(*this, AddPhase("Wait for " + name, 0));
+		return result.get();
+	}
+
+	// Main thread sections, they don't nest
+	void Begin(const std::string& name);
+	void End();
+
+	// After the first frame was presented, startup is over from then on
+	void MarkFirstFrame();
+
+	inline double GetFirstFrameMilliseconds() const
+	{
+		return m_FirstFrame;
+	}
+
+	std::vector<StartupPhase> GetPhases() const;
+	// One line per phase on stdout
+	void Print() const;
+	// Timeline with a row per lane, meant to sit inside an open ImGui window
+	void OnImGuiRender() const;
+private:
+	// Stamps the phase's start when built and its end when destroyed
+	class PhaseScope
+	{
+	public:
+		PhaseScope(StartupScheduler& scheduler, size_t phase);
+		~PhaseScope();
+	private:
+		StartupScheduler& m_Scheduler;
+		size_t m_Phase;
+	};
+
+	size_t AddPhase(const std::string& name, unsigned int lane);
+	double GetMilliseconds() const;
+
+	std::chrono::steady_clock::time_point m_Start;
+	// tasks stamp their phases from their own threads
+	mutable std::mutex m_Mutex;
+	std::vector<StartupPhase> m_Phases;
+	unsigned int m_NextLane;
+	size_t m_OpenPhase;
+	double m_FirstFrame;
+};
@@ -1,45 +1,476 @@
 #include "Texture.h"
 
+#include "AllocationTracker.h"
+#include "CookedAsset.h"
+#include "DecodedImage.h"
+#include "DeletionQueue.h"
+#include "MappedFile.h"
+#include "Profiler.h"
 #include "Renderer.h"
-#include "stb_image/stb_image.h"
+#include "TextureResidency.h"
 
-Texture::Texture(const std::string& filepath)
-	:m_RendererID(0), m_Filepath(filepath), m_LocalBuffer(nullptr), m_Width(0), m_Height(0), m_BPP(0)
+#include <algorithm>
+
+TextureFormat SelectTextureFormat(int channels, unsigned int type, TextureUsage usage)
 {
-	stbi_set_flip_vertically_on_load(1);
+	static const unsigned int pixelFormats[4] = { GL_RED, GL_RG, GL_RGB, GL_RGBA };
+	static const unsigned int unorm8[4] = { GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+	static const unsigned int unorm16[4] = { GL_R16, GL_RG16, GL_RGB16, GL_RGBA16 };
+	static const unsigned int half[4] = { GL_R16F, GL_RG16F, GL_RGB16F, GL_RGBA16F };
 
-	m_LocalBuffer = stbi_load(filepath.c_str(), &m_Width, &m_Height, &m_BPP, 4);
+	const int index = channels - 1;
+	TextureFormat format = { unorm8[index], pixelFormats[index], { GL_RED, GL_GREEN, GL_BLUE, GL_ALPHA } };
+	if (type == GL_UNSIGNED_SHORT)
+	{
+		format.InternalFormat = unorm16[index];
+	}
+	else if (type == GL_FLOAT)
+	{
+		format.InternalFormat = half[index];
+	}
+	else if (usage == TextureUsage::Color && channels >= 3)
+	{
+		// core has no single/dual channel sRGB formats, gray images stay linear
+		format.InternalFormat = channels == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+	}
 
-	GlCall(glGenTextures(1, &m_RendererID));
-	GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	// gray and gray + alpha images expand to (L, L, L, 1) and (L, L, L, A) at sampling time
+	if (channels == 1)
+	{
+		format.Swizzle[1] = GL_RED;
+		format.Swizzle[2] = GL_RED;
+		format.Swizzle[3] = GL_ONE;
+	}
+	else if (channels == 2)
+	{
+		format.Swizzle[1] = GL_RED;
+		format.Swizzle[2] = GL_RED;
+		format.Swizzle[3] = GL_GREEN;
+	}
+	return format;
+}
+
+namespace
+{
+	// Level 0 of a cooked texture, Data points into buffer
+	bool ReadCooked(const unsigned char* buffer, size_t length, TextureFileData& data)
+	{
+		const CookedTextureHeader* header = CookedAsset::GetTexture(buffer, length);
+		if (!header)
+		{
+			return false;
+		}
+		const CookedTextureLevel& level = CookedAsset::GetTextureLevels(header)[0];
+		data.Width = (int)header->Width;
+		data.Height = (int)header->Height;
+		data.Channels = (int)header->Channels;
+		data.Type = header->Type;
+		data.Compression = (TextureCompression)header->Compression;
+		data.Data = buffer + level.Offset;
+		data.Size = (size_t)level.Size;
+		data.AverageTexel.assign(header->AverageTexel,
+			header->AverageTexel + data.Channels * DecodedImage::GetComponentSize(data.Type));
+		return true;
+	}
 
-	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
-	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
-	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
-	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+	// Compresses the decoded pixels when asked to, the result keeps the image or the blocks alive
+	TextureFileData PrepareFileData(const std::shared_ptr<DecodedImage>& image, TextureCompression compression)
+	{
+		TextureFileData data;
+		data.Type = GL_UNSIGNED_BYTE;
 
-	GlCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, m_Width, m_Height, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_LocalBuffer));
-	Unbind();
+		if (!image->Pixels)
+		{
+			data.Channels = 4;
+			return data;
+		}
+
+		data.Width = image->Width;
+		data.Height = image->Height;
+		data.Channels = image->Channels;
+		data.Type = image->Type;
+		data.AverageTexel = DecodedImage::ComputeAverage(image->Pixels, data.Width, data.Height, data.Channels, data.Type);
+
+		// the encoder works on 8 bit data only, 16 bit and HDR images are uploaded uncompressed
+		if (data.Type == GL_UNSIGNED_BYTE && compression != TextureCompression::None
+			&& TextureCompressor::IsSupported(compression))
+		{
+			std::shared_ptr<std::vector<unsigned char>> blocks = std::make_shared<std::vector<unsigned char>>(
+				TextureCompressor::CompressPixels(image->Pixels, data.Width, data.Height, data.Channels, compression));
+			data.Compression = compression;
+			data.Data = blocks->data();
+			data.Size = blocks->size();
+			data.Storage = blocks;
+		}
+		else
+		{
+			data.Data = image->Pixels;
+			data.Storage = image;
+		}
+		return data;
+	}
+}
 
-	if(m_LocalBuffer)
+Texture::Texture(const std::string& filepath, TextureCompression compression, TextureUsage usage)
+	:Texture(LoadFile(filepath, compression), usage)
+{
+}
+
+Texture::Texture(const TextureFileData& data, TextureUsage usage)
+	:m_RendererID(0), m_Filepath(data.Filepath), m_Width(data.Width), m_Height(data.Height), m_BPP(data.Channels),
+	m_Type(data.Type), m_InternalFormat(GL_RGBA8), m_Compression(data.Compression), m_Usage(usage), m_LevelCount(1),
+	m_ResidentLevel(0), m_ResidentWidth(0), m_ResidentHeight(0), m_ResidentBytes(0), m_AverageTexel(data.AverageTexel),
+	m_LastUsedFrame(0)
+{
+	while (DecodedImage::GetLevelDimension(m_Width, m_LevelCount - 1) > 1
+		|| DecodedImage::GetLevelDimension(m_Height, m_LevelCount - 1) > 1)
 	{
-		stbi_image_free(m_LocalBuffer);
+		++m_LevelCount;
 	}
+	Upload(data.Data, data.Size, m_Width, m_Height, m_Compression != TextureCompression::None);
+	TextureResidency::Register(*this);
+}
+
+TextureFileData Texture::LoadFile(const std::string& filepath, TextureCompression compression)
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Texture);
+	// cooked textures are uploaded straight from the mapping, source images are decoded from it
+	std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+	file->Open(filepath);
+	TextureFileData data;
+	if (!ReadCooked(file->GetData(), file->GetSize(), data))
+	{
+		data = PrepareFileData(std::make_shared<DecodedImage>(file->GetData(), file->GetSize()), compression);
+	}
+	else
+	{
+		data.Storage = file;
+	}
+	data.Filepath = filepath;
+	return data;
+}
+
+TextureFileData Texture::LoadMemory(const unsigned char* buffer, size_t length, TextureCompression compression)
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Texture);
+	TextureFileData data;
+	if (!ReadCooked(buffer, length, data))
+	{
+		return PrepareFileData(std::make_shared<DecodedImage>(buffer, length), compression);
+	}
+	std::shared_ptr<std::vector<unsigned char>> copy = std::make_shared<std::vector<unsigned char>>(data.Data,
+		data.Data + data.Size);
+	data.Data = copy->data();
+	data.Storage = copy;
+	return data;
+}
+
+Texture::Texture(int width, int height, const unsigned char* pixels, int channels, TextureUsage usage)
+	:m_RendererID(0), m_Width(width), m_Height(height), m_BPP(channels), m_Type(GL_UNSIGNED_BYTE),
+	m_InternalFormat(GL_RGBA8), m_Compression(TextureCompression::None), m_Usage(usage), m_LevelCount(1),
+	m_ResidentLevel(0), m_ResidentWidth(0), m_ResidentHeight(0), m_ResidentBytes(0), m_LastUsedFrame(0)
+{
+	Upload(pixels, 0, width, height, false);
+	TextureResidency::Register(*this);
 }
 
 Texture::~Texture()
 {
-	GlCall(glDeleteTextures(1, &m_RendererID));
+	TextureResidency::Unregister(*this);
+	Release();
+}
+
+Texture::Texture(Texture&& other) noexcept
+	:m_RendererID(0)
+{
+	*this = std::move(other);
+}
+
+Texture& Texture::operator=(Texture&& other) noexcept
+{
+	if (this == &other)
+	{
+		return *this;
+	}
+
+	// loads still on their way to either texture would land on the wrong image, drop them with the registrations
+	TextureResidency::Unregister(*this);
+	TextureResidency::Unregister(other);
+	Release();
+
+	m_RendererID = other.m_RendererID;
+	m_Handle = other.m_Handle;
+	m_Filepath = std::move(other.m_Filepath);
+	m_Width = other.m_Width;
+	m_Height = other.m_Height;
+	m_BPP = other.m_BPP;
+	m_Type = other.m_Type;
+	m_InternalFormat = other.m_InternalFormat;
+	m_Compression = other.m_Compression;
+	m_Usage = other.m_Usage;
+	m_SamplerState = other.m_SamplerState;
+	m_LevelCount = other.m_LevelCount;
+	m_ResidentLevel = other.m_ResidentLevel;
+	m_ResidentWidth = other.m_ResidentWidth;
+	m_ResidentHeight = other.m_ResidentHeight;
+	m_ResidentBytes = other.m_ResidentBytes;
+	m_AverageTexel = std::move(other.m_AverageTexel);
+	m_LastUsedFrame = other.m_LastUsedFrame;
+
+	// the moved from texture is empty and stays out of the residency list until something is moved into it
+	other.m_RendererID = 0;
+	other.m_Handle = ResourceHandle();
+	other.m_Filepath.clear();
+	other.m_AverageTexel.clear();
+	other.m_ResidentBytes = 0;
+	TextureResidency::Register(*this);
+	return *this;
+}
+
+void Texture::Release()
+{
+	if (m_RendererID == 0)
+	{
+		return;
+	}
+	ResourcePool::Destroy(m_Handle);
+	m_Handle = ResourceHandle();
+	// compressed storage isn't handed out again, AcquireTexture only serves uncompressed uploads
+	const bool reusable = m_ResidentWidth > 0
+		&& m_InternalFormat == SelectTextureFormat(m_BPP, m_Type, m_Usage).InternalFormat;
+	DeletionQueue::DeleteTexture(m_RendererID, m_ResidentWidth, m_ResidentHeight, reusable ? m_InternalFormat : 0);
+	m_RendererID = 0;
+}
+
+void Texture::Upload(const unsigned char* data, size_t size, int width, int height, bool compressed)
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Texture);
+	TextureFormat format = SelectTextureFormat(m_BPP, m_Type, m_Usage);
+
+	// a released texture with the same storage only needs its pixels replaced
+	bool recycled = false;
+	if (m_RendererID == 0 && !compressed)
+	{
+		m_RendererID = DeletionQueue::AcquireTexture(width, height, format.InternalFormat);
+		recycled = m_RendererID != 0;
+	}
+
+	// later uploads replace the storage of the same texture, so ids held elsewhere stay valid
+	if (recycled)
+	{
+		GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+		m_Handle = ResourcePool::Create(ResourceType::Texture, m_RendererID);
+	}
+	else if (m_RendererID == 0)
+	{
+		GlCall(glGenTextures(1, &m_RendererID));
+		GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+		m_Handle = ResourcePool::Create(ResourceType::Texture, m_RendererID);
+
+		// filtering and wrapping come from SamplerCache when bound, these only keep the texture complete for
+		// code sampling it without a sampler (ImGui binds sampler 0): a single level and no mip filter
+		GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+		GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	}
+	else
+	{
+		GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	}
+
+	if (compressed)
+	{
+		const bool srgb = m_Usage == TextureUsage::Color && GLEW_EXT_texture_sRGB;
+		m_InternalFormat = TextureCompressor::GetGLInternalFormat(m_Compression, srgb);
+
+		// BC4 and BC5 only carry R / RG, rebuild gray and gray + alpha from them
+		if (m_Compression == TextureCompression::BC4 && m_BPP <= 2)
+		{
+			format = SelectTextureFormat(1, m_Type, m_Usage);
+		}
+		else if (m_Compression == TextureCompression::BC5 && m_BPP == 2)
+		{
+			format = SelectTextureFormat(2, m_Type, m_Usage);
+		}
+		else
+		{
+			format = SelectTextureFormat(4, m_Type, m_Usage);
+		}
+
+		GlCall(glCompressedTexImage2D(GL_TEXTURE_2D, 0, m_InternalFormat, width, height, 0, (GLsizei)size, data));
+		m_ResidentBytes = size;
+	}
+	else
+	{
+		m_InternalFormat = format.InternalFormat;
+
+		// rows of R8/RG8/RGB8 images aren't 4 byte aligned
+		GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+		if (recycled)
+		{
+			if (data)
+			{
+				GlCall(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format.Format, m_Type, data));
+			}
+		}
+		else
+		{
+			GlCall(glTexImage2D(GL_TEXTURE_2D, 0, m_InternalFormat, width, height, 0, format.Format, m_Type, data));
+		}
+		GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+		// half floats on the GPU, whatever the source depth
+		const size_t componentSize = m_Type == GL_FLOAT ? 2 : DecodedImage::GetComponentSize(m_Type);
+		m_ResidentBytes = (size_t)width * height * m_BPP * componentSize;
+	}
+	GlCall(glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, format.Swizzle));
+	Unbind();
+
+	m_ResidentWidth = width;
+	m_ResidentHeight = height;
+	ResourcePool::SetSizeInBytes(m_Handle, m_ResidentBytes);
+}
+
+size_t Texture::GetLevelSizeInBytes(int level) const
+{
+	const int width = DecodedImage::GetLevelDimension(m_Width, level);
+	const int height = DecodedImage::GetLevelDimension(m_Height, level);
+	if (m_Compression != TextureCompression::None)
+	{
+		return TextureCompressor::GetCompressedSize(m_Compression, width, height);
+	}
+	const size_t componentSize = m_Type == GL_FLOAT ? 2 : DecodedImage::GetComponentSize(m_Type);
+	return (size_t)width * height * m_BPP * componentSize;
+}
+
+std::function<TextureLevelData()> Texture::CreateLevelLoader(int level) const
+{
+	const std::string filepath = m_Filepath;
+	const int width = m_Width, height = m_Height, channels = m_BPP;
+	const unsigned int type = m_Type;
+	const TextureCompression compression = m_Compression;
+	return [=]()
+	{
+		TextureLevelData data;
+		MappedFile file;
+		file.Open(filepath);
+		// cooked files have every level ready, a copy out of the mapping is all there is to do
+		if (const CookedTextureHeader* header = CookedAsset::GetTexture(file.GetData(), file.GetSize()))
+		{
+			if ((int)header->Width != width || (int)header->Height != height || (int)header->Channels != channels
+				|| header->Type != type || (TextureCompression)header->Compression != compression
+				|| (uint32_t)level >= header->LevelCount)
+			{
+				return data;
+			}
+			const CookedTextureLevel& cooked = CookedAsset::GetTextureLevels(header)[level];
+			data.Level = level;
+			data.Width = (int)cooked.Width;
+			data.Height = (int)cooked.Height;
+			data.Compressed = compression != TextureCompression::None;
+			data.Data.assign(file.GetData() + cooked.Offset, file.GetData() + cooked.Offset + cooked.Size);
+			return data;
+		}
+
+		DecodedImage image(file.GetData(), file.GetSize());
+		// the file changed on disk since the texture was created, keep what is resident
+		if (!image.Pixels || image.Width != width || image.Height != height || image.Channels != channels
+			|| image.Type != type)
+		{
+			return data;
+		}
+
+		data.Level = level;
+		data.Width = width;
+		data.Height = height;
+		std::vector<unsigned char> pixels;
+		const unsigned char* current = image.Pixels;
+		for (int i = 0; i < level; ++i)
+		{
+			pixels = DecodedImage::Halve(current, data.Width, data.Height, channels, type);
+			current = pixels.data();
+			data.Width = DecodedImage::GetLevelDimension(data.Width, 1);
+			data.Height = DecodedImage::GetLevelDimension(data.Height, 1);
+		}
+
+		if (compression != TextureCompression::None)
+		{
+			data.Compressed = true;
+			data.Data = TextureCompressor::CompressPixels(current, data.Width, data.Height, channels, compression);
+		}
+		else if (level == 0)
+		{
+			data.Data.assign(current, current + (size_t)width * height * channels * DecodedImage::GetComponentSize(type));
+		}
+		else
+		{
+			data.Data = std::move(pixels);
+		}
+		return data;
+	};
+}
+
+bool Texture::UploadLevel(const TextureLevelData& data)
+{
+	if (data.Data.empty() || data.Level < 0 || data.Level >= m_LevelCount
+		|| data.Width != DecodedImage::GetLevelDimension(m_Width, data.Level)
+		|| data.Height != DecodedImage::GetLevelDimension(m_Height, data.Level)
+		|| data.Compressed != (m_Compression != TextureCompression::None))
+	{
+		return false;
+	}
+	Upload(data.Data.data(), data.Data.size(), data.Width, data.Height, data.Compressed);
+	m_ResidentLevel = data.Level;
+	return true;
+}
+
+void Texture::Drop()
+{
+	if (!IsStreamable())
+	{
+		return;
+	}
+	// stored uncompressed, a single block would be no smaller
+	Upload(m_AverageTexel.data(), 0, 1, 1, false);
+	m_ResidentLevel = m_LevelCount - 1;
+}
+
+void Texture::Update(int x, int y, int width, int height, const void* pixels, int rowLength)
+{
+	ASSERT(m_Compression == TextureCompression::None && m_ResidentLevel == 0);
+	ASSERT(x >= 0 && y >= 0 && x + width <= m_ResidentWidth && y + height <= m_ResidentHeight);
+
+	const TextureFormat format = SelectTextureFormat(m_BPP, m_Type, m_Usage);
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	GlCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, rowLength));
+	GlCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, format.Format, m_Type, pixels));
+	GlCall(glPixelStorei(GL_UNPACK_ROW_LENGTH, 0));
+	GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	Unbind();
+}
+
+void Texture::Touch() const
+{
+	m_LastUsedFrame = TextureResidency::GetFrame();
 }
 
 void Texture::Bind(unsigned int slot) const
 {
+	Bind(slot, m_SamplerState);
+}
+
+void Texture::Bind(unsigned int slot, const SamplerState& samplerState) const
+{
+	Touch();
 	GlCall(glActiveTexture(GL_TEXTURE0 + slot));
 	GlCall(glBindTexture(GL_TEXTURE_2D, m_RendererID));
+	SamplerCache::Bind(slot, samplerState);
 }
 
 void Texture::Unbind() const
 {
 	GlCall(glBindTexture(GL_TEXTURE_2D, 0))
 
-}
\ No newline at end of file
+}
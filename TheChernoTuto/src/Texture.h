@@ -1,21 +1,114 @@
 #pragma once
+#include <functional>
+#include <memory>
 #include <string>
+#include <vector>
+#include "ResourcePool.h"
+#include "SamplerCache.h"
+#include "TextureCompressor.h"
+
+enum class TextureUsage
+{
+	Data,	// sampled exactly as stored: masks, normal maps, lookup tables
+	Color	// sRGB encoded colors, the sampler converts them to linear
+};
+
+struct TextureFormat
+{
+	unsigned int InternalFormat;
+	unsigned int Format;
+	int Swizzle[4];
+};
+
+// Channel count and component type of the source decide the storage, usage only picks sRGB for 8 bit colors
+TextureFormat SelectTextureFormat(int channels, unsigned int type, TextureUsage usage);
+
+// One mip level decoded off the main thread, Data holds blocks when Compressed and source pixels otherwise
+struct TextureLevelData
+{
+	int Level = 0;
+	int Width = 0, Height = 0;
+	bool Compressed = false;
+	std::vector<unsigned char> Data;
+};
+
+/**
+ * \brief Everything the file constructor prepares before touching GL, so decoding and block encoding can run on
+ * a worker thread and only the upload has to happen where the context is current.
+ */
+struct TextureFileData
+{
+	std::string Filepath;
+	// 0 x 0 when the file couldn't be read
+	int Width = 0, Height = 0, Channels = 0;
+	unsigned int Type = 0;
+	// what Data holds, None for pixels in the source format
+	TextureCompression Compression = TextureCompression::None;
+	const unsigned char* Data = nullptr;
+	size_t Size = 0;
+	std::vector<unsigned char> AverageTexel;
+	// keeps Data alive
+	std::shared_ptr<void> Storage;
+};
 
 class Texture
 {
 private:
 	unsigned int m_RendererID;
+	ResourceHandle m_Handle;
 	std::string	 m_Filepath;
-	unsigned char* m_LocalBuffer;
 	int m_Width, m_Height, m_BPP;
+	unsigned int m_Type;
+	unsigned int m_InternalFormat;
+	TextureCompression m_Compression;
+	TextureUsage m_Usage;
+	SamplerState m_SamplerState;
+	// what the GPU currently holds, level 0 unless TextureResidency dropped or downgraded the texture
+	int m_LevelCount;
+	int m_ResidentLevel;
+	int m_ResidentWidth, m_ResidentHeight;
+	size_t m_ResidentBytes;
+	// one texel in the source format, what a dropped texture shows until it is streamed back
+	std::vector<unsigned char> m_AverageTexel;
+	mutable unsigned long long m_LastUsedFrame;
 public:
-	Texture(const std::string& filepath);
+	/**
+	 * \brief Loads a QOI file or anything stb_image reads, keeping its own channel count and bit depth:
+	 * 8 bit images map to GL_R8/GL_RG8/GL_RGB8/GL_RGBA8 (sRGB for Color), 16 bit ones to GL_R16..GL_RGBA16
+	 * and HDR files are read as floats into GL_R16F..GL_RGBA16F. One and two channel images are swizzled to
+	 * (L, L, L, 1) and (L, L, L, A) so shaders sampling .rgba keep working.
+	 * \param compression opt-in, 8 bit images are block encoded on load when the driver supports the format
+	 */
+	Texture(const std::string& filepath, TextureCompression compression = TextureCompression::None,
+		TextureUsage usage = TextureUsage::Data);
+	// Uploads a file decoded ahead of time by LoadFile
+	Texture(const TextureFileData& data, TextureUsage usage = TextureUsage::Data);
+	// Creates the texture from 8 bit pixels already in memory, rows bottom up like the loaded images
+	Texture(int width, int height, const unsigned char* pixels, int channels = 4, TextureUsage usage = TextureUsage::Data);
 	~Texture();
 
+	// moving also hands over its place in TextureResidency
+	Texture(const Texture&) = delete;
+	Texture& operator=(const Texture&) = delete;
+	Texture(Texture&& other) noexcept;
+	Texture& operator=(Texture&& other) noexcept;
+
+	// Binds the texture with its own sampler state, or with any other one without touching the texture
 	void Bind(unsigned int slot = 0) const;
+	void Bind(unsigned int slot, const SamplerState& samplerState) const;
 	void Unbind() const;
 
+	inline void SetSamplerState(const SamplerState& samplerState)
+	{
+		m_SamplerState = samplerState;
+	}
+
+	inline const SamplerState& GetSamplerState() const
+	{
+		return m_SamplerState;
+	}
 
+	// Size of the full image even while a smaller level is resident
 	inline int GetWidth() const
 	{
 		return m_Width;
@@ -25,5 +118,106 @@ public:
 	{
 		return m_Height;
 	}
-};
 
+	inline int GetChannels() const
+	{
+		return m_BPP;
+	}
+
+	inline unsigned int GetInternalFormat() const
+	{
+		return m_InternalFormat;
+	}
+
+	inline TextureCompression GetCompression() const
+	{
+		return m_Compression;
+	}
+
+	inline unsigned int GetRendererID() const
+	{
+		return m_RendererID;
+	}
+
+	inline ResourceHandle GetHandle() const
+	{
+		return m_Handle;
+	}
+
+	inline const std::string& GetFilepath() const
+	{
+		return m_Filepath;
+	}
+
+	/**
+	 * \brief Overwrites a region of the resident level with pixels in the texture's own channel count and depth.
+	 * Only for uncompressed textures at full size, textures created from memory are never evicted.
+	 * \param rowLength pixels between the start of two source rows, 0 when the rows are tightly packed
+	 * \param pixels read from the bound GL_PIXEL_UNPACK_BUFFER as an offset when one is bound
+	 */
+	void Update(int x, int y, int width, int height, const void* pixels, int rowLength = 0);
+
+	// The decoding half of the file constructor, thread safe once GLEW is initialized. Cooked files (CookedAsset)
+	// are used as they are, with the compression they were cooked with
+	static TextureFileData LoadFile(const std::string& filepath, TextureCompression compression = TextureCompression::None);
+	// Same from an encoded file already in memory (a pack entry), the buffer is only read during the call. The
+	// result has no Filepath, so the texture can't be streamed back in and is never evicted
+	static TextureFileData LoadMemory(const unsigned char* buffer, size_t length,
+		TextureCompression compression = TextureCompression::None);
+
+	// Marks the texture as drawn this frame, Bind does it already, only needed when using GetRendererID directly
+	void Touch() const;
+
+	inline unsigned long long GetLastUsedFrame() const
+	{
+		return m_LastUsedFrame;
+	}
+
+	// Only textures loaded from a file can be dropped and read back later
+	inline bool IsStreamable() const
+	{
+		return !m_Filepath.empty() && !m_AverageTexel.empty();
+	}
+
+	// Mip chain length of the full size image, the GL texture itself only ever holds one level
+	inline int GetLevelCount() const
+	{
+		return m_LevelCount;
+	}
+
+	inline int GetResidentLevel() const
+	{
+		return m_ResidentLevel;
+	}
+
+	inline int GetResidentWidth() const
+	{
+		return m_ResidentWidth;
+	}
+
+	inline int GetResidentHeight() const
+	{
+		return m_ResidentHeight;
+	}
+
+	// Video memory held right now, and what the texture would hold at another level
+	inline size_t GetSizeInBytes() const
+	{
+		return m_ResidentBytes;
+	}
+	size_t GetLevelSizeInBytes(int level) const;
+
+	/**
+	 * \brief Returns a job that decodes the file again and box filters it down to the given level, block
+	 * encoding it too when the texture is compressed. The job only works on copies and can run on any thread,
+	 * its result goes back to UploadLevel on the thread owning the context.
+	 */
+	std::function<TextureLevelData()> CreateLevelLoader(int level) const;
+	// Replaces the GL texture storage (the id stays the same), false if the data doesn't match the texture
+	bool UploadLevel(const TextureLevelData& data);
+	// Frees the storage down to a single texel of the average color
+	void Drop();
+private:
+	void Release();
+	void Upload(const unsigned char* data, size_t size, int width, int height, bool compressed);
+};
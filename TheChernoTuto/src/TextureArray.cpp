@@ -0,0 +1,130 @@
+#include "TextureArray.h"
+
+#include "ImageDecoder.h"
+#include "Renderer.h"
+
+#include <algorithm>
+#include <iostream>
+
+TextureArray::TextureArray(int width, int height, int layers, int channels, TextureUsage usage, bool mipmaps)
+	:m_RendererID(0), m_Width(width), m_Height(height), m_Layers(layers), m_Channels(channels),
+	m_LevelCount(1), m_LayersUsed(0), m_Format(SelectTextureFormat(channels, GL_UNSIGNED_BYTE, usage))
+{
+	m_SamplerState.Filter = mipmaps ? TextureFilter::Trilinear : TextureFilter::Linear;
+
+	int maxLayers = 0;
+	GlCall(glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers));
+	if (m_Layers > maxLayers)
+	{
+		std::cout << "Texture array of " << m_Layers << " layers clamped to " << maxLayers << std::endl;
+		m_Layers = maxLayers;
+	}
+
+	if (mipmaps)
+	{
+		int size = std::max(width, height);
+		while (size > 1)
+		{
+			size >>= 1;
+			++m_LevelCount;
+		}
+	}
+
+	GlCall(glGenTextures(1, &m_RendererID));
+	GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+
+	// filtering and wrapping come from SamplerCache, see Texture
+	GlCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, m_LevelCount - 1));
+	GlCall(glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GlCall(glTexParameteriv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_SWIZZLE_RGBA, m_Format.Swizzle));
+
+	// glTexStorage3D is GL 4.2, allocate each level of the chain the 3.3 way
+	for (int level = 0; level < m_LevelCount; ++level)
+	{
+		GlCall(glTexImage3D(GL_TEXTURE_2D_ARRAY, level, m_Format.InternalFormat,
+			std::max(width >> level, 1), std::max(height >> level, 1), m_Layers, 0,
+			m_Format.Format, GL_UNSIGNED_BYTE, nullptr));
+	}
+	Unbind();
+}
+
+TextureArray::~TextureArray()
+{
+	GlCall(glDeleteTextures(1, &m_RendererID));
+}
+
+void TextureArray::SetLayer(int layer, const unsigned char* pixels)
+{
+	UpdateLayer(layer, 0, 0, m_Width, m_Height, pixels);
+}
+
+void TextureArray::UpdateLayer(int layer, int x, int y, int width, int height, const unsigned char* pixels)
+{
+	ASSERT(layer >= 0 && layer < m_Layers);
+	ASSERT(x >= 0 && y >= 0 && x + width <= m_Width && y + height <= m_Height);
+
+	GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	// rows of R8/RG8/RGB8 images aren't 4 byte aligned
+	GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 1));
+	GlCall(glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, x, y, layer, width, height, 1,
+		m_Format.Format, GL_UNSIGNED_BYTE, pixels));
+	GlCall(glPixelStorei(GL_UNPACK_ALIGNMENT, 4));
+	Unbind();
+}
+
+int TextureArray::AddLayer(const std::string& filepath)
+{
+	if (m_LayersUsed >= m_Layers)
+	{
+		std::cout << "Texture array is full, " << filepath << " wasn't added" << std::endl;
+		return -1;
+	}
+
+	int width, height, channels;
+	unsigned char* pixels = ImageDecoder::Load(filepath, &width, &height, &channels, m_Channels, true);
+	if (!pixels)
+	{
+		std::cout << "Failed to load " << filepath << std::endl;
+		return -1;
+	}
+	if (width != m_Width || height != m_Height)
+	{
+		std::cout << filepath << " is " << width << "x" << height << ", the texture array layers are "
+			<< m_Width << "x" << m_Height << std::endl;
+		ImageDecoder::Free(pixels);
+		return -1;
+	}
+
+	const int layer = m_LayersUsed++;
+	SetLayer(layer, pixels);
+	ImageDecoder::Free(pixels);
+	return layer;
+}
+
+void TextureArray::GenerateMipmaps()
+{
+	if (m_LevelCount == 1)
+	{
+		return;
+	}
+	GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	GlCall(glGenerateMipmap(GL_TEXTURE_2D_ARRAY));
+	Unbind();
+}
+
+void TextureArray::Bind(unsigned int slot) const
+{
+	Bind(slot, m_SamplerState);
+}
+
+void TextureArray::Bind(unsigned int slot, const SamplerState& samplerState) const
+{
+	GlCall(glActiveTexture(GL_TEXTURE0 + slot));
+	GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, m_RendererID));
+	SamplerCache::Bind(slot, samplerState);
+}
+
+void TextureArray::Unbind() const
+{
+	GlCall(glBindTexture(GL_TEXTURE_2D_ARRAY, 0));
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <string>
+
+#include "Texture.h"
+
+/**
+ * \brief GL_TEXTURE_2D_ARRAY of equally sized 8 bit layers. Sprites that use different images of the same
+ * size can share one binding and one draw call: the layer is picked per vertex (the third texture coordinate,
+ * see res/shaders/TextureArray.shader), and unlike an atlas filtering never bleeds between images.
+ */
+class TextureArray
+{
+private:
+	unsigned int m_RendererID;
+	int m_Width, m_Height, m_Layers, m_Channels;
+	int m_LevelCount;
+	int m_LayersUsed;
+	TextureFormat m_Format;
+	SamplerState m_SamplerState;
+public:
+	/**
+	 * \brief Allocates every layer up front, their content is undefined until uploaded
+	 * \param mipmaps allocates the full mip chain, GenerateMipmaps has to be called after the uploads
+	 */
+	TextureArray(int width, int height, int layers, int channels = 4, TextureUsage usage = TextureUsage::Data,
+		bool mipmaps = false);
+	~TextureArray();
+
+	// Replaces a whole layer with tightly packed pixels of the array's size and channel count
+	void SetLayer(int layer, const unsigned char* pixels);
+	// Replaces a rectangle of a layer, pixels are tightly packed width * height
+	void UpdateLayer(int layer, int x, int y, int width, int height, const unsigned char* pixels);
+	/**
+	 * \brief Loads an image into the next layer that wasn't filled by AddLayer yet
+	 * \return the layer index, -1 if the array is full, the file can't be read or its size doesn't match
+	 */
+	int AddLayer(const std::string& filepath);
+	void GenerateMipmaps();
+
+	void Bind(unsigned int slot = 0) const;
+	void Bind(unsigned int slot, const SamplerState& samplerState) const;
+	void Unbind() const;
+
+	inline void SetSamplerState(const SamplerState& samplerState)
+	{
+		m_SamplerState = samplerState;
+	}
+
+	inline int GetWidth() const
+	{
+		return m_Width;
+	}
+
+	inline int GetHeight() const
+	{
+		return m_Height;
+	}
+
+	inline int GetLayerCount() const
+	{
+		return m_Layers;
+	}
+
+	inline int GetChannels() const
+	{
+		return m_Channels;
+	}
+
+	inline unsigned int GetRendererID() const
+	{
+		return m_RendererID;
+	}
+};
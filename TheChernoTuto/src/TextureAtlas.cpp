@@ -0,0 +1,235 @@
+#include "TextureAtlas.h"
+
+#include "ImageDecoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+// ImGui compiles its copy of stb_rectpack as static functions, this translation unit gets its own
+#define STBRP_STATIC
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "imgui/imstb_rectpack.h"
+
+namespace
+{
+	struct TrimmedRect
+	{
+		int X, Y, Width, Height;
+	};
+
+	// Bounding box of the pixels with a non zero alpha, fully transparent images keep a single pixel
+	TrimmedRect FindOpaqueBounds(const unsigned char* rgba, int width, int height)
+	{
+		int minX = width, minY = height, maxX = -1, maxY = -1;
+		for (int y = 0; y < height; ++y)
+		{
+			const unsigned char* row = rgba + (size_t)y * width * 4;
+			for (int x = 0; x < width; ++x)
+			{
+				if (row[x * 4 + 3] != 0)
+				{
+					minX = std::min(minX, x);
+					maxX = std::max(maxX, x);
+					minY = std::min(minY, y);
+					maxY = y;
+				}
+			}
+		}
+		if (maxX < 0)
+		{
+			return { 0, 0, 1, 1 };
+		}
+		return { minX, minY, maxX - minX + 1, maxY - minY + 1 };
+	}
+
+	/**
+	 * \brief Copies the trimmed rectangle of an image to (x, y) on a page. With extrusion the padding
+	 * around it repeats the nearest edge pixel, which is what clamp-to-edge sampling would have returned.
+	 */
+	void Blit(unsigned char* page, int pageWidth, const unsigned char* rgba, int sourceWidth,
+		const TrimmedRect& trim, int x, int y, int padding, bool extrude)
+	{
+		const int border = extrude ? padding : 0;
+		for (int row = -border; row < trim.Height + border; ++row)
+		{
+			const int sourceRow = trim.Y + std::min(std::max(row, 0), trim.Height - 1);
+			const unsigned char* src = rgba + ((size_t)sourceRow * sourceWidth + trim.X) * 4;
+			unsigned char* dst = page + ((size_t)(y + row) * pageWidth + x) * 4;
+
+			std::memcpy(dst, src, (size_t)trim.Width * 4);
+			for (int i = 1; i <= border; ++i)
+			{
+				std::memcpy(dst - i * 4, src, 4);
+				std::memcpy(dst + (trim.Width - 1 + i) * 4, src + (trim.Width - 1) * 4, 4);
+			}
+		}
+	}
+
+	int NextPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+}
+
+TextureAtlas::TextureAtlas()
+	: m_UsedPixels(0), m_PagePixels(0)
+{
+}
+
+bool TextureAtlas::AddImage(const std::string& name, const unsigned char* rgba, int width, int height)
+{
+	if (!rgba || width <= 0 || height <= 0)
+	{
+		return false;
+	}
+	for (const SourceImage& source : m_Sources)
+	{
+		if (source.Name == name)
+		{
+			return false;
+		}
+	}
+
+	SourceImage source;
+	source.Name = name;
+	source.Pixels.assign(rgba, rgba + (size_t)width * height * 4);
+	source.Width = width;
+	source.Height = height;
+	m_Sources.push_back(std::move(source));
+	return true;
+}
+
+bool TextureAtlas::AddImage(const std::string& filepath)
+{
+	int width, height, channels;
+	unsigned char* pixels = ImageDecoder::Load(filepath, &width, &height, &channels, 4, true);
+	if (!pixels)
+	{
+		std::cout << "Failed to load atlas image " << filepath << std::endl;
+		return false;
+	}
+	const bool added = AddImage(filepath, pixels, width, height);
+	ImageDecoder::Free(pixels);
+	return added;
+}
+
+bool TextureAtlas::Build(const TextureAtlasSettings& settings)
+{
+	m_Regions.assign(m_Sources.size(), AtlasRegion());
+	m_RegionIndices.clear();
+	m_Pages.clear();
+	m_UsedPixels = 0;
+	m_PagePixels = 0;
+
+	const int padding = std::max(settings.Padding, 0);
+	std::vector<TrimmedRect> trims(m_Sources.size());
+	std::vector<stbrp_rect> pending;
+	bool allPlaced = true;
+	for (size_t i = 0; i < m_Sources.size(); ++i)
+	{
+		const SourceImage& source = m_Sources[i];
+		m_RegionIndices[source.Name] = i;
+		trims[i] = settings.Trim ? FindOpaqueBounds(source.Pixels.data(), source.Width, source.Height)
+			: TrimmedRect{ 0, 0, source.Width, source.Height };
+
+		AtlasRegion& region = m_Regions[i];
+		region.Page = -1;
+		region.OffsetX = trims[i].X;
+		region.OffsetY = trims[i].Y;
+		region.Width = trims[i].Width;
+		region.Height = trims[i].Height;
+		region.SourceWidth = source.Width;
+		region.SourceHeight = source.Height;
+
+		stbrp_rect rect = {};
+		rect.id = (int)i;
+		rect.w = trims[i].Width + padding * 2;
+		rect.h = trims[i].Height + padding * 2;
+		if (rect.w > settings.PageSize || rect.h > settings.PageSize)
+		{
+			std::cout << "Atlas image " << source.Name << " (" << source.Width << "x" << source.Height
+				<< ") doesn't fit on a " << settings.PageSize << " page" << std::endl;
+			allPlaced = false;
+			continue;
+		}
+		pending.push_back(rect);
+	}
+
+	// every pass fills one page, whatever didn't fit is retried on the next one
+	std::vector<stbrp_node> nodes(settings.PageSize);
+	std::vector<int> pageHeights;
+	while (!pending.empty())
+	{
+		stbrp_context context;
+		stbrp_init_target(&context, settings.PageSize, settings.PageSize, nodes.data(), (int)nodes.size());
+		stbrp_pack_rects(&context, pending.data(), (int)pending.size());
+
+		const int page = (int)pageHeights.size();
+		int usedHeight = 1;
+		std::vector<stbrp_rect> remaining;
+		for (const stbrp_rect& rect : pending)
+		{
+			if (!rect.was_packed)
+			{
+				remaining.push_back(rect);
+				continue;
+			}
+			AtlasRegion& region = m_Regions[rect.id];
+			region.Page = page;
+			region.X = rect.x + padding;
+			region.Y = rect.y + padding;
+			usedHeight = std::max(usedHeight, rect.y + rect.h);
+		}
+		// the last page is usually mostly empty, only keep the rows that were used
+		pageHeights.push_back(std::min(NextPowerOfTwo(usedHeight), settings.PageSize));
+		pending.swap(remaining);
+	}
+
+	std::vector<std::vector<unsigned char>> pages(pageHeights.size());
+	for (size_t i = 0; i < pages.size(); ++i)
+	{
+		pages[i].assign((size_t)settings.PageSize * pageHeights[i] * 4, 0);
+		m_PagePixels += (unsigned long long)settings.PageSize * pageHeights[i];
+	}
+
+	for (size_t i = 0; i < m_Sources.size(); ++i)
+	{
+		AtlasRegion& region = m_Regions[i];
+		if (region.Page < 0)
+		{
+			continue;
+		}
+		const SourceImage& source = m_Sources[i];
+		Blit(pages[region.Page].data(), settings.PageSize, source.Pixels.data(), source.Width,
+			trims[i], region.X, region.Y, padding, settings.Extrude);
+
+		const float pageWidth = (float)settings.PageSize;
+		const float pageHeight = (float)pageHeights[region.Page];
+		region.U0 = region.X / pageWidth;
+		region.V0 = region.Y / pageHeight;
+		region.U1 = (region.X + region.Width) / pageWidth;
+		region.V1 = (region.Y + region.Height) / pageHeight;
+		m_UsedPixels += (unsigned long long)region.Width * region.Height;
+	}
+
+	for (size_t i = 0; i < pages.size(); ++i)
+	{
+		m_Pages.emplace_back(new Texture(settings.PageSize, pageHeights[i], pages[i].data(), 4, settings.Usage));
+	}
+
+	m_Sources.clear();
+	m_Sources.shrink_to_fit();
+	return allPlaced;
+}
+
+const AtlasRegion* TextureAtlas::GetRegion(const std::string& name) const
+{
+	auto it = m_RegionIndices.find(name);
+	return it != m_RegionIndices.end() ? &m_Regions[it->second] : nullptr;
+}
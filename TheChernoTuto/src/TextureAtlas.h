@@ -0,0 +1,93 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "Texture.h"
+
+struct AtlasRegion
+{
+	// -1 when the image didn't fit on a page
+	int Page;
+	// texture coordinates of the trimmed image, origin bottom left like the rest of the renderer
+	float U0, V0, U1, V1;
+	// trimmed rectangle in page pixels
+	int X, Y, Width, Height;
+	// where the trimmed rectangle sits inside the original image, measured from its bottom left corner
+	int OffsetX, OffsetY;
+	int SourceWidth, SourceHeight;
+};
+
+struct TextureAtlasSettings
+{
+	int PageSize = 2048;
+	// empty pixels kept around every image so linear filtering and mipmaps don't bleed into neighbours
+	int Padding = 2;
+	// fills the padding with copies of the image edge instead of leaving it transparent
+	bool Extrude = true;
+	// drops the fully transparent rows and columns around each image before packing
+	bool Trim = true;
+	TextureUsage Usage = TextureUsage::Color;
+};
+
+/**
+ * \brief Packs many small RGBA images into a few large pages with stb_rectpack so sprites that live on
+ * the same page can be drawn without switching textures. Images are added first, Build packs them and
+ * uploads the pages, then each image is looked up by name to get its page and UV rectangle.
+ */
+class TextureAtlas
+{
+private:
+	struct SourceImage
+	{
+		std::string Name;
+		std::vector<unsigned char> Pixels;
+		int Width, Height;
+	};
+
+	std::vector<SourceImage> m_Sources;
+	std::vector<AtlasRegion> m_Regions;
+	std::unordered_map<std::string, size_t> m_RegionIndices;
+	std::vector<std::unique_ptr<Texture>> m_Pages;
+	unsigned long long m_UsedPixels;
+	unsigned long long m_PagePixels;
+public:
+	TextureAtlas();
+
+	// Copies 8 bit RGBA pixels stored bottom up, the name has to be unique within the atlas
+	bool AddImage(const std::string& name, const unsigned char* rgba, int width, int height);
+	// Decodes an image file, the file path becomes the name of the region
+	bool AddImage(const std::string& filepath);
+
+	/**
+	 * \brief Packs every added image, replacing the pages of a previous build. The added images are
+	 * released afterwards, images that are larger than a page are reported and get Page = -1.
+	 * \return false when at least one image couldn't be placed
+	 */
+	bool Build(const TextureAtlasSettings& settings = TextureAtlasSettings());
+
+	// nullptr for names that weren't added
+	const AtlasRegion* GetRegion(const std::string& name) const;
+
+	inline const std::vector<AtlasRegion>& GetRegions() const
+	{
+		return m_Regions;
+	}
+
+	inline size_t GetPageCount() const
+	{
+		return m_Pages.size();
+	}
+
+	inline const Texture& GetPage(size_t index) const
+	{
+		return *m_Pages[index];
+	}
+
+	// Share of the page area covered by trimmed images, padding excluded
+	inline float GetOccupancy() const
+	{
+		return m_PagePixels ? (float)((double)m_UsedPixels / m_PagePixels) : 0.0f;
+	}
+};
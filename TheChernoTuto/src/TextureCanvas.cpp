@@ -0,0 +1,225 @@
+#include "TextureCanvas.h"
+
+#include "Renderer.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	size_t Area(const CanvasRect& rect)
+	{
+		return (size_t)rect.Width * rect.Height;
+	}
+
+	CanvasRect Union(const CanvasRect& a, const CanvasRect& b)
+	{
+		const int x0 = std::min(a.X, b.X), y0 = std::min(a.Y, b.Y);
+		const int x1 = std::max(a.X + a.Width, b.X + b.Width), y1 = std::max(a.Y + a.Height, b.Y + b.Height);
+		return { x0, y0, x1 - x0, y1 - y0 };
+	}
+}
+
+TextureCanvas::TextureCanvas(int width, int height, int channels, TextureUsage usage)
+	: m_Width(width), m_Height(height), m_Channels(channels), m_Pixels((size_t)width * height * channels, 0),
+	m_Texture(width, height, m_Pixels.data(), channels, usage), m_MarkedRects(0), m_UsePixelBuffers(false),
+	m_PixelBuffers(), m_Fences(), m_NextPixelBuffer(0), m_Stats()
+{
+}
+
+TextureCanvas::~TextureCanvas()
+{
+	DeletePixelBuffers();
+}
+
+void TextureCanvas::MarkDirty(int x, int y, int width, int height)
+{
+	const int x0 = std::max(x, 0), y0 = std::max(y, 0);
+	const int x1 = std::min(x + width, m_Width), y1 = std::min(y + height, m_Height);
+	if (x1 <= x0 || y1 <= y0)
+	{
+		return;
+	}
+	++m_MarkedRects;
+
+	// absorb every rect that is cheaper to upload together with this one, the union may then absorb more
+	CanvasRect rect = { x0, y0, x1 - x0, y1 - y0 };
+	for (size_t i = 0; i < m_DirtyRects.size();)
+	{
+		const CanvasRect merged = Union(rect, m_DirtyRects[i]);
+		if (Area(merged) <= Area(rect) + Area(m_DirtyRects[i]))
+		{
+			rect = merged;
+			m_DirtyRects[i] = m_DirtyRects.back();
+			m_DirtyRects.pop_back();
+			i = 0;
+		}
+		else
+		{
+			++i;
+		}
+	}
+	m_DirtyRects.push_back(rect);
+
+	// past a handful of scattered rects the per upload overhead wins, send their bounding box
+	if (m_DirtyRects.size() > MaxDirtyRects)
+	{
+		CanvasRect bounds = m_DirtyRects[0];
+		for (const CanvasRect& dirty : m_DirtyRects)
+		{
+			bounds = Union(bounds, dirty);
+		}
+		m_DirtyRects.assign(1, bounds);
+	}
+}
+
+void TextureCanvas::FillRect(int x, int y, int width, int height, const unsigned char* color)
+{
+	const int x0 = std::max(x, 0), y0 = std::max(y, 0);
+	const int x1 = std::min(x + width, m_Width), y1 = std::min(y + height, m_Height);
+	for (int row = y0; row < y1; ++row)
+	{
+		unsigned char* dst = &m_Pixels[((size_t)row * m_Width + x0) * m_Channels];
+		for (int column = x0; column < x1; ++column, dst += m_Channels)
+		{
+			std::memcpy(dst, color, m_Channels);
+		}
+	}
+	MarkDirty(x, y, width, height);
+}
+
+void TextureCanvas::Flush()
+{
+	m_Stats.MarkedRects = m_MarkedRects;
+	m_Stats.UploadedRects = (unsigned int)m_DirtyRects.size();
+	m_Stats.UploadedBytes = 0;
+	m_Stats.FullUploadBytes = m_Pixels.size();
+	m_Stats.PixelBufferStalls = 0;
+	for (const CanvasRect& rect : m_DirtyRects)
+	{
+		m_Stats.UploadedBytes += Area(rect) * m_Channels;
+	}
+
+	if (!m_DirtyRects.empty())
+	{
+		if (m_UsePixelBuffers)
+		{
+			UploadThroughPixelBuffer();
+		}
+		else
+		{
+			UploadDirect();
+		}
+	}
+	m_DirtyRects.clear();
+	m_MarkedRects = 0;
+}
+
+void TextureCanvas::UploadDirect()
+{
+	// the rows of each rect stay where they are in the CPU copy, the row length skips the rest of the canvas
+	for (const CanvasRect& rect : m_DirtyRects)
+	{
+		const unsigned char* first = &m_Pixels[((size_t)rect.Y * m_Width + rect.X) * m_Channels];
+		m_Texture.Update(rect.X, rect.Y, rect.Width, rect.Height, first, m_Width);
+	}
+}
+
+void TextureCanvas::UploadThroughPixelBuffer()
+{
+	const unsigned int index = m_NextPixelBuffer;
+	m_NextPixelBuffer = (m_NextPixelBuffer + 1) % PixelBufferCount;
+
+	if (m_PixelBuffers[index] == 0)
+	{
+		GlCall(glGenBuffers(1, &m_PixelBuffers[index]));
+		GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[index]));
+		// overlapping rects that weren't worth merging can add up to more than the canvas
+		GlCall(glBufferData(GL_PIXEL_UNPACK_BUFFER, m_Pixels.size() * 2, nullptr, GL_STREAM_DRAW));
+	}
+	else
+	{
+		GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_PixelBuffers[index]));
+	}
+
+	// the uploads out of this buffer PixelBufferCount flushes ago may still be running
+	if (m_Fences[index])
+	{
+		GLsync fence = (GLsync)m_Fences[index];
+		GlCall(GLenum status = glClientWaitSync(fence, 0, 0));
+		if (status == GL_TIMEOUT_EXPIRED)
+		{
+			++m_Stats.PixelBufferStalls;
+			GlCall(glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED));
+		}
+		GlCall(glDeleteSync(fence));
+		m_Fences[index] = nullptr;
+	}
+
+	const size_t size = m_Stats.UploadedBytes;
+	if (size > m_Pixels.size() * 2)
+	{
+		GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		UploadDirect();
+		return;
+	}
+
+	GlCall(unsigned char* mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+	if (!mapped)
+	{
+		GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+		UploadDirect();
+		return;
+	}
+
+	// rects are packed one after the other with tight rows
+	std::vector<size_t> offsets;
+	size_t offset = 0;
+	for (const CanvasRect& rect : m_DirtyRects)
+	{
+		offsets.push_back(offset);
+		const size_t rowSize = (size_t)rect.Width * m_Channels;
+		for (int row = 0; row < rect.Height; ++row)
+		{
+			std::memcpy(mapped + offset, &m_Pixels[((size_t)(rect.Y + row) * m_Width + rect.X) * m_Channels], rowSize);
+			offset += rowSize;
+		}
+	}
+	GlCall(glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER));
+
+	for (size_t i = 0; i < m_DirtyRects.size(); ++i)
+	{
+		const CanvasRect& rect = m_DirtyRects[i];
+		m_Texture.Update(rect.X, rect.Y, rect.Width, rect.Height, (const void*)offsets[i]);
+	}
+	GlCall(m_Fences[index] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+	GlCall(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+}
+
+void TextureCanvas::SetUsePixelBuffers(bool usePixelBuffers)
+{
+	if (!usePixelBuffers)
+	{
+		DeletePixelBuffers();
+	}
+	m_UsePixelBuffers = usePixelBuffers;
+}
+
+void TextureCanvas::DeletePixelBuffers()
+{
+	for (unsigned int i = 0; i < PixelBufferCount; ++i)
+	{
+		if (m_Fences[i])
+		{
+			GlCall(glDeleteSync((GLsync)m_Fences[i]));
+			m_Fences[i] = nullptr;
+		}
+		if (m_PixelBuffers[i])
+		{
+			GlCall(glDeleteBuffers(1, &m_PixelBuffers[i]));
+			m_PixelBuffers[i] = 0;
+		}
+	}
+	m_NextPixelBuffer = 0;
+}
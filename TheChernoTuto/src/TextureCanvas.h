@@ -0,0 +1,102 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+#include "Texture.h"
+
+struct CanvasRect
+{
+	int X, Y;
+	int Width, Height;
+};
+
+struct TextureCanvasStats
+{
+	// rects marked since the previous flush and what they were merged into
+	unsigned int MarkedRects;
+	unsigned int UploadedRects;
+	size_t UploadedBytes;
+	// what re-uploading the whole canvas would have cost instead
+	size_t FullUploadBytes;
+	// times the CPU waited for the GPU to release a pixel buffer
+	unsigned int PixelBufferStalls;
+};
+
+/**
+ * \brief A texture edited on the CPU a few regions at a time. Changes go to the CPU copy, the regions they
+ * touch are recorded with MarkDirty and Flush uploads only those, either straight from the CPU copy with
+ * GL_UNPACK_ROW_LENGTH or packed into the next buffer of a small pixel buffer ring so the copy to the GPU
+ * doesn't block the frame. Dirty rects are merged whenever their union costs no more than uploading both.
+ */
+class TextureCanvas
+{
+public:
+	static const unsigned int MaxDirtyRects = 16;
+	static const unsigned int PixelBufferCount = 3;
+
+	TextureCanvas(int width, int height, int channels = 4, TextureUsage usage = TextureUsage::Color);
+	~TextureCanvas();
+
+	// The CPU copy, rows bottom up and tightly packed, call MarkDirty for what is written through it
+	inline unsigned char* GetPixels()
+	{
+		return m_Pixels.data();
+	}
+
+	// Clipped to the canvas, empty rects are ignored
+	void MarkDirty(int x, int y, int width, int height);
+	void FillRect(int x, int y, int width, int height, const unsigned char* color);
+	// Uploads the dirty rects and starts a new list, once per frame before drawing with the texture
+	void Flush();
+
+	void SetUsePixelBuffers(bool usePixelBuffers);
+
+	inline bool GetUsePixelBuffers() const
+	{
+		return m_UsePixelBuffers;
+	}
+
+	inline const std::vector<CanvasRect>& GetDirtyRects() const
+	{
+		return m_DirtyRects;
+	}
+
+	inline Texture& GetTexture()
+	{
+		return m_Texture;
+	}
+
+	inline int GetWidth() const
+	{
+		return m_Width;
+	}
+
+	inline int GetHeight() const
+	{
+		return m_Height;
+	}
+
+	// Counters of the last Flush
+	inline const TextureCanvasStats& GetStats() const
+	{
+		return m_Stats;
+	}
+private:
+	void UploadDirect();
+	void UploadThroughPixelBuffer();
+	void DeletePixelBuffers();
+
+	int m_Width, m_Height, m_Channels;
+	std::vector<unsigned char> m_Pixels;
+	Texture m_Texture;
+	std::vector<CanvasRect> m_DirtyRects;
+	unsigned int m_MarkedRects;
+
+	bool m_UsePixelBuffers;
+	unsigned int m_PixelBuffers[PixelBufferCount];
+	// GLsync of the last upload out of each buffer
+	void* m_Fences[PixelBufferCount];
+	unsigned int m_NextPixelBuffer;
+
+	TextureCanvasStats m_Stats;
+};
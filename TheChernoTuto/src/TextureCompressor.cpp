@@ -0,0 +1,712 @@
+#include "TextureCompressor.h"
+#include "JobSystem.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COMPRESSOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define TEXTURE_COMPRESSOR_SSE2 0
+#endif
+
+namespace
+{
+	// Copies the 4x4 block at (bx, by) as 16 RGBA pixels, edge pixels are repeated for partial blocks
+	void FetchBlock(const unsigned char* rgba, int width, int height, int bx, int by, unsigned char* block)
+	{
+		for (int y = 0; y < 4; ++y)
+		{
+			const int sy = std::min(by * 4 + y, height - 1);
+			for (int x = 0; x < 4; ++x)
+			{
+				const int sx = std::min(bx * 4 + x, width - 1);
+				std::memcpy(block + (y * 4 + x) * 4, rgba + ((size_t)sy * width + sx) * 4, 4);
+			}
+		}
+	}
+
+	// Per channel minimum and maximum of the 16 pixels, shared by the color and the channel encoders
+	void ComputeBlockRange(const unsigned char* block, unsigned char* minColor, unsigned char* maxColor)
+	{
+#if TEXTURE_COMPRESSOR_SSE2
+		const __m128i p0 = _mm_loadu_si128((const __m128i*)(block + 0));
+		const __m128i p1 = _mm_loadu_si128((const __m128i*)(block + 16));
+		const __m128i p2 = _mm_loadu_si128((const __m128i*)(block + 32));
+		const __m128i p3 = _mm_loadu_si128((const __m128i*)(block + 48));
+
+		__m128i mn = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+		__m128i mx = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+		mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(2, 3, 0, 1)));
+		mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(2, 3, 0, 1)));
+		mn = _mm_min_epu8(mn, _mm_shuffle_epi32(mn, _MM_SHUFFLE(1, 0, 3, 2)));
+		mx = _mm_max_epu8(mx, _mm_shuffle_epi32(mx, _MM_SHUFFLE(1, 0, 3, 2)));
+
+		const int packedMin = _mm_cvtsi128_si32(mn);
+		const int packedMax = _mm_cvtsi128_si32(mx);
+		std::memcpy(minColor, &packedMin, 4);
+		std::memcpy(maxColor, &packedMax, 4);
+#else
+		for (int c = 0; c < 4; ++c)
+		{
+			minColor[c] = 255;
+			maxColor[c] = 0;
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+				maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+			}
+		}
+#endif
+	}
+
+	unsigned short To565(int r, int g, int b)
+	{
+		return (unsigned short)((((r * 31 + 127) / 255) << 11) | (((g * 63 + 127) / 255) << 5) | ((b * 31 + 127) / 255));
+	}
+
+	void From565(unsigned short color, int* rgb)
+	{
+		const int r = (color >> 11) & 31;
+		const int g = (color >> 5) & 63;
+		const int b = color & 31;
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+
+	void BuildColorPalette(unsigned short c0, unsigned short c1, bool fourColorMode, int palette[4][3])
+	{
+		From565(c0, palette[0]);
+		From565(c1, palette[1]);
+		for (int c = 0; c < 3; ++c)
+		{
+			if (fourColorMode)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+			else
+			{
+				palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+	}
+
+	// Picks the closest palette entry for every pixel and returns the summed squared error
+	int MatchColors(const unsigned char* block, const int palette[4][3], unsigned char* indices)
+	{
+		int error = 0;
+#if TEXTURE_COMPRESSOR_SSE2
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rgbMask = _mm_set1_epi32(0x00FFFFFF);
+		__m128i entries[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			entries[i] = _mm_setr_epi16((short)palette[i][0], (short)palette[i][1], (short)palette[i][2], 0,
+				(short)palette[i][0], (short)palette[i][1], (short)palette[i][2], 0);
+		}
+
+		// 4 pixels per iteration, each one widened to 16 bits so that _mm_madd_epi16 yields squared distances
+		for (int q = 0; q < 4; ++q)
+		{
+			const __m128i pixels = _mm_and_si128(_mm_loadu_si128((const __m128i*)(block + q * 16)), rgbMask);
+			const __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+			const __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+			__m128i best = _mm_set1_epi32(INT_MAX);
+			__m128i bestIndex = zero;
+			for (int i = 0; i < 4; ++i)
+			{
+				const __m128i dl = _mm_sub_epi16(lo, entries[i]);
+				const __m128i dh = _mm_sub_epi16(hi, entries[i]);
+				const __m128 sl = _mm_castsi128_ps(_mm_madd_epi16(dl, dl));
+				const __m128 sh = _mm_castsi128_ps(_mm_madd_epi16(dh, dh));
+				const __m128i distance = _mm_add_epi32(
+					_mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(2, 0, 2, 0))),
+					_mm_castps_si128(_mm_shuffle_ps(sl, sh, _MM_SHUFFLE(3, 1, 3, 1))));
+
+				const __m128i closer = _mm_cmplt_epi32(distance, best);
+				best = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, best));
+				bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, bestIndex));
+			}
+
+			int distances[4], selected[4];
+			_mm_storeu_si128((__m128i*)distances, best);
+			_mm_storeu_si128((__m128i*)selected, bestIndex);
+			for (int i = 0; i < 4; ++i)
+			{
+				indices[q * 4 + i] = (unsigned char)selected[i];
+				error += distances[i];
+			}
+		}
+#else
+		for (int p = 0; p < 16; ++p)
+		{
+			int best = INT_MAX;
+			for (int i = 0; i < 4; ++i)
+			{
+				const int dr = block[p * 4 + 0] - palette[i][0];
+				const int dg = block[p * 4 + 1] - palette[i][1];
+				const int db = block[p * 4 + 2] - palette[i][2];
+				const int distance = dr * dr + dg * dg + db * db;
+				if (distance < best)
+				{
+					best = distance;
+					indices[p] = (unsigned char)i;
+				}
+			}
+			error += best;
+		}
+#endif
+		return error;
+	}
+
+	int EvaluateEndpoints(const unsigned char* block, unsigned short c0, unsigned short c1, unsigned char* indices)
+	{
+		int palette[4][3];
+		BuildColorPalette(c0, c1, true, palette);
+		return MatchColors(block, palette, indices);
+	}
+
+	// Least squares fit of both endpoints for a fixed set of indices
+	bool RefineEndpoints(const unsigned char* block, const unsigned char* indices, unsigned short* c0, unsigned short* c1)
+	{
+		static const float weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[3] = { 0.0f, 0.0f, 0.0f };
+		float bx[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			const float t = weights[indices[i]];
+			const float s = 1.0f - t;
+			aa += s * s;
+			bb += t * t;
+			ab += s * t;
+			for (int c = 0; c < 3; ++c)
+			{
+				ax[c] += s * block[i * 4 + c];
+				bx[c] += t * block[i * 4 + c];
+			}
+		}
+
+		const float det = aa * bb - ab * ab;
+		if (std::fabs(det) < 1e-6f)
+		{
+			return false;
+		}
+
+		int a[3], b[3];
+		for (int c = 0; c < 3; ++c)
+		{
+			a[c] = (int)std::lround(std::min(std::max((ax[c] * bb - bx[c] * ab) / det, 0.0f), 255.0f));
+			b[c] = (int)std::lround(std::min(std::max((bx[c] * aa - ax[c] * ab) / det, 0.0f), 255.0f));
+		}
+		*c0 = To565(a[0], a[1], a[2]);
+		*c1 = To565(b[0], b[1], b[2]);
+		return true;
+	}
+
+	void WriteColorBlock(unsigned char* out, unsigned short c0, unsigned short c1, const unsigned char* indices)
+	{
+		// c0 > c1 selects the four color mode, swapping the endpoints mirrors the indices
+		unsigned char flip = 0;
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+			flip = 1;
+		}
+
+		unsigned int mask = 0;
+		if (c0 != c1)
+		{
+			for (int i = 0; i < 16; ++i)
+			{
+				mask |= (unsigned int)(indices[i] ^ flip) << (2 * i);
+			}
+		}
+
+		out[0] = (unsigned char)(c0 & 0xFF);
+		out[1] = (unsigned char)(c0 >> 8);
+		out[2] = (unsigned char)(c1 & 0xFF);
+		out[3] = (unsigned char)(c1 >> 8);
+		for (int i = 0; i < 4; ++i)
+		{
+			out[4 + i] = (unsigned char)(mask >> (8 * i));
+		}
+	}
+
+	void EncodeColorBlock(const unsigned char* block, const unsigned char* minColor, const unsigned char* maxColor, unsigned char* out)
+	{
+		unsigned char indices[16] = {};
+		if (minColor[0] == maxColor[0] && minColor[1] == maxColor[1] && minColor[2] == maxColor[2])
+		{
+			const unsigned short color = To565(minColor[0], minColor[1], minColor[2]);
+			WriteColorBlock(out, color, color, indices);
+			return;
+		}
+
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < 16; ++i)
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				mean[c] += block[i * 4 + c];
+			}
+		}
+		for (int c = 0; c < 3; ++c)
+		{
+			mean[c] /= 16.0f;
+		}
+
+		// covariance matrix stored as xx, xy, xz, yy, yz, zz
+		float cov[6] = {};
+		for (int i = 0; i < 16; ++i)
+		{
+			const float r = block[i * 4 + 0] - mean[0];
+			const float g = block[i * 4 + 1] - mean[1];
+			const float b = block[i * 4 + 2] - mean[2];
+			cov[0] += r * r;
+			cov[1] += r * g;
+			cov[2] += r * b;
+			cov[3] += g * g;
+			cov[4] += g * b;
+			cov[5] += b * b;
+		}
+
+		// principal axis through power iteration, seeded with the bounding box diagonal
+		float axis[3] = {
+			(float)(maxColor[0] - minColor[0]),
+			(float)(maxColor[1] - minColor[1]),
+			(float)(maxColor[2] - minColor[2])
+		};
+		for (int iteration = 0; iteration < 4; ++iteration)
+		{
+			const float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+			const float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+			const float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+			const float length = std::max(std::fabs(x), std::max(std::fabs(y), std::fabs(z)));
+			if (length < 1e-6f)
+			{
+				break;
+			}
+			axis[0] = x / length;
+			axis[1] = y / length;
+			axis[2] = z / length;
+		}
+
+		int minPixel = 0, maxPixel = 0;
+		float minDot = std::numeric_limits<float>::max();
+		float maxDot = -std::numeric_limits<float>::max();
+		for (int i = 0; i < 16; ++i)
+		{
+			const float dot = block[i * 4 + 0] * axis[0] + block[i * 4 + 1] * axis[1] + block[i * 4 + 2] * axis[2];
+			if (dot < minDot)
+			{
+				minDot = dot;
+				minPixel = i;
+			}
+			if (dot > maxDot)
+			{
+				maxDot = dot;
+				maxPixel = i;
+			}
+		}
+
+		unsigned short c0 = To565(block[maxPixel * 4 + 0], block[maxPixel * 4 + 1], block[maxPixel * 4 + 2]);
+		unsigned short c1 = To565(block[minPixel * 4 + 0], block[minPixel * 4 + 1], block[minPixel * 4 + 2]);
+		int error = EvaluateEndpoints(block, c0, c1, indices);
+
+		unsigned short r0, r1;
+		if (RefineEndpoints(block, indices, &r0, &r1))
+		{
+			unsigned char refined[16];
+			const int refinedError = EvaluateEndpoints(block, r0, r1, refined);
+			if (refinedError < error)
+			{
+				c0 = r0;
+				c1 = r1;
+				std::memcpy(indices, refined, sizeof(refined));
+			}
+		}
+
+		WriteColorBlock(out, c0, c1, indices);
+	}
+
+	// BC4 style block for one channel, always in the 8 interpolated values mode
+	void EncodeChannelBlock(const unsigned char* block, int channel, unsigned char lo, unsigned char hi, unsigned char* out)
+	{
+		out[0] = hi;
+		out[1] = lo;
+
+		unsigned long long bits = 0;
+		if (hi > lo)
+		{
+			const int range = hi - lo;
+			for (int i = 0; i < 16; ++i)
+			{
+				const int step = ((block[i * 4 + channel] - lo) * 7 + range / 2) / range;
+				const int index = step == 7 ? 0 : (step == 0 ? 1 : 8 - step);
+				bits |= (unsigned long long)index << (3 * i);
+			}
+		}
+
+		for (int i = 0; i < 6; ++i)
+		{
+			out[2 + i] = (unsigned char)(bits >> (8 * i));
+		}
+	}
+
+	void DecodeColorBlock(const unsigned char* in, bool alwaysFourColor, unsigned char* pixels)
+	{
+		const unsigned short c0 = (unsigned short)(in[0] | (in[1] << 8));
+		const unsigned short c1 = (unsigned short)(in[2] | (in[3] << 8));
+		const unsigned int mask = in[4] | (in[5] << 8) | (in[6] << 16) | ((unsigned int)in[7] << 24);
+
+		int palette[4][3];
+		BuildColorPalette(c0, c1, alwaysFourColor || c0 > c1, palette);
+		for (int i = 0; i < 16; ++i)
+		{
+			const int index = (mask >> (2 * i)) & 3;
+			pixels[i * 4 + 0] = (unsigned char)palette[index][0];
+			pixels[i * 4 + 1] = (unsigned char)palette[index][1];
+			pixels[i * 4 + 2] = (unsigned char)palette[index][2];
+		}
+	}
+
+	void DecodeChannelBlock(const unsigned char* in, int channel, unsigned char* pixels)
+	{
+		unsigned char palette[8];
+		palette[0] = in[0];
+		palette[1] = in[1];
+		if (in[0] > in[1])
+		{
+			for (int i = 2; i < 8; ++i)
+			{
+				palette[i] = (unsigned char)(((8 - i) * in[0] + (i - 1) * in[1]) / 7);
+			}
+		}
+		else
+		{
+			for (int i = 2; i < 6; ++i)
+			{
+				palette[i] = (unsigned char)(((6 - i) * in[0] + (i - 1) * in[1]) / 5);
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		unsigned long long bits = 0;
+		for (int i = 0; i < 6; ++i)
+		{
+			bits |= (unsigned long long)in[2 + i] << (8 * i);
+		}
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i * 4 + channel] = palette[(bits >> (3 * i)) & 7];
+		}
+	}
+
+	/**
+	 * \brief Widens 8 bit pixels to the RGBA layout the block encoder expects. Gray images fill R, G and B
+	 * so that BC1/BC3 keep their color, except for BC5 which stores gray + alpha in R and G.
+	 */
+	std::vector<unsigned char> ExpandToRGBA(const unsigned char* pixels, int width, int height, int channels,
+		TextureCompression compression)
+	{
+		const size_t count = (size_t)width * height;
+		std::vector<unsigned char> rgba(count * 4);
+		for (size_t i = 0; i < count; ++i)
+		{
+			const unsigned char* src = pixels + i * channels;
+			unsigned char* dst = &rgba[i * 4];
+			switch (channels)
+			{
+			case 1:
+				dst[0] = dst[1] = dst[2] = src[0];
+				dst[3] = 255;
+				break;
+			case 2:
+				if (compression == TextureCompression::BC5)
+				{
+					dst[0] = src[0];
+					dst[1] = src[1];
+					dst[2] = 0;
+				}
+				else
+				{
+					dst[0] = dst[1] = dst[2] = src[0];
+				}
+				dst[3] = src[1];
+				break;
+			case 3:
+				dst[0] = src[0];
+				dst[1] = src[1];
+				dst[2] = src[2];
+				dst[3] = 255;
+				break;
+			default:
+				dst[0] = src[0];
+				dst[1] = src[1];
+				dst[2] = src[2];
+				dst[3] = src[3];
+				break;
+			}
+		}
+		return rgba;
+	}
+}
+
+std::vector<unsigned char> TextureCompressor::Compress(const unsigned char* rgba, int width, int height,
+	TextureCompression format, unsigned int threadCount)
+{
+	if (format == TextureCompression::None || !rgba || width <= 0 || height <= 0)
+	{
+		return std::vector<unsigned char>();
+	}
+
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const unsigned int blockSize = GetBlockSize(format);
+	std::vector<unsigned char> output(GetCompressedSize(format, width, height));
+
+	auto encodeRows = [&](int firstRow, int lastRow)
+	{
+		unsigned char block[64];
+		unsigned char minColor[4], maxColor[4];
+		for (int by = firstRow; by < lastRow; ++by)
+		{
+			for (int bx = 0; bx < blocksX; ++bx)
+			{
+				FetchBlock(rgba, width, height, bx, by, block);
+				ComputeBlockRange(block, minColor, maxColor);
+
+				unsigned char* dst = &output[((size_t)by * blocksX + bx) * blockSize];
+				switch (format)
+				{
+				case TextureCompression::BC1:
+					EncodeColorBlock(block, minColor, maxColor, dst);
+					break;
+				case TextureCompression::BC3:
+					EncodeChannelBlock(block, 3, minColor[3], maxColor[3], dst);
+					EncodeColorBlock(block, minColor, maxColor, dst + 8);
+					break;
+				case TextureCompression::BC4:
+					EncodeChannelBlock(block, 0, minColor[0], maxColor[0], dst);
+					break;
+				case TextureCompression::BC5:
+					EncodeChannelBlock(block, 0, minColor[0], maxColor[0], dst);
+					EncodeChannelBlock(block, 1, minColor[1], maxColor[1], dst + 8);
+					break;
+				default:
+					break;
+				}
+			}
+		}
+	};
+
+	// inside the application the job system's workers share the rows, idle ones stealing what is left
+	if (threadCount == 0 && JobSystem::IsRunning())
+	{
+		JobSystem::ParallelFor((size_t)blocksY, RowsPerJob, [&](size_t first, size_t last)
+		{
+			encodeRows((int)first, (int)last);
+		});
+		return output;
+	}
+
+	unsigned int workers = threadCount ? threadCount : std::max(1u, std::thread::hardware_concurrency());
+	workers = std::min(workers, (unsigned int)blocksY);
+	if (workers <= 1)
+	{
+		encodeRows(0, blocksY);
+		return output;
+	}
+
+	// every worker owns a contiguous band of block rows so no synchronisation is needed on the output
+	std::vector<std::thread> threads;
+	threads.reserve(workers);
+	for (unsigned int i = 0; i < workers; ++i)
+	{
+		const int first = (int)((unsigned long long)blocksY * i / workers);
+		const int last = (int)((unsigned long long)blocksY * (i + 1) / workers);
+		threads.emplace_back(encodeRows, first, last);
+	}
+	for (auto& thread : threads)
+	{
+		thread.join();
+	}
+
+	return output;
+}
+
+std::vector<unsigned char> TextureCompressor::CompressPixels(const unsigned char* pixels, int width, int height,
+	int channels, TextureCompression format, unsigned int threadCount)
+{
+	if (format == TextureCompression::None || !pixels || width <= 0 || height <= 0)
+	{
+		return std::vector<unsigned char>();
+	}
+	const std::vector<unsigned char> rgba = ExpandToRGBA(pixels, width, height, channels, format);
+	return Compress(rgba.data(), width, height, format, threadCount);
+}
+
+std::vector<unsigned char> TextureCompressor::Decompress(const unsigned char* blocks, int width, int height,
+	TextureCompression format)
+{
+	if (format == TextureCompression::None || !blocks || width <= 0 || height <= 0)
+	{
+		return std::vector<unsigned char>();
+	}
+
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+	const unsigned int blockSize = GetBlockSize(format);
+	std::vector<unsigned char> output((size_t)width * height * 4);
+
+	unsigned char pixels[64];
+	for (int by = 0; by < blocksY; ++by)
+	{
+		for (int bx = 0; bx < blocksX; ++bx)
+		{
+			const unsigned char* src = blocks + ((size_t)by * blocksX + bx) * blockSize;
+			// channels that the format doesn't store read back the way the GPU exposes them
+			for (int i = 0; i < 16; ++i)
+			{
+				pixels[i * 4 + 0] = 0;
+				pixels[i * 4 + 1] = 0;
+				pixels[i * 4 + 2] = 0;
+				pixels[i * 4 + 3] = 255;
+			}
+
+			switch (format)
+			{
+			case TextureCompression::BC1:
+				DecodeColorBlock(src, false, pixels);
+				break;
+			case TextureCompression::BC3:
+				DecodeChannelBlock(src, 3, pixels);
+				DecodeColorBlock(src + 8, true, pixels);
+				break;
+			case TextureCompression::BC4:
+				DecodeChannelBlock(src, 0, pixels);
+				break;
+			case TextureCompression::BC5:
+				DecodeChannelBlock(src, 0, pixels);
+				DecodeChannelBlock(src + 8, 1, pixels);
+				break;
+			default:
+				break;
+			}
+
+			for (int y = 0; y < 4 && by * 4 + y < height; ++y)
+			{
+				for (int x = 0; x < 4 && bx * 4 + x < width; ++x)
+				{
+					std::memcpy(&output[((size_t)(by * 4 + y) * width + bx * 4 + x) * 4], pixels + (y * 4 + x) * 4, 4);
+				}
+			}
+		}
+	}
+
+	return output;
+}
+
+double TextureCompressor::ComputePSNR(const unsigned char* reference, const unsigned char* decoded, int width, int height,
+	TextureCompression format)
+{
+	int channels = 4;
+	switch (format)
+	{
+	case TextureCompression::BC1: channels = 3; break;
+	case TextureCompression::BC4: channels = 1; break;
+	case TextureCompression::BC5: channels = 2; break;
+	default: break;
+	}
+
+	double squaredError = 0.0;
+	const size_t pixelCount = (size_t)width * height;
+	for (size_t i = 0; i < pixelCount; ++i)
+	{
+		for (int c = 0; c < channels; ++c)
+		{
+			const double diff = (double)reference[i * 4 + c] - decoded[i * 4 + c];
+			squaredError += diff * diff;
+		}
+	}
+
+	const double mse = squaredError / ((double)pixelCount * channels);
+	if (mse <= 0.0)
+	{
+		return std::numeric_limits<double>::infinity();
+	}
+	return 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+unsigned int TextureCompressor::GetBlockSize(TextureCompression format)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:	return 8;
+	case TextureCompression::BC3:	return 16;
+	case TextureCompression::BC4:	return 8;
+	case TextureCompression::BC5:	return 16;
+	default:						return 0;
+	}
+}
+
+unsigned int TextureCompressor::GetCompressedSize(TextureCompression format, int width, int height)
+{
+	return ((width + 3) / 4) * ((height + 3) / 4) * GetBlockSize(format);
+}
+
+unsigned int TextureCompressor::GetGLInternalFormat(TextureCompression format, bool srgb)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:	return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	case TextureCompression::BC3:	return srgb ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+	case TextureCompression::BC4:	return GL_COMPRESSED_RED_RGTC1;
+	case TextureCompression::BC5:	return GL_COMPRESSED_RG_RGTC2;
+	default:						return GL_RGBA8;
+	}
+}
+
+const char* TextureCompressor::GetName(TextureCompression format)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:	return "BC1";
+	case TextureCompression::BC3:	return "BC3";
+	case TextureCompression::BC4:	return "BC4";
+	case TextureCompression::BC5:	return "BC5";
+	default:						return "None";
+	}
+}
+
+bool TextureCompressor::IsSupported(TextureCompression format)
+{
+	switch (format)
+	{
+	case TextureCompression::BC1:
+	case TextureCompression::BC3:
+		return GLEW_EXT_texture_compression_s3tc;
+	case TextureCompression::BC4:
+	case TextureCompression::BC5:
+		return GLEW_VERSION_3_0 || GLEW_ARB_texture_compression_rgtc;
+	default:
+		return true;
+	}
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+enum class TextureCompression
+{
+	None = 0,
+	BC1,	// DXT1, RGB at 4 bits per texel (alpha is dropped)
+	BC3,	// DXT5, RGBA at 8 bits per texel
+	BC4,	// RGTC1, single channel (R) at 4 bits per texel
+	BC5		// RGTC2, two channels (RG) at 8 bits per texel
+};
+
+/**
+ * \brief CPU block encoder for the S3TC/RGTC formats so that textures can be uploaded compressed.
+ * Every 4x4 block is encoded independently, rows of blocks are spread across worker threads (the
+ * JobSystem's when it is running) and the per block search uses SSE2 when it is available.
+ */
+class TextureCompressor
+{
+public:
+	// rows of blocks per job when encoding through the JobSystem
+	static const size_t RowsPerJob = 4;
+
+	/**
+	 * \brief Encodes a tightly packed RGBA8 image
+	 * \param rgba the source pixels, width * height * 4 bytes
+	 * \param threadCount number of worker threads, 0 uses the JobSystem when it is running, every hardware thread
+	 * otherwise
+	 * \return the blocks in row major order, ready for glCompressedTexImage2D
+	 */
+	static std::vector<unsigned char> Compress(const unsigned char* rgba, int width, int height,
+		TextureCompression format, unsigned int threadCount = 0);
+	// Same from 8 bit pixels with 1 to 4 channels, widened to RGBA first
+	static std::vector<unsigned char> CompressPixels(const unsigned char* pixels, int width, int height, int channels,
+		TextureCompression format, unsigned int threadCount = 0);
+
+	// Decodes blocks back to RGBA8 the same way the GPU would, used to measure the encoder quality
+	static std::vector<unsigned char> Decompress(const unsigned char* blocks, int width, int height,
+		TextureCompression format);
+
+	// Peak signal to noise ratio in dB over the channels the format actually stores
+	static double ComputePSNR(const unsigned char* reference, const unsigned char* decoded, int width, int height,
+		TextureCompression format);
+
+	static unsigned int GetBlockSize(TextureCompression format);
+	static unsigned int GetCompressedSize(TextureCompression format, int width, int height);
+	// srgb picks the sRGB variant of BC1/BC3 (EXT_texture_sRGB), BC4/BC5 have none
+	static unsigned int GetGLInternalFormat(TextureCompression format, bool srgb = false);
+	static const char* GetName(TextureCompression format);
+
+	// Needs a current context, BC1/BC3 depend on EXT_texture_compression_s3tc
+	static bool IsSupported(TextureCompression format);
+};
@@ -0,0 +1,277 @@
+#include "TextureResidency.h"
+
+#include "AllocationTracker.h"
+#include "Profiler.h"
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+std::vector<Texture*> TextureResidency::s_Textures;
+std::vector<TextureResidency::PendingLoad> TextureResidency::s_PendingLoads;
+size_t TextureResidency::s_Budget = TextureResidency::DefaultBudget;
+unsigned long long TextureResidency::s_Frame = 1;
+TextureResidencyStats TextureResidency::s_Stats = {};
+
+void TextureResidency::SetBudget(size_t bytes)
+{
+	s_Budget = bytes;
+}
+
+size_t TextureResidency::GetBudget()
+{
+	return s_Budget;
+}
+
+size_t TextureResidency::GetUsage()
+{
+	size_t usage = 0;
+	for (const Texture* texture : s_Textures)
+	{
+		usage += texture->GetSizeInBytes();
+	}
+	return usage;
+}
+
+void TextureResidency::Register(Texture& texture)
+{
+	// a texture created this frame counts as used, it is about to be drawn
+	texture.Touch();
+	s_Textures.push_back(&texture);
+}
+
+void TextureResidency::Unregister(Texture& texture)
+{
+	s_Textures.erase(std::remove(s_Textures.begin(), s_Textures.end(), &texture), s_Textures.end());
+	for (PendingLoad& load : s_PendingLoads)
+	{
+		if (load.Target == &texture)
+		{
+			load.Target = nullptr;
+		}
+	}
+}
+
+bool TextureResidency::IsPending(const Texture* texture)
+{
+	return std::any_of(s_PendingLoads.begin(), s_PendingLoads.end(),
+		[texture](const PendingLoad& load) { return load.Target == texture; });
+}
+
+void TextureResidency::StartLoad(Texture& texture, int level)
+{
+	PendingLoad load;
+	load.Target = &texture;
+	load.Level = level;
+	load.Result = std::async(std::launch::async, texture.CreateLevelLoader(level));
+	s_PendingLoads.push_back(std::move(load));
+}
+
+void TextureResidency::FinishLoads()
+{
+	for (auto it = s_PendingLoads.begin(); it != s_PendingLoads.end();)
+	{
+		if (it->Result.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			++it;
+			continue;
+		}
+		TextureLevelData data = it->Result.get();
+		if (it->Target)
+		{
+			it->Target->UploadLevel(data);
+		}
+		it = s_PendingLoads.erase(it);
+	}
+}
+
+void TextureResidency::Evict(size_t& usage)
+{
+	// textures not drawn this frame go first, least recently used first, straight down to one texel
+	std::vector<Texture*> candidates;
+	for (Texture* texture : s_Textures)
+	{
+		if (texture->IsStreamable() && texture->GetLastUsedFrame() != s_Frame
+			&& texture->GetResidentLevel() < texture->GetLevelCount() - 1 && !IsPending(texture))
+		{
+			candidates.push_back(texture);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b)
+	{
+		return a->GetLastUsedFrame() < b->GetLastUsedFrame();
+	});
+	for (Texture* texture : candidates)
+	{
+		if (usage <= s_Budget)
+		{
+			return;
+		}
+		usage -= texture->GetSizeInBytes();
+		texture->Drop();
+		usage += texture->GetSizeInBytes();
+		++s_Stats.Drops;
+	}
+	if (usage <= s_Budget)
+	{
+		return;
+	}
+
+	// what is on screen doesn't fit either: shed the top mip of the largest textures, a level per frame
+	candidates.clear();
+	for (Texture* texture : s_Textures)
+	{
+		if (texture->IsStreamable() && texture->GetLastUsedFrame() == s_Frame
+			&& texture->GetResidentLevel() < texture->GetLevelCount() - 1 && !IsPending(texture))
+		{
+			candidates.push_back(texture);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [](const Texture* a, const Texture* b)
+	{
+		return a->GetSizeInBytes() > b->GetSizeInBytes();
+	});
+	for (Texture* texture : candidates)
+	{
+		if (usage <= s_Budget || s_PendingLoads.size() >= MaxPendingLoads)
+		{
+			return;
+		}
+		const int level = texture->GetResidentLevel() + 1;
+		usage -= texture->GetSizeInBytes() - texture->GetLevelSizeInBytes(level);
+		StartLoad(*texture, level);
+		++s_Stats.Downgrades;
+	}
+}
+
+void TextureResidency::Restore()
+{
+	// only textures drawn this frame compete for the budget, the others get dropped once it is exceeded
+	size_t usedBytes = 0;
+	std::vector<Texture*> candidates;
+	for (Texture* texture : s_Textures)
+	{
+		if (texture->GetLastUsedFrame() != s_Frame)
+		{
+			continue;
+		}
+		usedBytes += texture->GetSizeInBytes();
+		if (texture->IsStreamable() && texture->GetResidentLevel() > 0 && !IsPending(texture))
+		{
+			candidates.push_back(texture);
+		}
+	}
+	// loads in flight count with the size they are heading to
+	for (const PendingLoad& load : s_PendingLoads)
+	{
+		if (load.Target && load.Target->GetLastUsedFrame() == s_Frame)
+		{
+			usedBytes = usedBytes - load.Target->GetSizeInBytes() + load.Target->GetLevelSizeInBytes(load.Level);
+		}
+	}
+
+	for (Texture* texture : candidates)
+	{
+		if (s_PendingLoads.size() >= MaxPendingLoads)
+		{
+			return;
+		}
+		const size_t others = usedBytes - texture->GetSizeInBytes();
+		for (int level = 0; level < texture->GetResidentLevel(); ++level)
+		{
+			if (others + texture->GetLevelSizeInBytes(level) <= s_Budget)
+			{
+				usedBytes = others + texture->GetLevelSizeInBytes(level);
+				StartLoad(*texture, level);
+				++s_Stats.Restores;
+				break;
+			}
+		}
+	}
+}
+
+void TextureResidency::Update()
+{
+	PROFILE_FUNCTION();
+	ALLOCATION_SCOPE(AllocationTag::Texture);
+	FinishLoads();
+	size_t usage = GetUsage();
+	if (usage > s_Budget)
+	{
+		Evict(usage);
+	}
+	else
+	{
+		Restore();
+	}
+	++s_Frame;
+}
+
+void TextureResidency::OnImGuiRender()
+{
+	const TextureResidencyStats stats = GetStats();
+	const float megabyte = 1024.0f * 1024.0f;
+
+	int budget = (int)(s_Budget / (1024 * 1024));
+	if (ImGui::SliderInt("VRAM budget (MB)", &budget, 1, 2048))
+	{
+		SetBudget((size_t)budget * 1024 * 1024);
+	}
+	char overlay[64];
+	snprintf(overlay, sizeof(overlay), "%.1f / %.1f MB", stats.Usage / megabyte, stats.Budget / megabyte);
+	ImGui::ProgressBar(stats.Budget ? std::min(1.0f, (float)stats.Usage / stats.Budget) : 1.0f, ImVec2(-1.0f, 0.0f), overlay);
+	ImGui::Text("%u textures, %u dropped, %u loads in flight", stats.Textures, stats.DroppedTextures, stats.PendingLoads);
+	ImGui::Text("%u drops, %u downgrades, %u restores", stats.Drops, stats.Downgrades, stats.Restores);
+	if (ImGui::Button("Reset counters"))
+	{
+		ResetStats();
+	}
+
+	if (!ImGui::TreeNode("Textures"))
+	{
+		return;
+	}
+	if (ImGui::BeginTable("Residency", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		ImGui::TableSetupColumn("File");
+		ImGui::TableSetupColumn("Resident");
+		ImGui::TableSetupColumn("Size (KB)");
+		ImGui::TableSetupColumn("Idle frames");
+		ImGui::TableHeadersRow();
+		for (const Texture* texture : s_Textures)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn();
+			ImGui::TextUnformatted(texture->GetFilepath().empty() ? "(memory)" : texture->GetFilepath().c_str());
+			ImGui::TableNextColumn();
+			ImGui::Text("%dx%d (level %d)", texture->GetResidentWidth(), texture->GetResidentHeight(), texture->GetResidentLevel());
+			ImGui::TableNextColumn();
+			ImGui::Text("%.1f", texture->GetSizeInBytes() / 1024.0f);
+			ImGui::TableNextColumn();
+			ImGui::Text("%llu", s_Frame - texture->GetLastUsedFrame());
+		}
+		ImGui::EndTable();
+	}
+	ImGui::TreePop();
+}
+
+void TextureResidency::ResetStats()
+{
+	s_Stats = TextureResidencyStats();
+}
+
+TextureResidencyStats TextureResidency::GetStats()
+{
+	TextureResidencyStats stats = s_Stats;
+	stats.Budget = s_Budget;
+	stats.Usage = GetUsage();
+	stats.Textures = (unsigned int)s_Textures.size();
+	stats.DroppedTextures = (unsigned int)std::count_if(s_Textures.begin(), s_Textures.end(), [](const Texture* texture)
+	{
+		return texture->IsStreamable() && texture->GetResidentWidth() == 1 && texture->GetResidentHeight() == 1
+			&& texture->GetLevelCount() > 1;
+	});
+	stats.PendingLoads = (unsigned int)s_PendingLoads.size();
+	return stats;
+}
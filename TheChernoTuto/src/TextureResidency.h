@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <future>
+#include <vector>
+
+#include "Texture.h"
+
+struct TextureResidencyStats
+{
+	size_t Budget;
+	size_t Usage;
+	unsigned int Textures;
+	unsigned int DroppedTextures;
+	unsigned int PendingLoads;
+	// totals since the last Clear
+	unsigned int Drops;
+	unsigned int Downgrades;
+	unsigned int Restores;
+};
+
+/**
+ * \brief Keeps the video memory taken by file backed textures under a budget. Every texture registers itself
+ * and Bind stamps it with the current frame. When the total goes over the budget, Update first drops the least
+ * recently used textures that weren't drawn this frame down to a single texel, then, if that isn't enough,
+ * downgrades the largest textures still in use one mip level at a time. Textures drawn while below their full
+ * size are streamed back at the finest level that fits, the file being decoded again on a worker thread.
+ */
+class TextureResidency
+{
+public:
+	static const size_t DefaultBudget = 256 * 1024 * 1024;
+	static const unsigned int MaxPendingLoads = 4;
+
+	static void SetBudget(size_t bytes);
+	static size_t GetBudget();
+	static size_t GetUsage();
+
+	static void Register(Texture& texture);
+	static void Unregister(Texture& texture);
+
+	inline static unsigned long long GetFrame()
+	{
+		return s_Frame;
+	}
+
+	// Once per frame after drawing: uploads finished loads, evicts or restores textures, then starts a new frame
+	static void Update();
+	// Budget slider, usage bar and the registered textures, meant to sit inside an open ImGui window
+	static void OnImGuiRender();
+	// Forgets the totals, textures stay registered
+	static void ResetStats();
+
+	static TextureResidencyStats GetStats();
+private:
+	struct PendingLoad
+	{
+		// null once the texture is destroyed, the result is then thrown away
+		Texture* Target;
+		int Level;
+		std::future<TextureLevelData> Result;
+	};
+
+	static bool IsPending(const Texture* texture);
+	static void StartLoad(Texture& texture, int level);
+	static void FinishLoads();
+	static void Evict(size_t& usage);
+	static void Restore();
+
+	static std::vector<Texture*> s_Textures;
+	static std::vector<PendingLoad> s_PendingLoads;
+	static size_t s_Budget;
+	static unsigned long long s_Frame;
+	static TextureResidencyStats s_Stats;
+};
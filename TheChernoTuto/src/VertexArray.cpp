@@ -1,15 +1,39 @@
 #include "VertexArray.h"
+#include "DeletionQueue.h"
 #include "Renderer.h"
 #include "VertexBufferLayout.h"
 
 VertexArray::VertexArray()
 {
 	GlCall(glGenVertexArrays(1, &m_RendererID));
+	m_Handle = ResourcePool::Create(ResourceType::VertexArray, m_RendererID);
 }
 
 VertexArray::~VertexArray()
 {
-	GlCall(glDeleteVertexArrays(1, &m_RendererID));
+	ResourcePool::Destroy(m_Handle);
+	DeletionQueue::DeleteVertexArray(m_RendererID);
+}
+
+VertexArray::VertexArray(VertexArray&& other) noexcept
+	:m_RendererID(other.m_RendererID), m_Handle(other.m_Handle)
+{
+	other.m_RendererID = 0;
+	other.m_Handle = ResourceHandle();
+}
+
+VertexArray& VertexArray::operator=(VertexArray&& other) noexcept
+{
+	if (this != &other)
+	{
+		ResourcePool::Destroy(m_Handle);
+		DeletionQueue::DeleteVertexArray(m_RendererID);
+		m_RendererID = other.m_RendererID;
+		m_Handle = other.m_Handle;
+		other.m_RendererID = 0;
+		other.m_Handle = ResourceHandle();
+	}
+	return *this;
 }
 
 void VertexArray::AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout)
@@ -1,4 +1,5 @@
 #pragma once
+#include "ResourcePool.h"
 #include "VertexBuffer.h"
 
 class VertexBufferLayout;
@@ -7,14 +8,25 @@ class VertexArray
 {
 private:
 	unsigned int m_RendererID;
+	ResourceHandle m_Handle;
 
 public:
 	VertexArray();
 	~VertexArray();
 
+	VertexArray(const VertexArray&) = delete;
+	VertexArray& operator=(const VertexArray&) = delete;
+	VertexArray(VertexArray&& other) noexcept;
+	VertexArray& operator=(VertexArray&& other) noexcept;
+
 	void AddBuffer(const VertexBuffer& vb, const VertexBufferLayout& layout);
 
 	void Bind() const;
 	void Unbind() const;
+
+	inline ResourceHandle GetHandle() const
+	{
+		return m_Handle;
+	}
 };
 
@@ -1,17 +1,68 @@
 ﻿#include "VertexBuffer.h"
+#include "DeletionQueue.h"
 #include "Renderer.h"
 
 VertexBuffer::VertexBuffer(const void* data, unsigned int size)
+	:m_Size(size), m_Usage(GL_STATIC_DRAW)
 {
     // create a vertexBuffer to store our vertices
-    GlCall(glGenBuffers(1, &m_RendererID));
-    GlCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
-    GlCall(glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW));
+    Allocate(data);
+}
+
+VertexBuffer::VertexBuffer(unsigned int size)
+	:m_Size(size), m_Usage(GL_DYNAMIC_DRAW)
+{
+    Allocate(nullptr);
+}
+
+void VertexBuffer::Allocate(const void* data)
+{
+    // a released buffer of the same size only needs its content replaced
+    m_RendererID = DeletionQueue::AcquireBuffer(m_Size, m_Usage);
+    if (m_RendererID != 0)
+    {
+        GlCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+        if (data)
+        {
+            GlCall(glBufferSubData(GL_ARRAY_BUFFER, 0, m_Size, data));
+        }
+    }
+    else
+    {
+        GlCall(glGenBuffers(1, &m_RendererID));
+        GlCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+        GlCall(glBufferData(GL_ARRAY_BUFFER, m_Size, data, m_Usage));
+    }
+    m_Handle = ResourcePool::Create(ResourceType::VertexBuffer, m_RendererID, m_Size);
 }
 
 VertexBuffer::~VertexBuffer()
 {
-    GlCall(glDeleteBuffers(1, &m_RendererID));
+    ResourcePool::Destroy(m_Handle);
+    DeletionQueue::DeleteBuffer(m_RendererID, m_Size, m_Usage);
+}
+
+VertexBuffer::VertexBuffer(VertexBuffer&& other) noexcept
+	:m_RendererID(other.m_RendererID), m_Size(other.m_Size), m_Usage(other.m_Usage), m_Handle(other.m_Handle)
+{
+    other.m_RendererID = 0;
+    other.m_Handle = ResourceHandle();
+}
+
+VertexBuffer& VertexBuffer::operator=(VertexBuffer&& other) noexcept
+{
+    if (this != &other)
+    {
+        ResourcePool::Destroy(m_Handle);
+        DeletionQueue::DeleteBuffer(m_RendererID, m_Size, m_Usage);
+        m_RendererID = other.m_RendererID;
+        m_Size = other.m_Size;
+        m_Usage = other.m_Usage;
+        m_Handle = other.m_Handle;
+        other.m_RendererID = 0;
+        other.m_Handle = ResourceHandle();
+    }
+    return *this;
 }
 
 void VertexBuffer::Bind() const
@@ -19,6 +70,12 @@ void VertexBuffer::Bind() const
     GlCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
 }
 
+void VertexBuffer::SetData(const void* data, unsigned int size, unsigned int offset)
+{
+    GlCall(glBindBuffer(GL_ARRAY_BUFFER, m_RendererID));
+    GlCall(glBufferSubData(GL_ARRAY_BUFFER, offset, size, data));
+}
+
 void VertexBuffer::Unbind() const
 {
     GlCall(glBindBuffer(GL_ARRAY_BUFFER, 0));
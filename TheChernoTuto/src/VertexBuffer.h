@@ -1,13 +1,30 @@
 ﻿#pragma once
+#include "ResourcePool.h"
 
 class VertexBuffer
 {
     private:
         unsigned int m_RendererID;
+        unsigned int m_Size;
+        unsigned int m_Usage;
+        ResourceHandle m_Handle;
+
+        void Allocate(const void* data);
     public:
         VertexBuffer(const void* data, unsigned int size);
+        // Dynamic buffer of size bytes without content, filled every frame with SetData
+        VertexBuffer(unsigned int size);
         ~VertexBuffer();
 
+        VertexBuffer(const VertexBuffer&) = delete;
+        VertexBuffer& operator=(const VertexBuffer&) = delete;
+        VertexBuffer(VertexBuffer&& other) noexcept;
+        VertexBuffer& operator=(VertexBuffer&& other) noexcept;
+
+        void SetData(const void* data, unsigned int size, unsigned int offset = 0);
+
         void Bind() const;
         void Unbind() const;
+
+        inline ResourceHandle GetHandle() const { return m_Handle; }
 };
\ No newline at end of file
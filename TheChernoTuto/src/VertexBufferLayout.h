@@ -61,6 +61,6 @@ public:
 
 	}
 
-	inline std::vector<VertexBufferElement> GetElements() const {return m_elements; }
+	inline const std::vector<VertexBufferElement>& GetElements() const { return m_elements; }
 	inline unsigned int GetStride() const { return m_Stride; }
 };
\ No newline at end of file
@@ -0,0 +1,514 @@
+#include "VirtualTexture.h"
+
+#include "Qoi.h"
+#include "Renderer.h"
+#include "SamplerCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+namespace
+{
+	int NextPowerOfTwo(int value)
+	{
+		int result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	inline int GetKeyLevel(uint64_t key)
+	{
+		return (int)(key >> 48);
+	}
+
+	inline int GetKeyY(uint64_t key)
+	{
+		return (int)((key >> 24) & 0xffffff);
+	}
+
+	inline int GetKeyX(uint64_t key)
+	{
+		return (int)(key & 0xffffff);
+	}
+}
+
+VirtualTexture::VirtualTexture(const std::string& filepath, unsigned int cachePagesPerSide, unsigned int feedbackDivisor)
+	: m_Filepath(filepath), m_Valid(false), m_Header(), m_CachePagesPerSide(cachePagesPerSide), m_PhysicalPageSize(0),
+	m_PhysicalCacheID(0), m_PageTableID(0), m_PageTableWidth(0), m_PageTableHeight(0), m_PageTableDirty(false),
+	m_Frame(0), m_FeedbackDivisor(std::max(feedbackDivisor, 1u)), m_FeedbackFramebuffer(0), m_FeedbackTexture(0),
+	m_FeedbackWidth(0), m_FeedbackHeight(0), m_FeedbackBuffers(), m_FeedbackBufferSizes(), m_FeedbackFrame(0),
+	m_SavedViewport(), m_StopLoader(false), m_Stats()
+{
+	std::ifstream file(filepath, std::ios::binary);
+	file.read((char*)&m_Header, sizeof(m_Header));
+	if (!file || std::memcmp(m_Header.Magic, "VTEX", 4) != 0 || m_Header.Version != VirtualTextureTiler::Version
+		|| m_Header.PageSize == 0)
+	{
+		std::cout << filepath << " isn't a virtual texture page file" << std::endl;
+		return;
+	}
+	m_Levels = VirtualTextureTiler::ComputeLevels(m_Header.Width, m_Header.Height, m_Header.PageSize);
+	if (m_Levels.size() != m_Header.LevelCount || (uint32_t)(m_Levels.back().FirstPage + 1) != m_Header.PageCount)
+	{
+		std::cout << filepath << " has an inconsistent page table" << std::endl;
+		return;
+	}
+	m_Entries.resize(m_Header.PageCount);
+	file.read((char*)m_Entries.data(), m_Entries.size() * sizeof(VirtualTexturePageEntry));
+	if (!file)
+	{
+		return;
+	}
+
+	// page table entries store the slot coordinates on 8 bits
+	int maxTextureSize = 0;
+	GlCall(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize));
+	m_PhysicalPageSize = (int)(m_Header.PageSize + 2 * m_Header.Border);
+	m_CachePagesPerSide = std::min(std::min(m_CachePagesPerSide, (unsigned int)(maxTextureSize / m_PhysicalPageSize)), 255u);
+	m_CachePagesPerSide = std::max(m_CachePagesPerSide, 2u);
+	const int cacheSize = (int)m_CachePagesPerSide * m_PhysicalPageSize;
+
+	GlCall(glGenTextures(1, &m_PhysicalCacheID));
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PhysicalCacheID));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+	GlCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, cacheSize, cacheSize, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr));
+
+	// one texel per page and one mip level per page level, the chain of a power of two texture covers every level
+	m_PageTableWidth = NextPowerOfTwo(m_Levels[0].PagesX);
+	m_PageTableHeight = NextPowerOfTwo(m_Levels[0].PagesY);
+	GlCall(glGenTextures(1, &m_PageTableID));
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (int)m_Levels.size() - 1));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	m_PageTableLevels.resize(m_Levels.size());
+	m_PageSlots.resize(m_Levels.size());
+	for (size_t level = 0; level < m_Levels.size(); ++level)
+	{
+		const int width = std::max(m_PageTableWidth >> level, 1);
+		const int height = std::max(m_PageTableHeight >> level, 1);
+		m_PageTableLevels[level].assign((size_t)width * height * 4, 0);
+		m_PageSlots[level].assign((size_t)m_Levels[level].PagesX * m_Levels[level].PagesY, -1);
+		GlCall(glTexImage2D(GL_TEXTURE_2D, (int)level, GL_RGBA8UI, width, height, 0, GL_RGBA_INTEGER,
+			GL_UNSIGNED_BYTE, m_PageTableLevels[level].data()));
+	}
+	GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	for (unsigned int slot = m_CachePagesPerSide * m_CachePagesPerSide; slot > 0; --slot)
+	{
+		m_FreeSlots.push_back(slot - 1);
+	}
+
+	// the top level is the fallback of every other page, it stays resident and out of the LRU list
+	std::vector<unsigned char> pixels;
+	if (!LoadPage(file, MakeKey((int)m_Levels.size() - 1, 0, 0), pixels))
+	{
+		std::cout << "Failed to load the top level of " << filepath << std::endl;
+		return;
+	}
+	const unsigned int topSlot = m_FreeSlots.back();
+	m_FreeSlots.pop_back();
+	UploadPage(topSlot, pixels);
+	m_PageSlots.back()[0] = (int)topSlot;
+	UpdatePageTable();
+
+	GlCall(glGenBuffers(FeedbackBufferCount, m_FeedbackBuffers));
+	m_Shader.reset(new Shader("res/shaders/VirtualTexture.shader"));
+	m_FeedbackShader.reset(new Shader("res/shaders/VirtualTextureFeedback.shader"));
+
+	m_Loader = std::thread(&VirtualTexture::LoaderThread, this);
+	m_Valid = true;
+}
+
+VirtualTexture::~VirtualTexture()
+{
+	if (m_Loader.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_LoaderMutex);
+			m_StopLoader = true;
+		}
+		m_LoaderCondition.notify_all();
+		m_Loader.join();
+	}
+
+	GlCall(glDeleteTextures(1, &m_PhysicalCacheID));
+	GlCall(glDeleteTextures(1, &m_PageTableID));
+	GlCall(glDeleteTextures(1, &m_FeedbackTexture));
+	GlCall(glDeleteFramebuffers(1, &m_FeedbackFramebuffer));
+	GlCall(glDeleteBuffers(FeedbackBufferCount, m_FeedbackBuffers));
+}
+
+uint64_t VirtualTexture::MakeKey(int level, int x, int y)
+{
+	return ((uint64_t)level << 48) | ((uint64_t)y << 24) | (uint64_t)x;
+}
+
+bool VirtualTexture::LoadPage(std::ifstream& file, uint64_t key, std::vector<unsigned char>& pixels) const
+{
+	const VirtualTextureLevel& level = m_Levels[GetKeyLevel(key)];
+	const VirtualTexturePageEntry& entry = m_Entries[level.FirstPage + GetKeyY(key) * level.PagesX + GetKeyX(key)];
+
+	std::vector<unsigned char> encoded(entry.Size);
+	file.clear();
+	file.seekg((std::streamoff)entry.Offset);
+	file.read((char*)encoded.data(), encoded.size());
+	if (!file)
+	{
+		return false;
+	}
+
+	int width, height, channels;
+	unsigned char* decoded = Qoi::LoadFromMemory(encoded.data(), encoded.size(), &width, &height, &channels, 4);
+	if (!decoded || width != m_PhysicalPageSize || height != m_PhysicalPageSize)
+	{
+		Qoi::Free(decoded);
+		return false;
+	}
+	pixels.assign(decoded, decoded + (size_t)width * height * 4);
+	Qoi::Free(decoded);
+	return true;
+}
+
+void VirtualTexture::LoaderThread()
+{
+	std::ifstream file(m_Filepath, std::ios::binary);
+	while (true)
+	{
+		uint64_t key;
+		{
+			std::unique_lock<std::mutex> lock(m_LoaderMutex);
+			m_LoaderCondition.wait(lock, [this]() { return m_StopLoader || !m_LoadQueue.empty(); });
+			if (m_StopLoader)
+			{
+				return;
+			}
+			key = m_LoadQueue.front();
+			m_LoadQueue.pop_front();
+		}
+
+		LoadedPage page;
+		page.Key = key;
+		if (!LoadPage(file, key, page.Pixels))
+		{
+			page.Pixels.clear();
+		}
+
+		std::lock_guard<std::mutex> lock(m_LoaderMutex);
+		m_LoadedPages.push_back(std::move(page));
+	}
+}
+
+Shader& VirtualTexture::BeginFeedback(const glm::mat4& mvp)
+{
+	GlCall(glGetIntegerv(GL_VIEWPORT, m_SavedViewport));
+	const int width = std::max(m_SavedViewport[2] / (int)m_FeedbackDivisor, 1);
+	const int height = std::max(m_SavedViewport[3] / (int)m_FeedbackDivisor, 1);
+	if (width != m_FeedbackWidth || height != m_FeedbackHeight)
+	{
+		CreateFeedbackTarget(width, height);
+	}
+
+	GlCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFramebuffer));
+	GlCall(glViewport(0, 0, width, height));
+	const unsigned int empty[4] = { 0, 0, 0, 0 };
+	GlCall(glClearBufferuiv(GL_COLOR, 0, empty));
+
+	m_FeedbackShader->Bind();
+	m_FeedbackShader->SetUniformMat4f("u_MVP", mvp);
+	m_FeedbackShader->SetUniform2f("u_ImageSize", (float)m_Header.Width, (float)m_Header.Height);
+	m_FeedbackShader->SetUniform1f("u_PageSize", (float)m_Header.PageSize);
+	m_FeedbackShader->SetUniform1i("u_MaxLevel", (int)m_Levels.size() - 1);
+	// derivatives are feedbackDivisor times larger than on screen
+	m_FeedbackShader->SetUniform1f("u_LodBias", -std::log2((float)m_FeedbackDivisor));
+	return *m_FeedbackShader;
+}
+
+void VirtualTexture::EndFeedback()
+{
+	// read into a pixel buffer now, ReadFeedback maps it FeedbackLatency passes later once the GPU is done with it
+	const unsigned int index = m_FeedbackFrame % FeedbackBufferCount;
+	GlCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackBuffers[index]));
+	if (m_FeedbackBufferSizes[index][0] != m_FeedbackWidth || m_FeedbackBufferSizes[index][1] != m_FeedbackHeight)
+	{
+		GlCall(glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)m_FeedbackWidth * m_FeedbackHeight * 8, nullptr, GL_STREAM_READ));
+	}
+	GlCall(glReadBuffer(GL_COLOR_ATTACHMENT0));
+	GlCall(glReadPixels(0, 0, m_FeedbackWidth, m_FeedbackHeight, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr));
+	GlCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	m_FeedbackBufferSizes[index][0] = m_FeedbackWidth;
+	m_FeedbackBufferSizes[index][1] = m_FeedbackHeight;
+	++m_FeedbackFrame;
+
+	GlCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+	GlCall(glViewport(m_SavedViewport[0], m_SavedViewport[1], m_SavedViewport[2], m_SavedViewport[3]));
+}
+
+void VirtualTexture::CreateFeedbackTarget(int width, int height)
+{
+	if (!m_FeedbackFramebuffer)
+	{
+		GlCall(glGenFramebuffers(1, &m_FeedbackFramebuffer));
+		GlCall(glGenTextures(1, &m_FeedbackTexture));
+	}
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_FeedbackTexture));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+	GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+	GlCall(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA16UI, width, height, 0, GL_RGBA_INTEGER, GL_UNSIGNED_SHORT, nullptr));
+	GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+
+	GlCall(glBindFramebuffer(GL_FRAMEBUFFER, m_FeedbackFramebuffer));
+	GlCall(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, m_FeedbackTexture, 0));
+	GlCall(unsigned int status = glCheckFramebufferStatus(GL_FRAMEBUFFER));
+	ASSERT(status == GL_FRAMEBUFFER_COMPLETE);
+	GlCall(glBindFramebuffer(GL_FRAMEBUFFER, 0));
+
+	m_FeedbackWidth = width;
+	m_FeedbackHeight = height;
+}
+
+void VirtualTexture::ReadFeedback(std::vector<uint64_t>& requested)
+{
+	// the readback that has FeedbackLatency more passes queued behind it, the newer ones are left to the GPU
+	if (m_FeedbackFrame <= FeedbackLatency)
+	{
+		return;
+	}
+	const unsigned int index = (m_FeedbackFrame - 1 - FeedbackLatency) % FeedbackBufferCount;
+	const int width = m_FeedbackBufferSizes[index][0], height = m_FeedbackBufferSizes[index][1];
+	if (width == 0 || height == 0)
+	{
+		return;
+	}
+
+	GlCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, m_FeedbackBuffers[index]));
+	GlCall(const unsigned short* texels = (const unsigned short*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0,
+		(size_t)width * height * 8, GL_MAP_READ_BIT));
+	if (texels)
+	{
+		std::unordered_set<uint64_t> seen;
+		for (size_t i = 0; i < (size_t)width * height; ++i)
+		{
+			const unsigned short* texel = texels + i * 4;
+			if (texel[3] == 0 || texel[2] >= m_Levels.size())
+			{
+				continue;
+			}
+			// every ancestor is wanted too, they are the fallback while the page itself streams in
+			int x = texel[0], y = texel[1];
+			for (int level = texel[2]; level < (int)m_Levels.size(); ++level, x /= 2, y /= 2)
+			{
+				if (x >= m_Levels[level].PagesX || y >= m_Levels[level].PagesY || !seen.insert(MakeKey(level, x, y)).second)
+				{
+					break;
+				}
+				requested.push_back(MakeKey(level, x, y));
+			}
+		}
+		GlCall(glUnmapBuffer(GL_PIXEL_PACK_BUFFER));
+	}
+	GlCall(glBindBuffer(GL_PIXEL_PACK_BUFFER, 0));
+	m_FeedbackBufferSizes[index][0] = 0;
+	m_FeedbackBufferSizes[index][1] = 0;
+}
+
+void VirtualTexture::Update(unsigned int maxUploads)
+{
+	if (!m_Valid)
+	{
+		return;
+	}
+	++m_Frame;
+
+	std::vector<uint64_t> requested;
+	ReadFeedback(requested);
+	if (!requested.empty())
+	{
+		std::vector<uint64_t> missing;
+		for (uint64_t key : requested)
+		{
+			const int level = GetKeyLevel(key);
+			if (m_PageSlots[level][GetKeyY(key) * m_Levels[level].PagesX + GetKeyX(key)] < 0)
+			{
+				missing.push_back(key);
+				continue;
+			}
+			auto it = m_Resident.find(key);
+			if (it != m_Resident.end())
+			{
+				it->second->LastUsedFrame = m_Frame;
+				m_LruPages.splice(m_LruPages.begin(), m_LruPages, it->second);
+			}
+		}
+		// coarse pages first, they replace the blurriest fallbacks
+		std::stable_sort(missing.begin(), missing.end(), [](uint64_t a, uint64_t b)
+		{
+			return GetKeyLevel(a) > GetKeyLevel(b);
+		});
+
+		{
+			// requests nobody picked up yet are replaced by what the view needs now
+			std::lock_guard<std::mutex> lock(m_LoaderMutex);
+			for (uint64_t key : m_LoadQueue)
+			{
+				m_Pending.erase(key);
+			}
+			m_LoadQueue.clear();
+			for (uint64_t key : missing)
+			{
+				if (m_Pending.insert(key).second)
+				{
+					m_LoadQueue.push_back(key);
+				}
+			}
+		}
+		m_LoaderCondition.notify_one();
+		m_Stats.RequestedPages = (unsigned int)requested.size();
+	}
+
+	std::vector<LoadedPage> loaded;
+	{
+		std::lock_guard<std::mutex> lock(m_LoaderMutex);
+		const size_t count = std::min((size_t)maxUploads, m_LoadedPages.size());
+		std::move(m_LoadedPages.begin(), m_LoadedPages.begin() + count, std::back_inserter(loaded));
+		m_LoadedPages.erase(m_LoadedPages.begin(), m_LoadedPages.begin() + count);
+	}
+
+	m_Stats.UploadsLastUpdate = 0;
+	for (const LoadedPage& page : loaded)
+	{
+		m_Pending.erase(page.Key);
+		if (page.Pixels.empty())
+		{
+			continue;
+		}
+
+		unsigned int slot;
+		if (!m_FreeSlots.empty())
+		{
+			slot = m_FreeSlots.back();
+			m_FreeSlots.pop_back();
+		}
+		else
+		{
+			// a cache full of pages the view uses right now can't take more, the page is asked for again later
+			const ResidentPage& victim = m_LruPages.back();
+			if (victim.LastUsedFrame == m_Frame)
+			{
+				++m_Stats.DroppedLoads;
+				continue;
+			}
+			const int level = GetKeyLevel(victim.Key);
+			m_PageSlots[level][GetKeyY(victim.Key) * m_Levels[level].PagesX + GetKeyX(victim.Key)] = -1;
+			m_Resident.erase(victim.Key);
+			slot = victim.Slot;
+			m_LruPages.pop_back();
+			++m_Stats.Evictions;
+		}
+
+		UploadPage(slot, page.Pixels);
+		const int level = GetKeyLevel(page.Key);
+		m_PageSlots[level][GetKeyY(page.Key) * m_Levels[level].PagesX + GetKeyX(page.Key)] = (int)slot;
+		m_LruPages.push_front({ page.Key, slot, m_Frame });
+		m_Resident[page.Key] = m_LruPages.begin();
+		m_PageTableDirty = true;
+		++m_Stats.UploadsLastUpdate;
+	}
+
+	if (m_PageTableDirty)
+	{
+		UpdatePageTable();
+	}
+}
+
+void VirtualTexture::UploadPage(unsigned int slot, const std::vector<unsigned char>& pixels)
+{
+	const int x = (int)(slot % m_CachePagesPerSide) * m_PhysicalPageSize;
+	const int y = (int)(slot / m_CachePagesPerSide) * m_PhysicalPageSize;
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PhysicalCacheID));
+	GlCall(glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, m_PhysicalPageSize, m_PhysicalPageSize, GL_RGBA, GL_UNSIGNED_BYTE,
+		pixels.data()));
+	GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+}
+
+void VirtualTexture::UpdatePageTable()
+{
+	// from the top down so a missing page can copy the entry its parent already resolved
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	for (int level = (int)m_Levels.size() - 1; level >= 0; --level)
+	{
+		const VirtualTextureLevel& info = m_Levels[level];
+		const int width = std::max(m_PageTableWidth >> level, 1);
+		const int height = std::max(m_PageTableHeight >> level, 1);
+		std::vector<unsigned char>& entries = m_PageTableLevels[level];
+		for (int y = 0; y < info.PagesY; ++y)
+		{
+			for (int x = 0; x < info.PagesX; ++x)
+			{
+				unsigned char* entry = &entries[((size_t)y * width + x) * 4];
+				const int slot = m_PageSlots[level][y * info.PagesX + x];
+				if (slot >= 0)
+				{
+					entry[0] = (unsigned char)(slot % m_CachePagesPerSide);
+					entry[1] = (unsigned char)(slot / m_CachePagesPerSide);
+					entry[2] = (unsigned char)level;
+					entry[3] = 1;
+				}
+				else
+				{
+					const int parentWidth = std::max(m_PageTableWidth >> (level + 1), 1);
+					std::memcpy(entry, &m_PageTableLevels[level + 1][((size_t)(y / 2) * parentWidth + x / 2) * 4], 4);
+				}
+			}
+		}
+		GlCall(glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, GL_RGBA_INTEGER, GL_UNSIGNED_BYTE,
+			entries.data()));
+	}
+	GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+	m_PageTableDirty = false;
+}
+
+Shader& VirtualTexture::Bind(const glm::mat4& mvp, unsigned int firstSlot)
+{
+	// integer textures can't be filtered, the page table relies on its own nearest parameters
+	GlCall(glActiveTexture(GL_TEXTURE0 + firstSlot));
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PageTableID));
+	SamplerCache::Unbind(firstSlot);
+	GlCall(glActiveTexture(GL_TEXTURE0 + firstSlot + 1));
+	GlCall(glBindTexture(GL_TEXTURE_2D, m_PhysicalCacheID));
+	SamplerCache::Bind(firstSlot + 1, SamplerState());
+
+	m_Shader->Bind();
+	m_Shader->SetUniformMat4f("u_MVP", mvp);
+	m_Shader->SetUniform1i("u_PageTable", (int)firstSlot);
+	m_Shader->SetUniform1i("u_PhysicalCache", (int)firstSlot + 1);
+	m_Shader->SetUniform2f("u_ImageSize", (float)m_Header.Width, (float)m_Header.Height);
+	m_Shader->SetUniform1f("u_PageSize", (float)m_Header.PageSize);
+	m_Shader->SetUniform1f("u_Border", (float)m_Header.Border);
+	m_Shader->SetUniform1f("u_CacheSize", (float)(m_CachePagesPerSide * m_PhysicalPageSize));
+	m_Shader->SetUniform1i("u_MaxLevel", (int)m_Levels.size() - 1);
+	return *m_Shader;
+}
+
+VirtualTextureStats VirtualTexture::GetStats() const
+{
+	VirtualTextureStats stats = m_Stats;
+	stats.ResidentPages = (unsigned int)m_Resident.size() + (m_Valid ? 1 : 0);
+	stats.CachePages = m_CachePagesPerSide * m_CachePagesPerSide;
+	stats.PendingLoads = (unsigned int)m_Pending.size();
+	stats.PhysicalCacheBytes = (size_t)stats.CachePages * m_PhysicalPageSize * m_PhysicalPageSize * 4;
+	stats.PageTableBytes = 0;
+	for (const auto& level : m_PageTableLevels)
+	{
+		stats.PageTableBytes += level.size();
+	}
+	return stats;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "Shader.h"
+#include "VirtualTextureTiler.h"
+
+struct VirtualTextureStats
+{
+	unsigned int ResidentPages;
+	unsigned int CachePages;
+	unsigned int RequestedPages;
+	unsigned int PendingLoads;
+	unsigned int UploadsLastUpdate;
+	unsigned int Evictions;
+	unsigned int DroppedLoads;
+	size_t PhysicalCacheBytes;
+	size_t PageTableBytes;
+};
+
+/**
+ * \brief Displays images of any size by keeping only the pages the view needs in a fixed size physical cache.
+ *
+ * Each frame the geometry is first drawn into a small feedback target (BeginFeedback / EndFeedback) that
+ * records which page of which mip level every pixel wants. That buffer is read back asynchronously and mapped
+ * by Update two frames later (FeedbackLatency) once the GPU is done with it, which asks the loader thread for
+ * the missing pages (coarsest first), uploads the pages that finished loading into the least recently used
+ * cache slots and refreshes the page table. The page table maps every page of every level to its cache slot, or
+ * to the slot of its closest resident ancestor, so the image is always drawn, just blurrier while finer pages
+ * stream in. The single page of the top level is loaded up front and never evicted.
+ */
+class VirtualTexture
+{
+public:
+	/**
+	 * \param filepath page file written by VirtualTextureTiler
+	 * \param cachePagesPerSide the physical cache holds cachePagesPerSide squared pages
+	 * \param feedbackDivisor the feedback pass runs at viewport size / feedbackDivisor
+	 */
+	VirtualTexture(const std::string& filepath, unsigned int cachePagesPerSide = 16, unsigned int feedbackDivisor = 8);
+	~VirtualTexture();
+
+	inline bool IsValid() const
+	{
+		return m_Valid;
+	}
+
+	// Binds the feedback target and returns the shader to draw the textured geometry with
+	Shader& BeginFeedback(const glm::mat4& mvp);
+	void EndFeedback();
+
+	// Consumes the oldest feedback readback and finished loads, uploads at most maxUploads pages
+	void Update(unsigned int maxUploads = 32);
+
+	// Binds the page table and the physical cache to firstSlot and firstSlot + 1 and returns the drawing shader
+	Shader& Bind(const glm::mat4& mvp, unsigned int firstSlot = 0);
+
+	VirtualTextureStats GetStats() const;
+
+	inline int GetWidth() const
+	{
+		return (int)m_Header.Width;
+	}
+
+	inline int GetHeight() const
+	{
+		return (int)m_Header.Height;
+	}
+
+	inline unsigned int GetPhysicalCacheID() const
+	{
+		return m_PhysicalCacheID;
+	}
+private:
+	struct ResidentPage
+	{
+		uint64_t Key;
+		unsigned int Slot;
+		unsigned long long LastUsedFrame;
+	};
+
+	struct LoadedPage
+	{
+		uint64_t Key;
+		std::vector<unsigned char> Pixels;
+	};
+
+	static uint64_t MakeKey(int level, int x, int y);
+	bool LoadPage(std::ifstream& file, uint64_t key, std::vector<unsigned char>& pixels) const;
+	void LoaderThread();
+
+	void CreateFeedbackTarget(int width, int height);
+	void ReadFeedback(std::vector<uint64_t>& requested);
+	void UploadPage(unsigned int slot, const std::vector<unsigned char>& pixels);
+	void UpdatePageTable();
+
+	std::string m_Filepath;
+	bool m_Valid;
+	VirtualTexturePageFileHeader m_Header;
+	std::vector<VirtualTexturePageEntry> m_Entries;
+	std::vector<VirtualTextureLevel> m_Levels;
+
+	unsigned int m_CachePagesPerSide;
+	int m_PhysicalPageSize;
+	unsigned int m_PhysicalCacheID;
+	unsigned int m_PageTableID;
+	int m_PageTableWidth, m_PageTableHeight;
+	// cache slot of every page of every level, -1 when not resident
+	std::vector<std::vector<int>> m_PageSlots;
+	std::vector<std::vector<unsigned char>> m_PageTableLevels;
+	bool m_PageTableDirty;
+
+	std::list<ResidentPage> m_LruPages;
+	std::unordered_map<uint64_t, std::list<ResidentPage>::iterator> m_Resident;
+	std::vector<unsigned int> m_FreeSlots;
+	unsigned long long m_Frame;
+
+	unsigned int m_FeedbackDivisor;
+	unsigned int m_FeedbackFramebuffer;
+	unsigned int m_FeedbackTexture;
+	int m_FeedbackWidth, m_FeedbackHeight;
+	// pixel buffers the readbacks land in, one per feedback pass still in flight plus the one being written
+	static const unsigned int FeedbackLatency = 2;
+	static const unsigned int FeedbackBufferCount = FeedbackLatency + 1;
+	unsigned int m_FeedbackBuffers[FeedbackBufferCount];
+	int m_FeedbackBufferSizes[FeedbackBufferCount][2];
+	// feedback passes ended so far
+	unsigned int m_FeedbackFrame;
+	int m_SavedViewport[4];
+
+	std::unique_ptr<Shader> m_Shader;
+	std::unique_ptr<Shader> m_FeedbackShader;
+
+	// shared with the loader thread
+	std::thread m_Loader;
+	std::mutex m_LoaderMutex;
+	std::condition_variable m_LoaderCondition;
+	std::deque<uint64_t> m_LoadQueue;
+	std::vector<LoadedPage> m_LoadedPages;
+	bool m_StopLoader;
+	// queued, being loaded or loaded but not uploaded yet, main thread only
+	std::unordered_set<uint64_t> m_Pending;
+
+	VirtualTextureStats m_Stats;
+};
@@ -0,0 +1,226 @@
+#include "VirtualTextureTiler.h"
+
+#include "ImageDecoder.h"
+#include "Qoi.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	class PyramidWriter
+	{
+	public:
+		PyramidWriter(std::ofstream& file, const std::vector<VirtualTextureLevel>& levels,
+			const VirtualTextureTilerSettings& settings, std::vector<VirtualTexturePageEntry>& entries)
+			: m_File(file), m_Levels(levels), m_Settings(settings), m_Entries(entries), m_States(levels.size()),
+			m_PagePixels((size_t)(settings.PageSize + 2 * settings.Border) * (settings.PageSize + 2 * settings.Border) * 4),
+			m_Failed(false)
+		{
+		}
+
+		/**
+		 * \brief Appends the next row of a level. Page bands are written as soon as their last border row
+		 * arrived, and every pair of rows is averaged into the next level.
+		 */
+		void AddRow(size_t level, std::vector<unsigned char>&& row)
+		{
+			const VirtualTextureLevel& info = m_Levels[level];
+			LevelState& state = m_States[level];
+			const int y = state.FirstRow + (int)state.Rows.size();
+			state.Rows.push_back(std::move(row));
+
+			const int pageSize = m_Settings.PageSize, border = m_Settings.Border;
+			while (state.NextBand < info.PagesY
+				&& y >= std::min((state.NextBand + 1) * pageSize + border - 1, info.Height - 1))
+			{
+				WriteBand(level, state.NextBand++);
+				while (state.FirstRow < state.NextBand * pageSize - border && state.Rows.size() > 1)
+				{
+					// rows still needed for downsampling live in Pending, not here
+					state.Rows.pop_front();
+					++state.FirstRow;
+				}
+			}
+
+			if (level + 1 == m_Levels.size())
+			{
+				return;
+			}
+			const std::vector<unsigned char>& current = state.Rows.back();
+			if (y % 2 == 0 && y != info.Height - 1)
+			{
+				state.Pending = current;
+				return;
+			}
+			const std::vector<unsigned char>& below = y % 2 == 0 ? current : state.Pending;
+			AddRow(level + 1, Downsample(below, current, info.Width));
+		}
+
+		inline bool Failed() const
+		{
+			return m_Failed;
+		}
+	private:
+		struct LevelState
+		{
+			std::deque<std::vector<unsigned char>> Rows;
+			int FirstRow = 0;
+			int NextBand = 0;
+			std::vector<unsigned char> Pending;
+		};
+
+		// 2x2 box filter, the last column / row is repeated for odd sizes
+		static std::vector<unsigned char> Downsample(const std::vector<unsigned char>& below,
+			const std::vector<unsigned char>& above, int width)
+		{
+			const int half = (width + 1) / 2;
+			std::vector<unsigned char> row((size_t)half * 4);
+			for (int x = 0; x < half; ++x)
+			{
+				const int x0 = x * 2, x1 = std::min(x * 2 + 1, width - 1);
+				for (int c = 0; c < 4; ++c)
+				{
+					const int sum = below[x0 * 4 + c] + below[x1 * 4 + c] + above[x0 * 4 + c] + above[x1 * 4 + c];
+					row[x * 4 + c] = (unsigned char)((sum + 2) / 4);
+				}
+			}
+			return row;
+		}
+
+		void WriteBand(size_t level, int band)
+		{
+			const VirtualTextureLevel& info = m_Levels[level];
+			const LevelState& state = m_States[level];
+			const int pageSize = m_Settings.PageSize, border = m_Settings.Border;
+			const int side = pageSize + 2 * border;
+
+			std::vector<unsigned char> pixels(m_PagePixels);
+			std::vector<unsigned char> encoded;
+			for (int px = 0; px < info.PagesX; ++px)
+			{
+				for (int j = 0; j < side; ++j)
+				{
+					const int y = std::min(std::max(band * pageSize - border + j, 0), info.Height - 1);
+					const unsigned char* src = state.Rows[y - state.FirstRow].data();
+					unsigned char* dst = &pixels[(size_t)j * side * 4];
+					for (int i = 0; i < side; ++i)
+					{
+						const int x = std::min(std::max(px * pageSize - border + i, 0), info.Width - 1);
+						std::memcpy(dst + i * 4, src + x * 4, 4);
+					}
+				}
+
+				encoded.clear();
+				Qoi::Encode(pixels.data(), side, side, 4, encoded);
+				VirtualTexturePageEntry& entry = m_Entries[info.FirstPage + band * info.PagesX + px];
+				entry.Offset = (uint64_t)m_File.tellp();
+				entry.Size = (uint32_t)encoded.size();
+				m_File.write((const char*)encoded.data(), encoded.size());
+				m_Failed |= !m_File;
+			}
+		}
+
+		std::ofstream& m_File;
+		const std::vector<VirtualTextureLevel>& m_Levels;
+		const VirtualTextureTilerSettings& m_Settings;
+		std::vector<VirtualTexturePageEntry>& m_Entries;
+		std::vector<LevelState> m_States;
+		size_t m_PagePixels;
+		bool m_Failed;
+	};
+}
+
+std::vector<VirtualTextureLevel> VirtualTextureTiler::ComputeLevels(int width, int height, int pageSize)
+{
+	std::vector<VirtualTextureLevel> levels;
+	int firstPage = 0;
+	while (true)
+	{
+		VirtualTextureLevel level;
+		level.Width = width;
+		level.Height = height;
+		level.PagesX = (width + pageSize - 1) / pageSize;
+		level.PagesY = (height + pageSize - 1) / pageSize;
+		level.FirstPage = firstPage;
+		levels.push_back(level);
+		firstPage += level.PagesX * level.PagesY;
+		if (level.PagesX == 1 && level.PagesY == 1)
+		{
+			return levels;
+		}
+		width = (width + 1) / 2;
+		height = (height + 1) / 2;
+	}
+}
+
+bool VirtualTextureTiler::Build(const std::string& destination, int width, int height, const RowSource& source,
+	const VirtualTextureTilerSettings& settings)
+{
+	if (width <= 0 || height <= 0 || settings.PageSize <= 0 || settings.Border < 0)
+	{
+		return false;
+	}
+
+	std::ofstream file(destination, std::ios::binary);
+	if (!file)
+	{
+		std::cout << "Failed to create " << destination << std::endl;
+		return false;
+	}
+
+	const std::vector<VirtualTextureLevel> levels = ComputeLevels(width, height, settings.PageSize);
+	VirtualTexturePageFileHeader header = {};
+	std::memcpy(header.Magic, "VTEX", 4);
+	header.Version = Version;
+	header.Width = (uint32_t)width;
+	header.Height = (uint32_t)height;
+	header.PageSize = (uint32_t)settings.PageSize;
+	header.Border = (uint32_t)settings.Border;
+	header.LevelCount = (uint32_t)levels.size();
+	header.PageCount = (uint32_t)(levels.back().FirstPage + 1);
+
+	// the page table is only known at the end, reserve its space and come back for it
+	std::vector<VirtualTexturePageEntry> entries(header.PageCount);
+	file.write((const char*)&header, sizeof(header));
+	file.write((const char*)entries.data(), entries.size() * sizeof(VirtualTexturePageEntry));
+
+	PyramidWriter writer(file, levels, settings, entries);
+	for (int y = 0; y < height; ++y)
+	{
+		std::vector<unsigned char> row((size_t)width * 4);
+		source(y, row.data());
+		writer.AddRow(0, std::move(row));
+	}
+
+	file.seekp(sizeof(header));
+	file.write((const char*)entries.data(), entries.size() * sizeof(VirtualTexturePageEntry));
+	if (writer.Failed() || !file)
+	{
+		std::cout << "Failed to write " << destination << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool VirtualTextureTiler::BuildFromFile(const std::string& source, const std::string& destination,
+	const VirtualTextureTilerSettings& settings)
+{
+	int width, height, channels;
+	unsigned char* pixels = ImageDecoder::Load(source, &width, &height, &channels, 4, true);
+	if (!pixels)
+	{
+		std::cout << "Failed to load " << source << std::endl;
+		return false;
+	}
+
+	const bool built = Build(destination, width, height, [&](int row, unsigned char* rgba)
+	{
+		std::memcpy(rgba, pixels + (size_t)row * width * 4, (size_t)width * 4);
+	}, settings);
+	ImageDecoder::Free(pixels);
+	return built;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Page file layout: a VirtualTexturePageFileHeader, then one VirtualTexturePageEntry per page (level 0 first,
+ * pages row by row from the bottom left), then the pages themselves. Every page is a QOI encoded RGBA image
+ * of (PageSize + 2 * Border) pixels per side, the border repeats the neighbouring pixels so bilinear filtering
+ * inside the physical cache never reads another page.
+ */
+struct VirtualTexturePageFileHeader
+{
+	char Magic[4];
+	uint32_t Version;
+	uint32_t Width, Height;
+	uint32_t PageSize, Border;
+	uint32_t LevelCount;
+	uint32_t PageCount;
+};
+
+struct VirtualTexturePageEntry
+{
+	uint64_t Offset;
+	uint32_t Size;
+	uint32_t Reserved;
+};
+
+struct VirtualTextureLevel
+{
+	int Width, Height;
+	int PagesX, PagesY;
+	// index of the level's first page in the page table of the file
+	int FirstPage;
+};
+
+struct VirtualTextureTilerSettings
+{
+	int PageSize = 128;
+	int Border = 4;
+};
+
+/**
+ * \brief Offline conversion of an image into a virtual texture page file. Rows are consumed bottom up one at
+ * a time and every mip level only keeps the rows of the page band it is filling, so memory stays in the tens of
+ * megabytes even for images far larger than GL_MAX_TEXTURE_SIZE.
+ */
+class VirtualTextureTiler
+{
+public:
+	static const uint32_t Version = 1;
+
+	// Fills one row of RGBA8 pixels, row 0 being the bottom of the image
+	using RowSource = std::function<void(int row, unsigned char* rgba)>;
+
+	// Mip levels down to the first one that fits in a single page
+	static std::vector<VirtualTextureLevel> ComputeLevels(int width, int height, int pageSize);
+
+	static bool Build(const std::string& destination, int width, int height, const RowSource& source,
+		const VirtualTextureTilerSettings& settings = VirtualTextureTilerSettings());
+	// The source file has to be decodable in one go (stb_image / ImageDecoder), the tiling itself is streamed
+	static bool BuildFromFile(const std::string& source, const std::string& destination,
+		const VirtualTextureTilerSettings& settings = VirtualTextureTilerSettings());
+};
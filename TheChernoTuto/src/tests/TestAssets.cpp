@@ -0,0 +1,101 @@
+#include "TestAssets.h"
+#include "AssetManager.h"
+#include "imgui/imgui.h"
+
+#include <chrono>
+#include <string>
+#include <unordered_set>
+
+namespace
+{
+	// one file, three ways to name it
+	const char* Filepaths[] = {
+		"res/textures/proteccTerra.png",
+		"./res/textures/proteccTerra.png",
+		"res/shaders/../textures//proteccTerra.png"
+	};
+	const int FilepathCount = sizeof(Filepaths) / sizeof(Filepaths[0]);
+}
+
+test::TestAssets::TestAssets()
+	: m_Textures(std::make_shared<TextureList>()), m_RequestCount(100), m_RequestMilliseconds(0.0)
+{
+}
+
+void test::TestAssets::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderInt("Requests", &m_RequestCount, 1, 1000);
+
+	if (ImGui::Button("Request (sync)"))
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < m_RequestCount; ++i)
+		{
+			m_Textures->push_back(AssetManager::LoadTexture(Filepaths[i % FilepathCount], TextureCompression::None,
+				TextureUsage::Color));
+		}
+		m_RequestMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Request (async)"))
+	{
+		const std::weak_ptr<TextureList> textures = m_Textures;
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < m_RequestCount; ++i)
+		{
+			AssetManager::LoadTextureAsync(Filepaths[i % FilepathCount], TextureCompression::None, TextureUsage::Color,
+				[textures](const std::shared_ptr<Texture>& texture)
+				{
+					if (std::shared_ptr<TextureList> list = textures.lock())
+					{
+						list->push_back(texture);
+					}
+				});
+		}
+		m_RequestMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Request (batched)"))
+	{
+		const std::weak_ptr<TextureList> textures = m_Textures;
+		const auto start = std::chrono::high_resolution_clock::now();
+		std::vector<std::string> filepaths;
+		for (int i = 0; i < m_RequestCount; ++i)
+		{
+			filepaths.push_back(Filepaths[i % FilepathCount]);
+		}
+		AssetManager::LoadTexturesAsync(filepaths, TextureCompression::None, TextureUsage::Color,
+			[textures](const std::shared_ptr<Texture>& texture)
+			{
+				if (std::shared_ptr<TextureList> list = textures.lock())
+				{
+					list->push_back(texture);
+				}
+			});
+		m_RequestMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Release all"))
+	{
+		m_Textures->clear();
+	}
+
+	std::unordered_set<const Texture*> unique;
+	for (const std::shared_ptr<Texture>& texture : *m_Textures)
+	{
+		unique.insert(texture.get());
+	}
+	ImGui::Text("Requests issued in %.3f ms, holding %u references to %u textures", m_RequestMilliseconds,
+		(unsigned int)m_Textures->size(), (unsigned int)unique.size());
+
+	if (!m_Textures->empty())
+	{
+		const Texture& texture = *m_Textures->front();
+		texture.Touch();
+		ImGui::Image((ImTextureID)(intptr_t)texture.GetRendererID(), ImVec2(256, 256), ImVec2(0, 1), ImVec2(1, 0));
+	}
+
+	ImGui::Separator();
+	AssetManager::OnImGuiRender();
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include "test.h"
+#include "Texture.h"
+
+#include <memory>
+#include <vector>
+
+namespace test
+{
+	// Requests the same image many times under different spellings of its path, synchronously or not
+	class TestAssets : public Test
+	{
+	public:
+		TestAssets();
+
+		void OnImGuiRender() override;
+	private:
+		using TextureList = std::vector<std::shared_ptr<Texture>>;
+
+		// shared with the async callbacks, which may run after the test is gone
+		std::shared_ptr<TextureList> m_Textures;
+		int m_RequestCount;
+		double m_RequestMilliseconds;
+	};
+}
@@ -0,0 +1,191 @@
+#include "TestBatchRenderer.h"
+#include "JobSystem.h"
+#include "Profiler.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+
+#include <chrono>
+#include <string>
+
+namespace
+{
+	const int SpriteImageSize = 32;
+	const glm::vec2 SpriteSize(16.0f, 16.0f);
+	// sprites recorded per job
+	const size_t RecordGrainSize = 2048;
+
+	// Bordered square with a color derived from the index
+	std::vector<unsigned char> GenerateImage(int index)
+	{
+		std::vector<unsigned char> pixels((size_t)SpriteImageSize * SpriteImageSize * 4);
+		for (int y = 0; y < SpriteImageSize; ++y)
+		{
+			for (int x = 0; x < SpriteImageSize; ++x)
+			{
+				const bool border = x < 2 || y < 2 || x >= SpriteImageSize - 2 || y >= SpriteImageSize - 2;
+				unsigned char* pixel = &pixels[((size_t)y * SpriteImageSize + x) * 4];
+				pixel[0] = border ? 255 : (unsigned char)(index * 67 % 256);
+				pixel[1] = border ? 255 : (unsigned char)(index * 131 % 256);
+				pixel[2] = border ? 255 : (unsigned char)(index * 29 % 256);
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+}
+
+test::TestBatchRenderer::TestBatchRenderer()
+	: m_SpriteCount(5000), m_TextureCount(40), m_CreatedTextureCount(0), m_UseAtlas(false), m_RecordOnWorkers(false),
+	m_Recorded(false), m_Renderer(new BatchRenderer()), m_LastStats(), m_RecordMilliseconds(0.0),
+	m_SubmitMilliseconds(0.0)
+{
+}
+
+void test::TestBatchRenderer::CreateTextures()
+{
+	m_Textures.clear();
+	m_Atlas.reset(new TextureAtlas());
+	for (int i = 0; i < m_TextureCount; ++i)
+	{
+		std::vector<unsigned char> pixels = GenerateImage(i);
+		m_Textures.emplace_back(new Texture(SpriteImageSize, SpriteImageSize, pixels.data()));
+		m_Atlas->AddImage(std::to_string(i), pixels.data(), SpriteImageSize, SpriteImageSize);
+	}
+	TextureAtlasSettings settings;
+	settings.PageSize = 1024;
+	settings.Usage = TextureUsage::Data;
+	m_Atlas->Build(settings);
+	m_CreatedTextureCount = m_TextureCount;
+}
+
+glm::vec2 test::TestBatchRenderer::GetPosition(int sprite) const
+{
+	const int columns = 100;
+	return glm::vec2(20.0f + (sprite % columns) * 18.0f, 20.0f + (sprite / columns % 56) * 18.0f);
+}
+
+void test::TestBatchRenderer::RecordSprites(size_t begin, size_t end)
+{
+	PROFILE_FUNCTION();
+	CommandBuffer& buffer = m_Recorder.GetBuffer();
+	for (size_t i = begin; i < end; ++i)
+	{
+		const glm::vec2 position = GetPosition((int)i);
+		// culled against the view, sprites can't be partially visible with this layout but a scene's could
+		if (position.x + SpriteSize.x < 0.0f || position.y + SpriteSize.y < 0.0f
+			|| position.x > 1920.0f || position.y > 1080.0f)
+		{
+			continue;
+		}
+
+		const int image = ((int)i * 7) % m_TextureCount;
+		SpriteCommand command;
+		command.Position = position;
+		command.Size = SpriteSize;
+		command.Color = glm::vec4(1.0f);
+		if (m_UseAtlas)
+		{
+			const AtlasRegion& region = m_Atlas->GetRegions()[image];
+			if (region.Page < 0)
+			{
+				continue;
+			}
+			command.UV = glm::vec4(region.U0, region.V0, region.U1, region.V1);
+			command.Image = &m_Atlas->GetPage(region.Page);
+			command.SortKey = CommandRecorder::MakeKey(0, region.Page, (unsigned int)i);
+		}
+		else
+		{
+			command.UV = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+			command.Image = m_Textures[image].get();
+			command.SortKey = CommandRecorder::MakeKey(0, image, (unsigned int)i);
+		}
+		buffer.Add(command);
+	}
+}
+
+void test::TestBatchRenderer::OnUpdate(float deltaTime)
+{
+	Test::OnUpdate(deltaTime);
+	// the textures are only created by OnRender, the first frame after a change draws directly
+	m_Recorded = m_RecordOnWorkers && m_CreatedTextureCount == m_TextureCount;
+	if (!m_Recorded)
+	{
+		return;
+	}
+
+	// no GL here, the workers cull, record and sort while the render thread draws the last frame
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_Recorder.Begin();
+	JobSystem::ParallelFor((size_t)m_SpriteCount, RecordGrainSize, [this](size_t begin, size_t end)
+	{
+		RecordSprites(begin, end);
+	});
+	m_Recorder.Merge();
+	m_RecordMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void test::TestBatchRenderer::OnRender()
+{
+	Test::OnRender();
+	if (m_CreatedTextureCount != m_TextureCount)
+	{
+		// whatever was recorded points to the textures being replaced
+		CreateTextures();
+		m_Recorded = false;
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_Renderer->ResetStats();
+	m_Renderer->Begin(glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f));
+	if (m_Recorded)
+	{
+		for (const SortedCommand& sorted : m_Recorder.GetSorted())
+		{
+			const SpriteCommand& command = *sorted.Command;
+			m_Renderer->DrawQuad(command.Position, command.Size, *command.Image, command.UV, command.Color);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < m_SpriteCount; ++i)
+		{
+			const glm::vec2 position = GetPosition(i);
+			const int image = (i * 7) % m_TextureCount;
+			if (m_UseAtlas)
+			{
+				m_Renderer->DrawQuad(position, SpriteSize, *m_Atlas, m_Atlas->GetRegions()[image]);
+			}
+			else
+			{
+				m_Renderer->DrawQuad(position, SpriteSize, *m_Textures[image]);
+			}
+		}
+	}
+	m_Renderer->End();
+	m_LastStats = m_Renderer->GetStats();
+	m_SubmitMilliseconds = std::chrono::duration<double, std::milli>(
+		std::chrono::high_resolution_clock::now() - start).count();
+}
+
+void test::TestBatchRenderer::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderInt("Sprites", &m_SpriteCount, 1, 50000);
+	ImGui::SliderInt("Textures", &m_TextureCount, 1, 256);
+	ImGui::Checkbox("Use atlas", &m_UseAtlas);
+	ImGui::Checkbox("Cull and record on the job system, sorted by texture", &m_RecordOnWorkers);
+	ImGui::Text("%u texture slots per batch", m_Renderer->GetSlotCount());
+	ImGui::Text("%u quads, %u draw calls, %u texture binds", m_LastStats.Quads, m_LastStats.DrawCalls,
+		m_LastStats.TextureBinds);
+	ImGui::Text("Flushes: %u slot table full, %u buffer full", m_LastStats.SlotFlushes, m_LastStats.BufferFlushes);
+	ImGui::Text("Submit %.2f ms", m_SubmitMilliseconds);
+	if (m_RecordOnWorkers)
+	{
+		const CommandRecorderStats stats = m_Recorder.GetStats();
+		ImGui::Text("Record and sort %.2f ms (merge %.2f ms), %u commands from %u threads", m_RecordMilliseconds,
+			stats.MergeMilliseconds, stats.Commands, stats.ActiveBuffers);
+		ImGui::Text("Command buffers %.1f KB", stats.ArenaBytes / 1024.0f);
+	}
+}
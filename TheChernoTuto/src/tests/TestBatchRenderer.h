@@ -0,0 +1,40 @@
+#pragma once
+#include "test.h"
+#include "BatchRenderer.h"
+#include "CommandBuffer.h"
+
+#include <memory>
+
+namespace test
+{
+	// Draws many sprites using separate textures or the same images packed in an atlas and reports the draw calls.
+	// The sprites can also be culled and recorded by the job system workers, then sorted by texture and submitted.
+	class TestBatchRenderer : public Test
+	{
+	public:
+		TestBatchRenderer();
+
+		void OnUpdate(float deltaTime) override;
+		void OnRender() override;
+		void OnImGuiRender() override;
+	private:
+		void CreateTextures();
+		void RecordSprites(size_t begin, size_t end);
+		glm::vec2 GetPosition(int sprite) const;
+
+		int m_SpriteCount;
+		int m_TextureCount;
+		int m_CreatedTextureCount;
+		bool m_UseAtlas;
+		bool m_RecordOnWorkers;
+		// set by OnUpdate when this frame's sprites are waiting in the recorder
+		bool m_Recorded;
+		std::unique_ptr<BatchRenderer> m_Renderer;
+		std::vector<std::unique_ptr<Texture>> m_Textures;
+		std::unique_ptr<TextureAtlas> m_Atlas;
+		CommandRecorder m_Recorder;
+		BatchStats m_LastStats;
+		double m_RecordMilliseconds;
+		double m_SubmitMilliseconds;
+	};
+}
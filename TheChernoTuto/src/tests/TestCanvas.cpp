@@ -0,0 +1,107 @@
+#include "TestCanvas.h"
+#include "imgui/imgui.h"
+
+#include <cmath>
+
+namespace
+{
+	const int CanvasSize = 2048;
+	const int SpriteSize = 24;
+	const unsigned char Background[4] = { 32, 32, 40, 255 };
+}
+
+test::TestCanvas::TestCanvas()
+	: m_BrushRadius(12), m_BrushColor{ 1.0f, 0.6f, 0.1f, 1.0f }, m_MovingSprites(8), m_UsePixelBuffers(true), m_Frame(0)
+{
+	m_Canvas.reset(new TextureCanvas(CanvasSize, CanvasSize));
+	m_Canvas->FillRect(0, 0, CanvasSize, CanvasSize, Background);
+	m_Canvas->SetUsePixelBuffers(m_UsePixelBuffers);
+}
+
+void test::TestCanvas::OnUpdate(float deltaTime)
+{
+	Test::OnUpdate(deltaTime);
+	// each sprite erases where it was and draws itself a bit further on its circle
+	for (int i = 0; i < m_MovingSprites; ++i)
+	{
+		const float radius = 200.0f + i * 90.0f;
+		const float speed = 0.01f + i * 0.003f;
+		const auto position = [&](unsigned int frame, int& x, int& y)
+		{
+			x = (int)(CanvasSize / 2 + radius * std::cos(frame * speed + i)) - SpriteSize / 2;
+			y = (int)(CanvasSize / 2 + radius * std::sin(frame * speed + i)) - SpriteSize / 2;
+		};
+		int x, y;
+		if (m_Frame > 0)
+		{
+			position(m_Frame - 1, x, y);
+			m_Canvas->FillRect(x, y, SpriteSize, SpriteSize, Background);
+		}
+		position(m_Frame, x, y);
+		const unsigned char color[4] = { (unsigned char)(80 + i * 20), 200, (unsigned char)(255 - i * 20), 255 };
+		m_Canvas->FillRect(x, y, SpriteSize, SpriteSize, color);
+	}
+	++m_Frame;
+}
+
+void test::TestCanvas::Stamp(int x, int y, int radius, const unsigned char* color)
+{
+	unsigned char* pixels = m_Canvas->GetPixels();
+	for (int dy = -radius; dy <= radius; ++dy)
+	{
+		for (int dx = -radius; dx <= radius; ++dx)
+		{
+			const int px = x + dx, py = y + dy;
+			if (dx * dx + dy * dy > radius * radius || px < 0 || py < 0 || px >= CanvasSize || py >= CanvasSize)
+			{
+				continue;
+			}
+			unsigned char* dst = pixels + ((size_t)py * CanvasSize + px) * 4;
+			for (int c = 0; c < 4; ++c)
+			{
+				dst[c] = color[c];
+			}
+		}
+	}
+	m_Canvas->MarkDirty(x - radius, y - radius, radius * 2 + 1, radius * 2 + 1);
+}
+
+void test::TestCanvas::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderInt("Brush radius", &m_BrushRadius, 1, 64);
+	ImGui::ColorEdit4("Brush color", m_BrushColor);
+	ImGui::SliderInt("Moving sprites", &m_MovingSprites, 0, 16);
+	if (ImGui::Checkbox("Upload through a pixel buffer ring", &m_UsePixelBuffers))
+	{
+		m_Canvas->SetUsePixelBuffers(m_UsePixelBuffers);
+	}
+	if (ImGui::Button("Clear"))
+	{
+		m_Canvas->FillRect(0, 0, CanvasSize, CanvasSize, Background);
+	}
+
+	const TextureCanvasStats& stats = m_Canvas->GetStats();
+	ImGui::Text("%u rects marked, %u uploaded: %.1f KB instead of %.1f KB", stats.MarkedRects, stats.UploadedRects,
+		stats.UploadedBytes / 1024.0f, stats.FullUploadBytes / 1024.0f);
+	ImGui::Text("%u waits on a pixel buffer still in use", stats.PixelBufferStalls);
+
+	const float previewSize = 512.0f;
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	ImGui::Image((ImTextureID)(intptr_t)m_Canvas->GetTexture().GetRendererID(), ImVec2(previewSize, previewSize),
+		ImVec2(0, 1), ImVec2(1, 0));
+	if (ImGui::IsItemHovered() && ImGui::IsMouseDown(ImGuiMouseButton_Left))
+	{
+		// the canvas rows go bottom up, the preview is drawn flipped
+		const ImVec2 mouse = ImGui::GetMousePos();
+		const float scale = CanvasSize / previewSize;
+		const int x = (int)((mouse.x - origin.x) * scale);
+		const int y = (int)((previewSize - (mouse.y - origin.y)) * scale);
+		const unsigned char color[4] = { (unsigned char)(m_BrushColor[0] * 255.0f), (unsigned char)(m_BrushColor[1] * 255.0f),
+			(unsigned char)(m_BrushColor[2] * 255.0f), (unsigned char)(m_BrushColor[3] * 255.0f) };
+		Stamp(x, y, m_BrushRadius, color);
+	}
+
+	// the preview is drawn once ImGui renders, after this
+	m_Canvas->Flush();
+}
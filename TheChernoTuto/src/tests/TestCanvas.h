@@ -0,0 +1,27 @@
+#pragma once
+#include "test.h"
+#include "TextureCanvas.h"
+
+#include <memory>
+
+namespace test
+{
+	// Paint on a large canvas with the mouse while a few sprites move over it, only the touched regions are uploaded
+	class TestCanvas : public Test
+	{
+	public:
+		TestCanvas();
+
+		void OnUpdate(float deltaTime) override;
+		void OnImGuiRender() override;
+	private:
+		void Stamp(int x, int y, int radius, const unsigned char* color);
+
+		std::unique_ptr<TextureCanvas> m_Canvas;
+		int m_BrushRadius;
+		float m_BrushColor[4];
+		int m_MovingSprites;
+		bool m_UsePixelBuffers;
+		unsigned int m_Frame;
+	};
+}
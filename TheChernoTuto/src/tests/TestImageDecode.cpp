@@ -0,0 +1,240 @@
+#include "TestImageDecode.h"
+#include "FileBatchReader.h"
+#include "ImageDecoder.h"
+#include "Qoi.h"
+#include "imgui/imgui.h"
+#include "stb_image/stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+	std::string GetQoiPath(const std::string& filepath)
+	{
+		const size_t dot = filepath.find_last_of('.');
+		return (dot == std::string::npos ? filepath : filepath.substr(0, dot)) + ".qoi";
+	}
+
+	bool ReadFile(const std::string& filepath, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream stream(filepath, std::ios::binary);
+		if (!stream)
+		{
+			return false;
+		}
+		bytes.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+		return true;
+	}
+}
+
+test::TestImageDecode::TestImageDecode()
+	: m_Iterations(10), m_SerialMilliseconds(0.0), m_BatchMilliseconds(0.0), m_SerialReadMilliseconds(0.0),
+	m_BatchReadMilliseconds(0.0)
+{
+	std::strcpy(m_Filepaths, "res/textures/proteccTerra.png");
+}
+
+void test::TestImageDecode::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::InputTextMultiline("Images (one per line)", m_Filepaths, sizeof(m_Filepaths), ImVec2(0, 80));
+	ImGui::SliderInt("Iterations", &m_Iterations, 1, 100);
+	bool useIoUring = FileBatchReader::GetUseIoUring();
+	if (FileBatchReader::IsIoUringSupported() && ImGui::Checkbox("Read with io_uring", &useIoUring))
+	{
+		FileBatchReader::SetUseIoUring(useIoUring);
+	}
+	if (ImGui::Button("Convert to QOI"))
+	{
+		ConvertAll();
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Run"))
+	{
+		RunBenchmark();
+	}
+	if (!m_Status.empty())
+	{
+		ImGui::TextUnformatted(m_Status.c_str());
+	}
+
+	if (m_Results.empty())
+	{
+		return;
+	}
+	ImGui::Text("Whole set: %.3f ms one by one with stbi_load, %.3f ms with ImageDecoder::LoadBatch",
+		m_SerialMilliseconds, m_BatchMilliseconds);
+	ImGui::Text("Reading PNG and QOI files: %.3f ms one by one, %.3f ms batched over %s", m_SerialReadMilliseconds,
+		m_BatchReadMilliseconds, m_ReadBackend.c_str());
+	if (!ImGui::BeginTable("Results", 7, ImGuiTableFlags_Borders))
+	{
+		return;
+	}
+	ImGui::TableSetupColumn("Image");
+	ImGui::TableSetupColumn("PNG / QOI (KB)");
+	ImGui::TableSetupColumn("stbi_load (ms)");
+	ImGui::TableSetupColumn("ImageDecoder (ms)");
+	ImGui::TableSetupColumn("QOI (ms)");
+	ImGui::TableSetupColumn("QOI (Mpix/s)");
+	ImGui::TableSetupColumn("Speedup");
+	ImGui::TableHeadersRow();
+	for (const auto& result : m_Results)
+	{
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn(); ImGui::TextUnformatted(result.Filepath.c_str());
+		ImGui::TableNextColumn(); ImGui::Text("%u / %u", (unsigned int)(result.PngSize / 1024), (unsigned int)(result.QoiSize / 1024));
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", result.PngMilliseconds);
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", result.DecoderMilliseconds);
+		ImGui::TableNextColumn(); ImGui::Text("%.3f", result.QoiMilliseconds);
+		ImGui::TableNextColumn(); ImGui::Text("%.1f", result.MegaPixels / (result.QoiMilliseconds / 1000.0));
+		ImGui::TableNextColumn(); ImGui::Text("%.2fx", result.PngMilliseconds / result.QoiMilliseconds);
+	}
+	ImGui::EndTable();
+}
+
+std::vector<std::string> test::TestImageDecode::GetFilepaths() const
+{
+	std::vector<std::string> filepaths;
+	std::stringstream ss(m_Filepaths);
+	std::string line;
+	while (std::getline(ss, line))
+	{
+		if (!line.empty())
+		{
+			filepaths.push_back(line);
+		}
+	}
+	return filepaths;
+}
+
+void test::TestImageDecode::ConvertAll()
+{
+	unsigned int converted = 0;
+	const std::vector<std::string> filepaths = GetFilepaths();
+	for (const auto& filepath : filepaths)
+	{
+		if (Qoi::ConvertFile(filepath, GetQoiPath(filepath)))
+		{
+			++converted;
+		}
+	}
+	m_Status = "Converted " + std::to_string(converted) + " of " + std::to_string(filepaths.size()) + " images";
+}
+
+void test::TestImageDecode::RunBenchmark()
+{
+	m_Results.clear();
+	m_Status.clear();
+
+	// mostly served by the page cache after the first run, what is left is the per file overhead
+	std::vector<FileReadRequest> reads;
+	for (const auto& filepath : GetFilepaths())
+	{
+		FileReadRequest source;
+		source.Filepath = filepath;
+		reads.push_back(std::move(source));
+		FileReadRequest qoi;
+		qoi.Filepath = GetQoiPath(filepath);
+		reads.push_back(std::move(qoi));
+	}
+	auto start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < m_Iterations; ++i)
+	{
+		for (const auto& read : reads)
+		{
+			std::vector<unsigned char> bytes;
+			ReadFile(read.Filepath, bytes);
+		}
+	}
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_SerialReadMilliseconds = elapsed.count() / m_Iterations;
+	FileBatchReaderStats readStats = {};
+	m_BatchReadMilliseconds = 0.0;
+	for (int i = 0; i < m_Iterations; ++i)
+	{
+		readStats = FileBatchReader::Read(reads);
+		m_BatchReadMilliseconds += readStats.Milliseconds / m_Iterations;
+	}
+	m_ReadBackend = FileBatchReader::GetBackendName(readStats.Backend);
+
+	std::vector<std::vector<unsigned char>> pngFiles;
+	for (const auto& filepath : GetFilepaths())
+	{
+		// files are read up front so only the decoders are timed
+		std::vector<unsigned char> png, qoi;
+		if (!ReadFile(filepath, png) || !ReadFile(GetQoiPath(filepath), qoi))
+		{
+			m_Status = "Missing " + filepath + " or its QOI copy, convert first";
+			continue;
+		}
+
+		Result result = { filepath, png.size(), qoi.size(), 0.0, 0.0, 0.0, 0.0 };
+		int width = 0, height = 0, channels = 0;
+
+		// same settings Texture uses: native channel count, flipped rows
+		stbi_set_flip_vertically_on_load_thread(1);
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < m_Iterations; ++i)
+		{
+			stbi_image_free(stbi_load_from_memory(png.data(), (int)png.size(), &width, &height, &channels, 0));
+		}
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+		result.PngMilliseconds = elapsed.count() / m_Iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < m_Iterations; ++i)
+		{
+			ImageDecoder::Free(ImageDecoder::LoadFromMemory(png.data(), (int)png.size(), &width, &height, &channels, 0, true));
+		}
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+		result.DecoderMilliseconds = elapsed.count() / m_Iterations;
+
+		start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < m_Iterations; ++i)
+		{
+			Qoi::Free(Qoi::LoadFromMemory(qoi.data(), qoi.size(), &width, &height, &channels, 0, true));
+		}
+		elapsed = std::chrono::high_resolution_clock::now() - start;
+		result.QoiMilliseconds = elapsed.count() / m_Iterations;
+		result.MegaPixels = (double)width * height / 1000000.0;
+
+		m_Results.push_back(result);
+		pngFiles.push_back(std::move(png));
+	}
+
+	// the whole set, as a scene load would see it
+	std::vector<ImageDecodeRequest> requests;
+	for (const auto& png : pngFiles)
+	{
+		requests.push_back({ png.data(), (int)png.size(), 0, true, nullptr, 0, 0, 0 });
+	}
+
+	stbi_set_flip_vertically_on_load_thread(1);
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < m_Iterations; ++i)
+	{
+		for (const auto& request : requests)
+		{
+			int width, height, channels;
+			stbi_image_free(stbi_load_from_memory(request.Buffer, request.Length, &width, &height, &channels, 0));
+		}
+	}
+	elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_SerialMilliseconds = elapsed.count() / m_Iterations;
+
+	start = std::chrono::high_resolution_clock::now();
+	for (int i = 0; i < m_Iterations; ++i)
+	{
+		ImageDecoder::LoadBatch(requests);
+		for (auto& request : requests)
+		{
+			ImageDecoder::Free(request.Pixels);
+		}
+	}
+	elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_BatchMilliseconds = elapsed.count() / m_Iterations;
+}
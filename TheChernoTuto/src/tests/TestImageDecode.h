@@ -0,0 +1,41 @@
+#pragma once
+#include "test.h"
+
+namespace test
+{
+	// Compares decode times of stb_image, ImageDecoder's PNG path and the QOI copies of the same images,
+	// and the whole set decoded one by one against ImageDecoder::LoadBatch. Reading the files is timed the same
+	// way, one after the other against a single FileBatchReader batch
+	class TestImageDecode : public Test
+	{
+	public:
+		TestImageDecode();
+
+		void OnImGuiRender() override;
+	private:
+		struct Result
+		{
+			std::string Filepath;
+			size_t PngSize;
+			size_t QoiSize;
+			double PngMilliseconds;
+			double DecoderMilliseconds;
+			double QoiMilliseconds;
+			double MegaPixels;
+		};
+
+		std::vector<std::string> GetFilepaths() const;
+		void ConvertAll();
+		void RunBenchmark();
+
+		char m_Filepaths[1024];
+		int m_Iterations;
+		std::string m_Status;
+		double m_SerialMilliseconds;
+		double m_BatchMilliseconds;
+		double m_SerialReadMilliseconds;
+		double m_BatchReadMilliseconds;
+		std::string m_ReadBackend;
+		std::vector<Result> m_Results;
+	};
+}
@@ -0,0 +1,111 @@
+#include "TestJobSystem.h"
+#include "JobSystem.h"
+#include "imgui/imgui.h"
+
+#include <chrono>
+
+test::TestJobSystem::TestJobSystem()
+	: m_ParticleCount(1000000), m_Substeps(8), m_GrainSize(4096), m_Parallel(true), m_SerialMilliseconds(0.0),
+	m_ParallelMilliseconds(0.0)
+{
+	Reset();
+	JobSystem::ResetStats();
+}
+
+void test::TestJobSystem::Reset()
+{
+	m_Particles.resize((size_t)m_ParticleCount);
+	for (size_t i = 0; i < m_Particles.size(); ++i)
+	{
+		// spread deterministically over the unit square, the speeds vary with the index too
+		const float t = (float)i / m_Particles.size();
+		m_Particles[i] = { t, (float)((i * 7919) % 1000) / 1000.0f, 0.5f - t, (float)(i % 13) / 13.0f };
+	}
+}
+
+void test::TestJobSystem::Simulate(size_t begin, size_t end)
+{
+	const float step = 1.0f / (60.0f * m_Substeps);
+	for (size_t i = begin; i < end; ++i)
+	{
+		Particle& particle = m_Particles[i];
+		for (int s = 0; s < m_Substeps; ++s)
+		{
+			particle.VelocityY -= 9.81f * step;
+			particle.X += particle.VelocityX * step;
+			particle.Y += particle.VelocityY * step;
+			// bounce inside the unit square, losing a little energy
+			if (particle.X < 0.0f || particle.X > 1.0f)
+			{
+				particle.VelocityX = -particle.VelocityX * 0.9f;
+				particle.X = particle.X < 0.0f ? 0.0f : 1.0f;
+			}
+			if (particle.Y < 0.0f)
+			{
+				particle.VelocityY = -particle.VelocityY * 0.9f;
+				particle.Y = 0.0f;
+			}
+		}
+	}
+}
+
+void test::TestJobSystem::OnUpdate(float deltaTime)
+{
+	Test::OnUpdate(deltaTime);
+	const auto start = std::chrono::high_resolution_clock::now();
+	if (m_Parallel)
+	{
+		JobSystem::ParallelFor(m_Particles.size(), (size_t)m_GrainSize, [this](size_t begin, size_t end)
+		{
+			Simulate(begin, end);
+		});
+	}
+	else
+	{
+		Simulate(0, m_Particles.size());
+	}
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	(m_Parallel ? m_ParallelMilliseconds : m_SerialMilliseconds) = elapsed.count();
+}
+
+void test::TestJobSystem::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	if (ImGui::SliderInt("Particles", &m_ParticleCount, 1000, 4000000))
+	{
+		Reset();
+	}
+	ImGui::SliderInt("Substeps", &m_Substeps, 1, 32);
+	ImGui::SliderInt("Grain size", &m_GrainSize, 64, 262144, "%d", ImGuiSliderFlags_Logarithmic);
+	ImGui::Checkbox("ParallelFor", &m_Parallel);
+	ImGui::Text("Main thread alone %.3f ms, ParallelFor %.3f ms (%.2fx) on %u workers", m_SerialMilliseconds,
+		m_ParallelMilliseconds, m_ParallelMilliseconds > 0.0 ? m_SerialMilliseconds / m_ParallelMilliseconds : 0.0,
+		JobSystem::GetWorkerCount());
+
+	if (ImGui::Button("Reset stats"))
+	{
+		JobSystem::ResetStats();
+	}
+	const std::vector<JobWorkerStats> workers = JobSystem::GetStats();
+	if (!ImGui::BeginTable("Workers", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+	{
+		return;
+	}
+	ImGui::TableSetupColumn("Worker");
+	ImGui::TableSetupColumn("Jobs");
+	ImGui::TableSetupColumn("Steals");
+	ImGui::TableSetupColumn("Failed steals");
+	ImGui::TableSetupColumn("Idle (ms)");
+	ImGui::TableHeadersRow();
+	for (size_t i = 0; i < workers.size(); ++i)
+	{
+		const JobWorkerStats& stats = workers[i];
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn(); ImGui::Text(i == 0 ? "main" : "%u", (unsigned int)i);
+		ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)stats.Jobs);
+		ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)stats.Steals);
+		ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)stats.FailedSteals);
+		ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.IdleMilliseconds);
+	}
+	ImGui::EndTable();
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include "test.h"
+
+#include <vector>
+
+namespace test
+{
+	// Moves a large set of particles every frame, on the main thread alone or with JobSystem::ParallelFor, and
+	// shows what every worker did meanwhile
+	class TestJobSystem : public Test
+	{
+	public:
+		TestJobSystem();
+
+		void OnUpdate(float deltaTime) override;
+		void OnImGuiRender() override;
+	private:
+		struct Particle
+		{
+			float X, Y;
+			float VelocityX, VelocityY;
+		};
+
+		void Reset();
+		void Simulate(size_t begin, size_t end);
+
+		std::vector<Particle> m_Particles;
+		int m_ParticleCount;
+		int m_Substeps;
+		int m_GrainSize;
+		bool m_Parallel;
+		double m_SerialMilliseconds;
+		double m_ParallelMilliseconds;
+	};
+}
@@ -0,0 +1,80 @@
+#include "TestResidency.h"
+#include "AssetManager.h"
+#include "Renderer.h"
+#include "TextureResidency.h"
+#include "VertexBufferLayout.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+
+namespace
+{
+	const int TextureCount = 16;
+	const int Columns = 8;
+	const float QuadSize = 220.0f;
+}
+
+test::TestResidency::TestResidency()
+	: m_VisibleCount(TextureCount), m_BudgetInTextures(6), m_PreviousBudget(TextureResidency::GetBudget())
+{
+	for (int i = 0; i < TextureCount; ++i)
+	{
+		m_Textures.emplace_back(new Texture("res/textures/proteccTerra.png", TextureCompression::None, TextureUsage::Color));
+	}
+	TextureResidency::SetBudget(m_BudgetInTextures * m_Textures[0]->GetLevelSizeInBytes(0));
+
+	// the textures stay separate on purpose, they are what the residency manager juggles
+	m_Shader = AssetManager::LoadShader("res/shaders/Basic.shader");
+	m_Shader->Bind();
+	m_Shader->SetUniform1i("u_Texture", 0);
+	m_Shader->Unbind();
+
+	const float positions[] = {
+		0.0f,     0.0f,     0.0f, 0.0f,
+		QuadSize, 0.0f,     1.0f, 0.0f,
+		QuadSize, QuadSize, 1.0f, 1.0f,
+		0.0f,     QuadSize, 0.0f, 1.0f
+	};
+	m_VertexArray.reset(new VertexArray());
+	m_VertexBuffer.reset(new VertexBuffer(positions, sizeof(positions)));
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(2);
+	m_VertexArray->AddBuffer(*m_VertexBuffer, layout);
+
+	const unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+	m_IndexBuffer.reset(new IndexBuffer(indices, 6));
+}
+
+test::TestResidency::~TestResidency()
+{
+	TextureResidency::SetBudget(m_PreviousBudget);
+}
+
+void test::TestResidency::OnRender()
+{
+	Test::OnRender();
+	Renderer renderer;
+	const glm::mat4 proj = glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f);
+	for (int i = 0; i < m_VisibleCount; ++i)
+	{
+		// binding is what marks a texture as used, hidden ones age and become the first to go
+		m_Textures[i]->Bind(0);
+		const glm::vec3 offset(40.0f + (i % Columns) * (QuadSize + 10.0f), 560.0f - (i / Columns) * (QuadSize + 10.0f), 0.0f);
+		m_Shader->Bind();
+		m_Shader->SetUniformMat4f("u_MVP", proj * glm::translate(glm::mat4(1.0f), offset));
+		renderer.Draw(*m_VertexArray, *m_IndexBuffer, *m_Shader);
+	}
+}
+
+void test::TestResidency::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderInt("Visible textures", &m_VisibleCount, 0, TextureCount);
+	if (ImGui::SliderInt("Budget (full size textures)", &m_BudgetInTextures, 1, TextureCount))
+	{
+		TextureResidency::SetBudget(m_BudgetInTextures * m_Textures[0]->GetLevelSizeInBytes(0));
+	}
+	ImGui::TextWrapped("Hidden textures are dropped to their average color first, when the visible ones still don't "
+		"fit they lose their top mip levels and are streamed back once there is room again.");
+	TextureResidency::OnImGuiRender();
+}
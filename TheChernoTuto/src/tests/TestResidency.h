@@ -0,0 +1,34 @@
+#pragma once
+#include "test.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace test
+{
+	// Many copies of one image under a small VRAM budget, hiding some of them lets TextureResidency evict them
+	class TestResidency : public Test
+	{
+	public:
+		TestResidency();
+		~TestResidency();
+
+		void OnRender() override;
+		void OnImGuiRender() override;
+	private:
+		int m_VisibleCount;
+		int m_BudgetInTextures;
+		size_t m_PreviousBudget;
+		std::vector<std::unique_ptr<Texture>> m_Textures;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<VertexArray> m_VertexArray;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	};
+}
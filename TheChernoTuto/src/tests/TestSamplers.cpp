@@ -0,0 +1,86 @@
+#include "TestSamplers.h"
+#include "AssetManager.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+
+#include <cstdio>
+
+namespace
+{
+	const int ModeCount = 4;
+	const char* ModeNames[ModeCount] = { "Nearest / Repeat", "Linear / Repeat", "Linear / Mirror", "Linear / Clamp" };
+
+	SamplerState GetModeState(int mode, float anisotropy)
+	{
+		SamplerState state;
+		state.Filter = mode == 0 ? TextureFilter::Nearest : TextureFilter::Linear;
+		state.Wrap = mode == 2 ? TextureWrap::Mirror : mode == 3 ? TextureWrap::Clamp : TextureWrap::Repeat;
+		state.MaxAnisotropy = anisotropy;
+		return state;
+	}
+}
+
+test::TestSamplers::TestSamplers()
+	: m_Tiling(3.0f), m_AnisotropyLevel(0), m_BuiltTiling(0.0f)
+{
+	m_Texture = AssetManager::LoadTexture("res/textures/proteccTerra.png", TextureCompression::None, TextureUsage::Color);
+	m_Shader = AssetManager::LoadShader("res/shaders/Basic.shader");
+	m_Shader->Bind();
+	m_Shader->SetUniform1i("u_Texture", 0);
+	m_Shader->Unbind();
+
+	const unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+	m_IndexBuffer.reset(new IndexBuffer(indices, 6));
+}
+
+void test::TestSamplers::OnRender()
+{
+	Test::OnRender();
+	if (m_BuiltTiling != m_Tiling)
+	{
+		// texture coordinates past 1 so the wrap modes show
+		const float positions[] = {
+			0.0f,   0.0f,   0.0f,     0.0f,
+			400.0f, 0.0f,   m_Tiling, 0.0f,
+			400.0f, 400.0f, m_Tiling, m_Tiling,
+			0.0f,   400.0f, 0.0f,     m_Tiling
+		};
+		m_VertexArray.reset(new VertexArray());
+		m_VertexBuffer.reset(new VertexBuffer(positions, sizeof(positions)));
+		VertexBufferLayout layout;
+		layout.Push<float>(2);
+		layout.Push<float>(2);
+		m_VertexArray->AddBuffer(*m_VertexBuffer, layout);
+		m_BuiltTiling = m_Tiling;
+	}
+
+	Renderer renderer;
+	const glm::mat4 proj = glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f);
+	for (int mode = 0; mode < ModeCount; ++mode)
+	{
+		// the texture stays bound, only the sampler on slot 0 changes between the draws
+		m_Texture->Bind(0, GetModeState(mode, (float)(1 << m_AnisotropyLevel)));
+		const glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(40.0f + mode * 460.0f, 100.0f, 0.0f));
+		m_Shader->Bind();
+		m_Shader->SetUniformMat4f("u_MVP", proj * model);
+		renderer.Draw(*m_VertexArray, *m_IndexBuffer, *m_Shader);
+	}
+}
+
+void test::TestSamplers::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderFloat("Tiling", &m_Tiling, 0.5f, 8.0f);
+	char anisotropy[8];
+	std::snprintf(anisotropy, sizeof(anisotropy), "%dx", 1 << m_AnisotropyLevel);
+	ImGui::SliderInt("Anisotropy", &m_AnisotropyLevel, 0, 4, anisotropy);
+	for (int mode = 0; mode < ModeCount; ++mode)
+	{
+		ImGui::Text("%d: %s", mode + 1, ModeNames[mode]);
+	}
+	const SamplerCacheStats stats = SamplerCache::GetStats();
+	ImGui::Text("%u samplers created, %u binds, %u redundant binds skipped", stats.Samplers, stats.Binds,
+		stats.RedundantBinds);
+}
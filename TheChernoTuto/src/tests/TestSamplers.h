@@ -0,0 +1,33 @@
+#pragma once
+#include "test.h"
+#include "IndexBuffer.h"
+#include "SamplerCache.h"
+#include "Shader.h"
+#include "Texture.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <memory>
+
+namespace test
+{
+	// Draws one texture several times with a different sampler for each copy, without touching the texture
+	class TestSamplers : public Test
+	{
+	public:
+		TestSamplers();
+
+		void OnRender() override;
+		void OnImGuiRender() override;
+	private:
+		float m_Tiling;
+		// the anisotropy is 1 << m_AnisotropyLevel, every distinct value is a sampler the cache keeps
+		int m_AnisotropyLevel;
+		std::shared_ptr<Texture> m_Texture;
+		std::shared_ptr<Shader> m_Shader;
+		std::unique_ptr<VertexArray> m_VertexArray;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		float m_BuiltTiling;
+	};
+}
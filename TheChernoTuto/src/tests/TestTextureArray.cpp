@@ -0,0 +1,112 @@
+#include "TestTextureArray.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+
+#include <vector>
+
+namespace
+{
+	const int LayerSize = 64;
+	const int LayerCount = 16;
+
+	// Checkerboard with a different hue per layer, so every layer is recognisable in the grid
+	std::vector<unsigned char> GenerateLayer(int layer)
+	{
+		std::vector<unsigned char> pixels((size_t)LayerSize * LayerSize * 4);
+		const unsigned char r = (unsigned char)(layer * 53 % 256);
+		const unsigned char g = (unsigned char)(layer * 97 % 256);
+		const unsigned char b = (unsigned char)(255 - layer * 16);
+		for (int y = 0; y < LayerSize; ++y)
+		{
+			for (int x = 0; x < LayerSize; ++x)
+			{
+				const bool dark = ((x / 8) + (y / 8)) % 2 == 0;
+				unsigned char* pixel = &pixels[((size_t)y * LayerSize + x) * 4];
+				pixel[0] = dark ? r / 2 : r;
+				pixel[1] = dark ? g / 2 : g;
+				pixel[2] = dark ? b / 2 : b;
+				pixel[3] = 255;
+			}
+		}
+		return pixels;
+	}
+}
+
+test::TestTextureArray::TestTextureArray()
+	: m_Columns(24), m_Rows(12), m_BuiltColumns(0), m_BuiltRows(0)
+{
+	m_Textures.reset(new TextureArray(LayerSize, LayerSize, LayerCount, 4, TextureUsage::Color, true));
+	for (int layer = 0; layer < LayerCount; ++layer)
+	{
+		m_Textures->SetLayer(layer, GenerateLayer(layer).data());
+	}
+	m_Textures->GenerateMipmaps();
+
+	m_Shader.reset(new Shader("res/shaders/TextureArray.shader"));
+	m_Shader->Bind();
+	m_Shader->SetUniform1i("u_Textures", 0);
+	m_Shader->Unbind();
+}
+
+void test::TestTextureArray::BuildGrid()
+{
+	const float size = 64.0f, spacing = 72.0f;
+	std::vector<float> vertices;
+	std::vector<unsigned int> indices;
+	for (int row = 0; row < m_Rows; ++row)
+	{
+		for (int column = 0; column < m_Columns; ++column)
+		{
+			const float x = 20.0f + column * spacing;
+			const float y = 20.0f + row * spacing;
+			const float layer = (float)((row * m_Columns + column) % LayerCount);
+			const unsigned int first = (unsigned int)(vertices.size() / 5);
+			const float quad[] = {
+				x,        y,        0.0f, 0.0f, layer,
+				x + size, y,        1.0f, 0.0f, layer,
+				x + size, y + size, 1.0f, 1.0f, layer,
+				x,        y + size, 0.0f, 1.0f, layer
+			};
+			vertices.insert(vertices.end(), quad, quad + 20);
+			const unsigned int quadIndices[] = { first, first + 1, first + 2, first + 2, first + 3, first };
+			indices.insert(indices.end(), quadIndices, quadIndices + 6);
+		}
+	}
+
+	m_VertexArray.reset(new VertexArray());
+	m_VertexBuffer.reset(new VertexBuffer(vertices.data(), (unsigned int)(vertices.size() * sizeof(float))));
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(3);
+	m_VertexArray->AddBuffer(*m_VertexBuffer, layout);
+	m_IndexBuffer.reset(new IndexBuffer(indices.data(), (unsigned int)indices.size()));
+
+	m_BuiltColumns = m_Columns;
+	m_BuiltRows = m_Rows;
+}
+
+void test::TestTextureArray::OnRender()
+{
+	Test::OnRender();
+	if (m_BuiltColumns != m_Columns || m_BuiltRows != m_Rows)
+	{
+		BuildGrid();
+	}
+
+	Renderer renderer;
+	m_Textures->Bind(0);
+	m_Shader->Bind();
+	m_Shader->SetUniformMat4f("u_MVP", glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f));
+	renderer.Draw(*m_VertexArray, *m_IndexBuffer, *m_Shader);
+}
+
+void test::TestTextureArray::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::SliderInt("Columns", &m_Columns, 1, 26);
+	ImGui::SliderInt("Rows", &m_Rows, 1, 14);
+	ImGui::Text("%d sprites over %d layers of %dx%d, 1 draw call", m_Columns * m_Rows,
+		m_Textures->GetLayerCount(), m_Textures->GetWidth(), m_Textures->GetHeight());
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "test.h"
+#include "IndexBuffer.h"
+#include "Shader.h"
+#include "TextureArray.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+
+#include <memory>
+
+namespace test
+{
+	// Draws a grid of sprites that each use a different layer of a texture array, in a single draw call
+	class TestTextureArray : public Test
+	{
+	public:
+		TestTextureArray();
+
+		void OnRender() override;
+		void OnImGuiRender() override;
+	private:
+		void BuildGrid();
+
+		int m_Columns, m_Rows;
+		int m_BuiltColumns, m_BuiltRows;
+		std::unique_ptr<TextureArray> m_Textures;
+		std::unique_ptr<Shader> m_Shader;
+		std::unique_ptr<VertexArray> m_VertexArray;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+	};
+}
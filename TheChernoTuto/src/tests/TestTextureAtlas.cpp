@@ -0,0 +1,116 @@
+#include "TestTextureAtlas.h"
+#include "imgui/imgui.h"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <sstream>
+
+namespace
+{
+	// Filled circle in the middle of a transparent square, so trimming has a border to remove
+	std::vector<unsigned char> GenerateSprite(int size, int radius, const unsigned char color[3])
+	{
+		std::vector<unsigned char> pixels((size_t)size * size * 4, 0);
+		const int center = size / 2;
+		for (int y = 0; y < size; ++y)
+		{
+			for (int x = 0; x < size; ++x)
+			{
+				const int dx = x - center, dy = y - center;
+				if (dx * dx + dy * dy <= radius * radius)
+				{
+					unsigned char* pixel = &pixels[((size_t)y * size + x) * 4];
+					pixel[0] = color[0];
+					pixel[1] = color[1];
+					pixel[2] = color[2];
+					pixel[3] = 255;
+				}
+			}
+		}
+		return pixels;
+	}
+}
+
+test::TestTextureAtlas::TestTextureAtlas()
+	: m_GeneratedSprites(500), m_BuildMilliseconds(0.0), m_Failed(0)
+{
+	std::strcpy(m_Filepaths, "res/textures/proteccTerra.png");
+	m_Settings.PageSize = 1024;
+}
+
+void test::TestTextureAtlas::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::InputTextMultiline("Images (one per line)", m_Filepaths, sizeof(m_Filepaths), ImVec2(0, 80));
+	ImGui::SliderInt("Generated sprites", &m_GeneratedSprites, 0, 5000);
+	ImGui::SliderInt("Page size", &m_Settings.PageSize, 256, 4096);
+	ImGui::SliderInt("Padding", &m_Settings.Padding, 0, 8);
+	ImGui::Checkbox("Extrude", &m_Settings.Extrude);
+	ImGui::SameLine();
+	ImGui::Checkbox("Trim", &m_Settings.Trim);
+	if (ImGui::Button("Build"))
+	{
+		Build();
+	}
+
+	if (!m_Atlas)
+	{
+		return;
+	}
+	ImGui::Text("%u images on %u pages in %.2f ms, %.1f%% of the page area used, %d didn't fit",
+		(unsigned int)m_Atlas->GetRegions().size(), (unsigned int)m_Atlas->GetPageCount(),
+		m_BuildMilliseconds, m_Atlas->GetOccupancy() * 100.0f, m_Failed);
+
+	const float previewWidth = 256.0f;
+	for (size_t i = 0; i < m_Atlas->GetPageCount(); ++i)
+	{
+		const Texture& page = m_Atlas->GetPage(i);
+		ImGui::BeginGroup();
+		ImGui::Text("Page %u (%dx%d)", (unsigned int)i, page.GetWidth(), page.GetHeigth());
+		ImGui::Image((ImTextureID)(intptr_t)page.GetRendererID(),
+			ImVec2(previewWidth, previewWidth * page.GetHeigth() / page.GetWidth()), ImVec2(0, 1), ImVec2(1, 0));
+		ImGui::EndGroup();
+		ImGui::SameLine();
+	}
+	ImGui::NewLine();
+}
+
+void test::TestTextureAtlas::Build()
+{
+	m_Atlas.reset(new TextureAtlas());
+
+	std::stringstream ss(m_Filepaths);
+	std::string line;
+	while (std::getline(ss, line))
+	{
+		if (!line.empty())
+		{
+			m_Atlas->AddImage(line);
+		}
+	}
+
+	std::mt19937 random(1234);
+	std::uniform_int_distribution<int> sizes(8, 96);
+	std::uniform_int_distribution<int> channel(64, 255);
+	for (int i = 0; i < m_GeneratedSprites; ++i)
+	{
+		const int size = sizes(random);
+		const unsigned char color[3] = {
+			(unsigned char)channel(random), (unsigned char)channel(random), (unsigned char)channel(random)
+		};
+		std::vector<unsigned char> pixels = GenerateSprite(size, size / 3, color);
+		m_Atlas->AddImage("sprite" + std::to_string(i), pixels.data(), size, size);
+	}
+
+	const auto start = std::chrono::high_resolution_clock::now();
+	m_Atlas->Build(m_Settings);
+	const std::chrono::duration<double, std::milli> elapsed = std::chrono::high_resolution_clock::now() - start;
+	m_BuildMilliseconds = elapsed.count();
+
+	m_Failed = 0;
+	for (const AtlasRegion& region : m_Atlas->GetRegions())
+	{
+		m_Failed += region.Page < 0 ? 1 : 0;
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+#include "test.h"
+#include "TextureAtlas.h"
+
+namespace test
+{
+	// Packs image files plus generated sprites into an atlas and shows the pages, their occupancy and the build time
+	class TestTextureAtlas : public Test
+	{
+	public:
+		TestTextureAtlas();
+
+		void OnImGuiRender() override;
+	private:
+		void Build();
+
+		char m_Filepaths[1024];
+		int m_GeneratedSprites;
+		TextureAtlasSettings m_Settings;
+		std::unique_ptr<TextureAtlas> m_Atlas;
+		double m_BuildMilliseconds;
+		int m_Failed;
+	};
+}
@@ -0,0 +1,145 @@
+#include "TestTextureCompression.h"
+#include "Renderer.h"
+#include "imgui/imgui.h"
+#include "stb_image/stb_image.h"
+
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+	// Mpixel/s of the encoder over a few iterations so the timing isn't dominated by the first touch of the output
+	double MeasureThroughput(const unsigned char* pixels, int width, int height, TextureCompression format,
+		unsigned int threadCount, int iterations)
+	{
+		const auto start = std::chrono::high_resolution_clock::now();
+		for (int i = 0; i < iterations; ++i)
+		{
+			TextureCompressor::Compress(pixels, width, height, format, threadCount);
+		}
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		return (double)width * height * iterations / elapsed.count() / 1000000.0;
+	}
+}
+
+test::TestTextureCompression::TestTextureCompression()
+	: m_Iterations(4), m_Width(0), m_Height(0)
+{
+	std::strcpy(m_Filepath, "res/textures/proteccTerra.png");
+}
+
+test::TestTextureCompression::~TestTextureCompression()
+{
+	ReleasePreviews();
+}
+
+void test::TestTextureCompression::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::InputText("Image", m_Filepath, sizeof(m_Filepath));
+	ImGui::SliderInt("Iterations", &m_Iterations, 1, 32);
+	if (ImGui::Button("Run"))
+	{
+		RunBenchmark();
+	}
+
+	if (m_Results.empty())
+	{
+		return;
+	}
+
+	ImGui::Text("%dx%d, RGBA8 is %u KB, %u hardware threads", m_Width, m_Height,
+		(unsigned int)m_Width * m_Height * 4 / 1024, std::thread::hardware_concurrency());
+	if (ImGui::BeginTable("Results", 5, ImGuiTableFlags_Borders))
+	{
+		ImGui::TableSetupColumn("Format");
+		ImGui::TableSetupColumn("PSNR (dB)");
+		ImGui::TableSetupColumn("1 thread (Mpix/s)");
+		ImGui::TableSetupColumn("All threads (Mpix/s)");
+		ImGui::TableSetupColumn("Size (KB)");
+		ImGui::TableHeadersRow();
+		for (const auto& result : m_Results)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%s", TextureCompressor::GetName(result.Format));
+			ImGui::TableNextColumn(); ImGui::Text("%.2f", result.PSNR);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", result.SingleThreadMPixels);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", result.MultiThreadMPixels);
+			ImGui::TableNextColumn(); ImGui::Text("%u", result.CompressedSize / 1024);
+		}
+		ImGui::EndTable();
+	}
+
+	const float previewWidth = 256.0f;
+	const float previewHeight = previewWidth * m_Height / m_Width;
+	for (const auto& result : m_Results)
+	{
+		if (result.PreviewID == 0)
+		{
+			continue;
+		}
+		ImGui::BeginGroup();
+		ImGui::Text("%s", TextureCompressor::GetName(result.Format));
+		ImGui::Image((ImTextureID)(intptr_t)result.PreviewID, ImVec2(previewWidth, previewHeight), ImVec2(0, 1), ImVec2(1, 0));
+		ImGui::EndGroup();
+		ImGui::SameLine();
+	}
+	ImGui::NewLine();
+}
+
+void test::TestTextureCompression::RunBenchmark()
+{
+	ReleasePreviews();
+	m_Results.clear();
+
+	int bpp = 0;
+	stbi_set_flip_vertically_on_load_thread(1);
+	unsigned char* pixels = stbi_load(m_Filepath, &m_Width, &m_Height, &bpp, 4);
+	if (!pixels)
+	{
+		return;
+	}
+
+	const TextureCompression formats[] = {
+		TextureCompression::BC1, TextureCompression::BC3, TextureCompression::BC4, TextureCompression::BC5
+	};
+	for (TextureCompression format : formats)
+	{
+		Result result = {};
+		result.Format = format;
+		result.SingleThreadMPixels = MeasureThroughput(pixels, m_Width, m_Height, format, 1, m_Iterations);
+		result.MultiThreadMPixels = MeasureThroughput(pixels, m_Width, m_Height, format, 0, m_Iterations);
+
+		std::vector<unsigned char> blocks = TextureCompressor::Compress(pixels, m_Width, m_Height, format);
+		std::vector<unsigned char> decoded = TextureCompressor::Decompress(blocks.data(), m_Width, m_Height, format);
+		result.PSNR = TextureCompressor::ComputePSNR(pixels, decoded.data(), m_Width, m_Height, format);
+		result.CompressedSize = (unsigned int)blocks.size();
+
+		if (TextureCompressor::IsSupported(format))
+		{
+			GlCall(glGenTextures(1, &result.PreviewID));
+			GlCall(glBindTexture(GL_TEXTURE_2D, result.PreviewID));
+			GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+			GlCall(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+			GlCall(glCompressedTexImage2D(GL_TEXTURE_2D, 0, TextureCompressor::GetGLInternalFormat(format),
+				m_Width, m_Height, 0, (GLsizei)blocks.size(), blocks.data()));
+			GlCall(glBindTexture(GL_TEXTURE_2D, 0));
+		}
+		m_Results.push_back(result);
+	}
+
+	stbi_image_free(pixels);
+}
+
+void test::TestTextureCompression::ReleasePreviews()
+{
+	for (auto& result : m_Results)
+	{
+		if (result.PreviewID)
+		{
+			GlCall(glDeleteTextures(1, &result.PreviewID));
+			result.PreviewID = 0;
+		}
+	}
+}
@@ -0,0 +1,34 @@
+#pragma once
+#include "test.h"
+#include "TextureCompressor.h"
+
+namespace test
+{
+	// Runs the block encoder over an image and reports quality (PSNR) and throughput for every format
+	class TestTextureCompression : public Test
+	{
+	public:
+		TestTextureCompression();
+		~TestTextureCompression();
+
+		void OnImGuiRender() override;
+	private:
+		struct Result
+		{
+			TextureCompression Format;
+			double PSNR;
+			double SingleThreadMPixels;
+			double MultiThreadMPixels;
+			unsigned int CompressedSize;
+			unsigned int PreviewID;
+		};
+
+		void RunBenchmark();
+		void ReleasePreviews();
+
+		char m_Filepath[256];
+		int m_Iterations;
+		int m_Width, m_Height;
+		std::vector<Result> m_Results;
+	};
+}
@@ -0,0 +1,163 @@
+#include "TestVirtualTexture.h"
+#include "Renderer.h"
+#include "VertexBufferLayout.h"
+#include "glm/gtc/matrix_transform.hpp"
+#include "imgui/imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	const int PageSizes[] = { 64, 128, 256 };
+	const char* PageSizeNames = "64\0" "128\0" "256\0";
+
+	// Concentric rings over a gradient with a grid every 1024 pixels, enough structure to see every mip level
+	void GenerateRow(int size, int row, unsigned char* rgba)
+	{
+		const float center = size * 0.5f;
+		for (int x = 0; x < size; ++x)
+		{
+			const float dx = x - center, dy = row - center;
+			const float distance = std::sqrt(dx * dx + dy * dy);
+			const bool grid = (x % 1024) < 8 || (row % 1024) < 8;
+			const bool ring = ((int)distance / 64) % 2 == 0;
+			rgba[x * 4 + 0] = grid ? 255 : (unsigned char)(x * 255 / size);
+			rgba[x * 4 + 1] = grid ? 255 : (unsigned char)(ring ? 180 : 60);
+			rgba[x * 4 + 2] = grid ? 255 : (unsigned char)(row * 255 / size);
+			rgba[x * 4 + 3] = 255;
+		}
+	}
+}
+
+test::TestVirtualTexture::TestVirtualTexture()
+	: m_GeneratedSize(20000), m_PageSizeIndex(1), m_CachePagesPerSide(16), m_Center{ 0.0f, 0.0f }, m_Zoom(0.05f)
+{
+	std::strcpy(m_SourcePath, "res/textures/proteccTerra.png");
+	std::strcpy(m_PageFilePath, "res/textures/virtual.vt");
+
+	const unsigned int indices[] = { 0, 1, 2, 2, 3, 0 };
+	m_IndexBuffer.reset(new IndexBuffer(indices, 6));
+}
+
+void test::TestVirtualTexture::Load()
+{
+	m_Texture.reset(new VirtualTexture(m_PageFilePath, (unsigned int)m_CachePagesPerSide));
+	if (!m_Texture->IsValid())
+	{
+		m_Texture.reset();
+		m_Status = "Couldn't open the page file";
+		return;
+	}
+
+	const float width = (float)m_Texture->GetWidth(), height = (float)m_Texture->GetHeight();
+	const float positions[] = {
+		0.0f,  0.0f,   0.0f, 0.0f,
+		width, 0.0f,   1.0f, 0.0f,
+		width, height, 1.0f, 1.0f,
+		0.0f,  height, 0.0f, 1.0f
+	};
+	m_VertexArray.reset(new VertexArray());
+	m_VertexBuffer.reset(new VertexBuffer(positions, sizeof(positions)));
+	VertexBufferLayout layout;
+	layout.Push<float>(2);
+	layout.Push<float>(2);
+	m_VertexArray->AddBuffer(*m_VertexBuffer, layout);
+
+	m_Center[0] = width * 0.5f;
+	m_Center[1] = height * 0.5f;
+	m_Zoom = std::min(1920.0f / width, 1080.0f / height);
+}
+
+void test::TestVirtualTexture::OnRender()
+{
+	Test::OnRender();
+	if (!m_Texture)
+	{
+		return;
+	}
+
+	// drag with the left button to pan, the wheel zooms around the window center
+	ImGuiIO& io = ImGui::GetIO();
+	if (!io.WantCaptureMouse)
+	{
+		if (io.MouseDown[0])
+		{
+			m_Center[0] -= io.MouseDelta.x / m_Zoom;
+			m_Center[1] += io.MouseDelta.y / m_Zoom;
+		}
+		m_Zoom *= std::pow(1.2f, io.MouseWheel);
+	}
+
+	const glm::mat4 proj = glm::ortho(0.0f, 1920.0f, 0.0f, 1080.0f, -1.0f, 1.0f);
+	const glm::mat4 model = glm::scale(
+		glm::translate(glm::mat4(1.0f), glm::vec3(960.0f - m_Center[0] * m_Zoom, 540.0f - m_Center[1] * m_Zoom, 0.0f)),
+		glm::vec3(m_Zoom, m_Zoom, 1.0f));
+	const glm::mat4 mvp = proj * model;
+
+	Renderer renderer;
+	m_Texture->Update();
+	renderer.Draw(*m_VertexArray, *m_IndexBuffer, m_Texture->BeginFeedback(mvp));
+	m_Texture->EndFeedback();
+	renderer.Draw(*m_VertexArray, *m_IndexBuffer, m_Texture->Bind(mvp));
+}
+
+void test::TestVirtualTexture::OnImGuiRender()
+{
+	Test::OnImGuiRender();
+	ImGui::InputText("Source image", m_SourcePath, sizeof(m_SourcePath));
+	ImGui::InputText("Page file", m_PageFilePath, sizeof(m_PageFilePath));
+	ImGui::Combo("Page size", &m_PageSizeIndex, PageSizeNames);
+	ImGui::SliderInt("Generated size", &m_GeneratedSize, 1024, 65536);
+
+	VirtualTextureTilerSettings settings;
+	settings.PageSize = PageSizes[m_PageSizeIndex];
+	if (ImGui::Button("Tile source"))
+	{
+		m_Texture.reset();
+		const auto start = std::chrono::high_resolution_clock::now();
+		const bool built = VirtualTextureTiler::BuildFromFile(m_SourcePath, m_PageFilePath, settings);
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		m_Status = built ? "Tiled in " + std::to_string(elapsed.count()) + " s" : "Tiling failed";
+	}
+	ImGui::SameLine();
+	if (ImGui::Button("Tile generated"))
+	{
+		m_Texture.reset();
+		const int size = m_GeneratedSize;
+		const auto start = std::chrono::high_resolution_clock::now();
+		const bool built = VirtualTextureTiler::Build(m_PageFilePath, size, size,
+			[size](int row, unsigned char* rgba) { GenerateRow(size, row, rgba); }, settings);
+		const std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+		m_Status = built ? "Tiled in " + std::to_string(elapsed.count()) + " s" : "Tiling failed";
+	}
+
+	ImGui::SliderInt("Cache pages per side", &m_CachePagesPerSide, 2, 32);
+	if (ImGui::Button("Load"))
+	{
+		Load();
+	}
+	if (!m_Status.empty())
+	{
+		ImGui::TextUnformatted(m_Status.c_str());
+	}
+	if (!m_Texture)
+	{
+		return;
+	}
+
+	int maxTextureSize = 0;
+	GlCall(glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize));
+	ImGui::Text("%dx%d image, GL_MAX_TEXTURE_SIZE is %d", m_Texture->GetWidth(), m_Texture->GetHeight(), maxTextureSize);
+	ImGui::SliderFloat("Zoom", &m_Zoom, 0.001f, 16.0f, "%.4f", ImGuiSliderFlags_Logarithmic);
+
+	const VirtualTextureStats stats = m_Texture->GetStats();
+	ImGui::Text("%u / %u pages resident, %u requested, %u loading, %u uploaded this frame", stats.ResidentPages,
+		stats.CachePages, stats.RequestedPages, stats.PendingLoads, stats.UploadsLastUpdate);
+	ImGui::Text("%u evictions, %u loads dropped because every page was in use", stats.Evictions, stats.DroppedLoads);
+	ImGui::Text("GPU memory: %.1f MB physical cache, %.1f KB page table", stats.PhysicalCacheBytes / 1048576.0,
+		stats.PageTableBytes / 1024.0);
+	ImGui::Image((ImTextureID)(intptr_t)m_Texture->GetPhysicalCacheID(), ImVec2(256, 256), ImVec2(0, 1), ImVec2(1, 0));
+}
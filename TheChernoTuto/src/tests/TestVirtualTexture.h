@@ -0,0 +1,38 @@
+#pragma once
+#include "test.h"
+#include "IndexBuffer.h"
+#include "VertexArray.h"
+#include "VertexBuffer.h"
+#include "VirtualTexture.h"
+
+#include <memory>
+
+namespace test
+{
+	// Tiles an image file (or a generated one larger than GL_MAX_TEXTURE_SIZE) and pans / zooms over it
+	class TestVirtualTexture : public Test
+	{
+	public:
+		TestVirtualTexture();
+
+		void OnRender() override;
+		void OnImGuiRender() override;
+	private:
+		void Load();
+
+		char m_SourcePath[256];
+		char m_PageFilePath[256];
+		int m_GeneratedSize;
+		int m_PageSizeIndex;
+		int m_CachePagesPerSide;
+		std::string m_Status;
+
+		std::unique_ptr<VirtualTexture> m_Texture;
+		std::unique_ptr<VertexArray> m_VertexArray;
+		std::unique_ptr<VertexBuffer> m_VertexBuffer;
+		std::unique_ptr<IndexBuffer> m_IndexBuffer;
+		// image texel shown at the center of the window and screen pixels per image texel
+		float m_Center[2];
+		float m_Zoom;
+	};
+}
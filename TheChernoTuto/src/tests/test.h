@@ -1,14 +1,36 @@
 #pragma once
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
 namespace test
 {
 	class Test
 	{
 	public:
-		Test();
+		Test(){}
 		virtual ~Test(){}
 
 		virtual void OnUpdate(float deltaTime){}
 		virtual void OnRender(){}
 		virtual void OnImGuiRender(){}
 	};
+
+	class TestMenu : public Test
+	{
+	public:
+		TestMenu(Test*& currentTestPointer);
+
+		void OnImGuiRender() override;
+
+		template<typename T>
+		void RegisterTest(const std::string& name)
+		{
+			m_Tests.push_back(std::make_pair(name, []() { return new T(); }));
+		}
+	private:
+		Test*& m_CurrentTest;
+		std::vector<std::pair<std::string, std::function<Test*()>>> m_Tests;
+	};
 }